@@ -0,0 +1,188 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/Logger.h"
+
+#include "BenchEnvironment.h"
+#include "Daemon.h"
+#include "SerialNumberCache.h"
+#include "StorageService.h"
+#include "framework/ConfigurationValidator.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi::Bench {
+
+	static Dataset Data_;
+
+	const Dataset &Data() { return Data_; }
+
+	const std::string &APConfiguration() {
+		static const std::string Configuration = R"lit({
+			"uuid": 2,
+			"radios": [
+				{ "band": "2G", "channel": "auto", "channel-mode": "HE", "channel-width": 40, "country": "US", "tx-power": 23 },
+				{ "band": "5G", "channel": 36, "channel-mode": "HE", "channel-width": 80, "country": "US" }
+			],
+			"interfaces": [
+				{
+					"name": "WAN", "role": "upstream", "services": [ "lldp" ],
+					"ethernet": [ { "select-ports": [ "WAN*" ] } ],
+					"ipv4": { "addressing": "dynamic" },
+					"ssids": [
+						{
+							"name": "OpenWifi", "wifi-bands": [ "2G", "5G" ], "bss-mode": "ap",
+							"encryption": { "proto": "psk2", "key": "OpenWifi", "ieee80211w": "optional" }
+						}
+					]
+				}
+			],
+			"metrics": {
+				"statistics": { "interval": 120, "types": [ "ssids", "lldp", "clients" ] },
+				"health": { "interval": 120 }
+			},
+			"services": {
+				"lldp": { "describe": "uCentral", "location": "universe" },
+				"ssh": { "port": 22 }
+			}
+		})lit";
+		return Configuration;
+	}
+
+	//	Each top level section of the sample becomes its own configuration element, the way
+	//	configurations are usually split in the UI.
+	static ProvObjects::DeviceConfiguration MakeConfiguration(const std::string &Name) {
+		ProvObjects::DeviceConfiguration C;
+		C.info.id = MicroServiceCreateUUID();
+		C.info.name = Name;
+		C.info.created = C.info.modified = Utils::Now();
+		C.deviceTypes.emplace_back("*");
+
+		Poco::JSON::Parser P;
+		auto Sample = P.parse(APConfiguration()).extract<Poco::JSON::Object::Ptr>();
+		uint64_t Weight = 0;
+		for (const auto &Section : {"radios", "interfaces", "metrics", "services"}) {
+			Poco::JSON::Object Element;
+			Element.set(Section, Sample->get(Section));
+			std::ostringstream OS;
+			Element.stringify(OS);
+			ProvObjects::DeviceConfigurationElement E;
+			E.name = Section;
+			E.weight = Weight++;
+			E.configuration = OS.str();
+			C.configuration.emplace_back(E);
+		}
+		return C;
+	}
+
+	static void Seed(std::uint64_t Scale) {
+		auto Now = Utils::Now();
+		auto &Storage = *StorageService();
+
+		for (std::uint64_t e = 0; e < 10 * Scale; ++e) {
+			auto Config = MakeConfiguration(fmt::format("entity-config-{}", e));
+			Storage.ConfigurationDB().CreateRecord(Config);
+			Data_.Configurations.emplace_back(Config.info.id);
+
+			ProvObjects::Entity E;
+			E.info.id = MicroServiceCreateUUID();
+			E.info.name = fmt::format("entity-{}", e);
+			E.info.created = E.info.modified = Now;
+			E.parent = EntityDB::RootUUID();
+			E.configurations.emplace_back(Config.info.id);
+			Storage.EntityDB().CreateRecord(E);
+			Data_.Entities.emplace_back(E.info.id);
+		}
+
+		for (std::uint64_t v = 0; v < 100 * Scale; ++v) {
+			auto Config = MakeConfiguration(fmt::format("venue-config-{}", v));
+			Storage.ConfigurationDB().CreateRecord(Config);
+			Data_.Configurations.emplace_back(Config.info.id);
+
+			ProvObjects::Venue V;
+			V.info.id = MicroServiceCreateUUID();
+			V.info.name = fmt::format("venue-{}", v);
+			V.info.created = V.info.modified = Now;
+			V.entity = Data_.Entities[v % Data_.Entities.size()];
+			V.configurations.emplace_back(Config.info.id);
+			Storage.VenueDB().CreateRecord(V);
+			Data_.Venues.emplace_back(V.info.id);
+		}
+
+		for (std::uint64_t d = 0; d < 1000 * Scale; ++d) {
+			ProvObjects::InventoryTag T;
+			T.info.id = MicroServiceCreateUUID();
+			T.serialNumber = fmt::format("{:012x}", 0x903cb3000000ULL + d * 7919);
+			T.info.name = T.serialNumber;
+			T.info.created = T.info.modified = Now;
+			T.deviceType = Data_.DeviceType;
+			T.venue = Data_.Venues[d % Data_.Venues.size()];
+			Storage.InventoryDB().CreateRecord(T);
+			SerialNumberCache()->AddSerialNumber(T.serialNumber, T.deviceType);
+			Data_.SerialNumbers.emplace_back(T.serialNumber);
+		}
+	}
+
+	void Setup(std::uint64_t Scale) {
+		auto App = Daemon();
+		auto &Config = App->config();
+		Config.setString("storage.type", "sqlite");
+		Config.setString("storage.type.sqlite.db", "file:owprov_bench?mode=memory&cache=shared");
+		Config.setBool("ucentral.datamodel.internal", true);
+		Poco::Logger::root().setLevel(Poco::Message::PRIO_ERROR);
+
+		for (auto SubSystem : std::vector<SubSystemServer *>{StorageService(), ConfigurationValidator(),
+															 SerialNumberCache()}) {
+			SubSystem->initialize(*App);
+			SubSystem->Start();
+		}
+		Seed(Scale);
+		std::cerr << fmt::format("Seeded {} entities, {} venues, {} devices.", Data_.Entities.size(),
+								 Data_.Venues.size(), Data_.SerialNumbers.size())
+				  << std::endl;
+	}
+
+	const std::vector<std::string> &APIPaths() {
+		static const std::vector<std::string> Paths = [] {
+			std::vector<std::string> Result;
+			std::ifstream In(OWPROV_OPENAPI_FILE);
+			std::string Line;
+			bool InPaths = false;
+			while (std::getline(In, Line)) {
+				if (Line == "paths:") {
+					InPaths = true;
+					continue;
+				}
+				if (!InPaths)
+					continue;
+				if (!Line.empty() && Line[0] != ' ')
+					break;
+				//	A path entry is indented by exactly two spaces: "  /venue/{id}:"
+				if (Line.size() > 3 && Line.compare(0, 3, "  /") == 0 && Line.back() == ':') {
+					auto Path = Line.substr(2, Line.size() - 3);
+					std::string Concrete{"/api/v1"};
+					for (std::size_t i = 0; i < Path.size(); ++i) {
+						if (Path[i] == '{') {
+							Concrete += "3f1c7d4e-5e3b-4e7a-9c5d-2b8f1e6a9d10";
+							i = Path.find('}', i);
+						} else {
+							Concrete += Path[i];
+						}
+					}
+					Result.emplace_back(Concrete);
+				}
+			}
+			return Result;
+		}();
+		return Paths;
+	}
+
+} // namespace OpenWifi::Bench
@@ -0,0 +1,34 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OpenWifi::Bench {
+
+	//	Synthetic data set seeded in an in-memory SQLite database. One unit of scale is
+	//	10 entities, 100 venues and 1000 devices.
+	struct Dataset {
+		std::vector<std::string> Entities;
+		std::vector<std::string> Venues;
+		std::vector<std::string> Configurations;
+		std::vector<std::string> SerialNumbers;
+		std::string DeviceType{"edgecore_eap101"};
+	};
+
+	//	Starts the storage and validation subsystems against the in-memory database and seeds
+	//	it. Must run before any benchmark.
+	void Setup(std::uint64_t Scale);
+	const Dataset &Data();
+
+	//	A complete AP configuration, valid against the built-in schema.
+	const std::string &APConfiguration();
+
+	//	Request paths built from openapi/owprov.yaml, with sample values for the parameters.
+	const std::vector<std::string> &APIPaths();
+
+} // namespace OpenWifi::Bench
@@ -0,0 +1,223 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+
+#include "benchmark/benchmark.h"
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/Logger.h"
+
+#include "APConfig.h"
+#include "BenchEnvironment.h"
+#include "SerialNumberCache.h"
+#include "StorageService.h"
+#include "framework/CIDR.h"
+#include "framework/ConfigurationValidator.h"
+#include "framework/RESTAPI_ExtServer.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi::Bench {
+
+	//	Row conversion only: tuple to object, as done for every row a query returns.
+	static void BM_ORM_ConvertInventoryRow(benchmark::State &State) {
+		auto &DB = StorageService()->InventoryDB();
+		ProvObjects::InventoryTag Tag;
+		DB.GetRecord("serialNumber", Data().SerialNumbers.front(), Tag);
+		InventoryDBRecordType Row;
+		DB.Convert(Tag, Row);
+		for (auto _ : State) {
+			ProvObjects::InventoryTag Out;
+			DB.Convert(Row, Out);
+			benchmark::DoNotOptimize(Out);
+		}
+	}
+	BENCHMARK(BM_ORM_ConvertInventoryRow);
+
+	static void BM_ORM_ConvertVenueRow(benchmark::State &State) {
+		auto &DB = StorageService()->VenueDB();
+		ProvObjects::Venue Venue;
+		DB.GetRecord("id", Data().Venues.front(), Venue);
+		VenueDBRecordType Row;
+		DB.Convert(Venue, Row);
+		for (auto _ : State) {
+			ProvObjects::Venue Out;
+			DB.Convert(Row, Out);
+			benchmark::DoNotOptimize(Out);
+		}
+	}
+	BENCHMARK(BM_ORM_ConvertVenueRow);
+
+	//	A list page: query plus conversion of every row.
+	static void BM_ORM_InventoryPage(benchmark::State &State) {
+		auto &DB = StorageService()->InventoryDB();
+		for (auto _ : State) {
+			std::vector<ProvObjects::InventoryTag> Page;
+			DB.GetRecords(0, State.range(0), Page);
+			benchmark::DoNotOptimize(Page);
+		}
+		State.SetItemsProcessed(State.iterations() * State.range(0));
+	}
+	BENCHMARK(BM_ORM_InventoryPage)->Arg(100)->Arg(500);
+
+	static void BM_APConfig_Get(benchmark::State &State) {
+		const auto &SerialNumbers = Data().SerialNumbers;
+		std::size_t i = 0;
+		auto &Logger = Poco::Logger::get("BENCH");
+		for (auto _ : State) {
+			APConfig Config(SerialNumbers[i++ % SerialNumbers.size()], Data().DeviceType, Logger,
+							false);
+			Poco::JSON::Object::Ptr Configuration;
+			benchmark::DoNotOptimize(Config.Get(Configuration));
+		}
+	}
+	BENCHMARK(BM_APConfig_Get);
+
+	static void BM_ConfigurationValidator_Validate(benchmark::State &State) {
+		for (auto _ : State) {
+			std::string Errors;
+			benchmark::DoNotOptimize(ConfigurationValidator()->Validate(
+				ConfigurationValidator::ConfigurationType::AP, APConfiguration(), Errors, true));
+		}
+	}
+	BENCHMARK(BM_ConfigurationValidator_Validate);
+
+	static void BM_SerialNumberCache_FindNumbers(benchmark::State &State) {
+		const auto &SerialNumbers = Data().SerialNumbers;
+		std::size_t i = 0;
+		for (auto _ : State) {
+			std::vector<uint64_t> Found;
+			SerialNumberCache()->FindNumbers(
+				SerialNumbers[i++ % SerialNumbers.size()].substr(0, State.range(0)), 20, Found);
+			benchmark::DoNotOptimize(Found);
+		}
+	}
+	BENCHMARK(BM_SerialNumberCache_FindNumbers)->Arg(4)->Arg(8);
+
+	static void BM_CIDR_IpInRanges(benchmark::State &State) {
+		Types::StringVec Ranges;
+		for (int i = 0; i < State.range(0); ++i)
+			Ranges.emplace_back(fmt::format("10.{}.0.0/16", i));
+		std::mt19937 Random(42);
+		std::vector<std::string> IPs;
+		for (int i = 0; i < 256; ++i)
+			IPs.emplace_back(fmt::format("10.{}.{}.{}", Random() % 256, Random() % 256,
+										 Random() % 256));
+		std::size_t i = 0;
+		for (auto _ : State) {
+			benchmark::DoNotOptimize(CIDR::IpInRanges(IPs[i++ % IPs.size()], Ranges));
+		}
+	}
+	BENCHMARK(BM_CIDR_IpInRanges)->Arg(8)->Arg(64);
+
+	template <typename T> static T Load();
+	template <> ProvObjects::InventoryTag Load() {
+		ProvObjects::InventoryTag R;
+		StorageService()->InventoryDB().GetRecord("serialNumber", Data().SerialNumbers.front(), R);
+		return R;
+	}
+	template <> ProvObjects::Venue Load() {
+		ProvObjects::Venue R;
+		StorageService()->VenueDB().GetRecord("id", Data().Venues.front(), R);
+		return R;
+	}
+	template <> ProvObjects::DeviceConfiguration Load() {
+		ProvObjects::DeviceConfiguration R;
+		StorageService()->ConfigurationDB().GetRecord("id", Data().Configurations.front(), R);
+		return R;
+	}
+
+	template <typename T> static void BM_RESTObjects_to_json(benchmark::State &State) {
+		auto Object = Load<T>();
+		for (auto _ : State) {
+			Poco::JSON::Object Obj;
+			Object.to_json(Obj);
+			std::ostringstream OS;
+			Obj.stringify(OS);
+			benchmark::DoNotOptimize(OS.str());
+		}
+	}
+	BENCHMARK_TEMPLATE(BM_RESTObjects_to_json, ProvObjects::InventoryTag);
+	BENCHMARK_TEMPLATE(BM_RESTObjects_to_json, ProvObjects::Venue);
+	BENCHMARK_TEMPLATE(BM_RESTObjects_to_json, ProvObjects::DeviceConfiguration);
+
+	template <typename T> static void BM_RESTObjects_from_json(benchmark::State &State) {
+		Poco::JSON::Object Obj;
+		Load<T>().to_json(Obj);
+		std::ostringstream OS;
+		Obj.stringify(OS);
+		auto Body = OS.str();
+		for (auto _ : State) {
+			Poco::JSON::Parser P;
+			auto Parsed = P.parse(Body).extract<Poco::JSON::Object::Ptr>();
+			T Object;
+			benchmark::DoNotOptimize(Object.from_json(Parsed));
+		}
+	}
+	BENCHMARK_TEMPLATE(BM_RESTObjects_from_json, ProvObjects::InventoryTag);
+	BENCHMARK_TEMPLATE(BM_RESTObjects_from_json, ProvObjects::Venue);
+	BENCHMARK_TEMPLATE(BM_RESTObjects_from_json, ProvObjects::DeviceConfiguration);
+
+	//	Every path of the public API, resolved and dispatched to its handler.
+	static void BM_RESTAPI_ExtRouter(benchmark::State &State) {
+		const auto &Paths = APIPaths();
+		if (Paths.empty()) {
+			State.SkipWithError("No paths found in " OWPROV_OPENAPI_FILE);
+			return;
+		}
+		auto &Logger = Poco::Logger::get("BENCH");
+		RESTAPI_GenericServerAccounting Server;
+		uint64_t TransactionId = 0;
+		for (auto _ : State) {
+			RESTAPIHandler::BindingMap Bindings;
+			std::unique_ptr<Poco::Net::HTTPRequestHandler> Handler(RESTAPI_ExtRouter(
+				Paths[TransactionId % Paths.size()], Bindings, Logger, Server, TransactionId));
+			++TransactionId;
+			benchmark::DoNotOptimize(Handler.get());
+		}
+		State.counters["paths"] = (double)Paths.size();
+	}
+	BENCHMARK(BM_RESTAPI_ExtRouter);
+
+} // namespace OpenWifi::Bench
+
+//	Accepts --scale=N (or OWPROV_BENCH_SCALE) for the size of the seeded data set. Results are
+//	written as JSON to owprov_bench.json unless --benchmark_out is given.
+int main(int argc, char **argv) {
+	std::uint64_t Scale = 1;
+	if (auto Env = std::getenv("OWPROV_BENCH_SCALE"); Env != nullptr)
+		Scale = std::strtoull(Env, nullptr, 10);
+
+	std::vector<char *> Args;
+	bool HasOutput = false;
+	for (int i = 0; i < argc; ++i) {
+		std::string Arg(argv[i]);
+		if (Arg.rfind("--scale=", 0) == 0) {
+			Scale = std::strtoull(Arg.c_str() + 8, nullptr, 10);
+			continue;
+		}
+		if (Arg.rfind("--benchmark_out=", 0) == 0)
+			HasOutput = true;
+		Args.push_back(argv[i]);
+	}
+	std::string Output{"--benchmark_out=owprov_bench.json"}, Format{"--benchmark_out_format=json"};
+	if (!HasOutput) {
+		Args.push_back(Output.data());
+		Args.push_back(Format.data());
+	}
+
+	int ArgCount = (int)Args.size();
+	benchmark::Initialize(&ArgCount, Args.data());
+	if (benchmark::ReportUnrecognizedArguments(ArgCount, Args.data()))
+		return 1;
+	OpenWifi::Bench::Setup(std::max<std::uint64_t>(1, Scale));
+	benchmark::AddCustomContext("scale", std::to_string(Scale));
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,261 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/StringTokenizer.h"
+#include "Poco/URI.h"
+
+#include "AutoDiscovery.h"
+#include "LoadGenerator.h"
+#include "framework/KafkaManager.h"
+#include "framework/KafkaTopics.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/OpenAPIClientPool.h"
+#include "framework/ow_constants.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi::LoadGen {
+
+	static const std::vector<std::string> DefaultRestPaths{
+		"/inventory/{serial}", "/inventory/{serial}?config=true",
+		"/inventory/{serial}?applyConfiguration=true", "/inventory?offset=0&limit=100",
+		"/venue?offset=0&limit=100"};
+
+	void Settings::Load(const StandIn::Options &O) {
+		Via = O.Get("", "via", Via);
+		ConnectRate = std::strtod(O.Get("", "connect.rate", std::to_string(ConnectRate)).c_str(), nullptr);
+		PingRatio = std::strtod(O.Get("", "ping.ratio", std::to_string(PingRatio)).c_str(), nullptr);
+		Devices = std::max<std::uint64_t>(1, O.GetInt("", "devices", Devices));
+		DeviceType = O.Get("", "devicetype", DeviceType);
+		RestRate = std::strtod(O.Get("", "rest.rate", std::to_string(RestRate)).c_str(), nullptr);
+		RestThreads = std::max<std::uint64_t>(1, O.GetInt("", "rest.threads", RestThreads));
+		Token = O.Get("", "token", Token);
+		Duration = O.GetInt("", "duration", Duration);
+		DrainTimeout = O.GetInt("", "drain.timeout", DrainTimeout);
+		auto Paths = O.Get("", "rest.paths", "");
+		if (Paths.empty()) {
+			RestPaths = DefaultRestPaths;
+		} else {
+			Poco::StringTokenizer T(Paths, ",", Poco::StringTokenizer::TOK_TRIM |
+													Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+			RestPaths.assign(T.begin(), T.end());
+		}
+	}
+
+	//	Smallest recorded bucket bound below which a fraction Q of the values fall, in ms.
+	static double Quantile(const MetricsHistogram &H, double Q) {
+		auto Count = H.Count();
+		if (Count == 0)
+			return 0.0;
+		auto Target = (std::uint64_t)std::ceil(Q * (double)Count);
+		std::uint64_t Cumulative = 0;
+		for (std::size_t i = 0; i < MetricsHistogram::Buckets; ++i) {
+			Cumulative += H.BucketCount(i);
+			if (Cumulative >= Target)
+				return (double)MetricsHistogram::UpperBound(i) / 1000.0;
+		}
+		return (double)MetricsHistogram::UpperBound(MetricsHistogram::Buckets - 1) / 1000.0;
+	}
+
+	void Counters::to_json(Poco::JSON::Object &Obj, double Seconds) const {
+		Obj.set("sent", Sent.load());
+		Obj.set("rate", Seconds > 0.0 ? (double)Sent.load() / Seconds : 0.0);
+		Obj.set("ok", Ok.load());
+		Obj.set("clientErrors", ClientErrors.load());
+		Obj.set("serverErrors", ServerErrors.load());
+		Obj.set("failures", Failures.load());
+		if (Latency.Count() > 0) {
+			Poco::JSON::Object L;
+			L.set("mean", (double)Latency.Sum() / (double)Latency.Count() / 1000.0);
+			L.set("p50", Quantile(Latency, 0.50));
+			L.set("p90", Quantile(Latency, 0.90));
+			L.set("p99", Quantile(Latency, 0.99));
+			L.set("p999", Quantile(Latency, 0.999));
+			L.set("max", Quantile(Latency, 1.0));
+			Obj.set("latencyMs", L);
+		}
+	}
+
+	bool LoadGenerator::WaitForService(const std::atomic_bool &Stopped,
+									   std::chrono::seconds Timeout) {
+		auto Deadline = std::chrono::steady_clock::now() + Timeout;
+		while (!Stopped && std::chrono::steady_clock::now() < Deadline) {
+			//	The REST servers start after every other subsystem: once they answer, so
+			//	does everything else.
+			if (!MicroServicePublicEndPoint().empty()) {
+				try {
+					Get("/system?command=info");
+					return true;
+				} catch (...) {
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		}
+		return false;
+	}
+
+	void LoadGenerator::Announce(const std::vector<std::string> &JoinEvents) {
+		for (const auto &Event : JoinEvents)
+			KafkaManager()->Deliver(KafkaTopics::SERVICE_EVENTS, "", Event);
+	}
+
+	std::string LoadGenerator::SerialNumber(std::uint64_t Device) const {
+		return fmt::format("{:012x}", 0x5e0000000000ULL + Device);
+	}
+
+	std::string LoadGenerator::ConnectionMessage(std::uint64_t Device, bool Ping) const {
+		Poco::JSON::Object Payload, System, Message;
+		auto SN = SerialNumber(Device);
+		auto IP = fmt::format("10.{}.{}.{}:{}", (Device >> 16) & 0xff, (Device >> 8) & 0xff,
+							  Device & 0xff, 40000 + Device % 20000);
+		if (Ping) {
+			Poco::JSON::Object P;
+			P.set(uCentralProtocol::SERIALNUMBER, SN);
+			P.set(uCentralProtocol::FIRMWARE, "Stand-in 2.3");
+			P.set(uCentralProtocol::COMPATIBLE, Settings_.DeviceType);
+			P.set(uCentralProtocol::CONNECTIONIP, IP);
+			P.set("locale", "US");
+			Payload.set(uCentralProtocol::PING, P);
+		} else {
+			Poco::JSON::Object Capabilities;
+			Capabilities.set(uCentralProtocol::COMPATIBLE, Settings_.DeviceType);
+			Capabilities.set("platform", "ap");
+			Payload.set(uCentralProtocol::SERIAL, SN);
+			Payload.set(uCentralProtocol::FIRMWARE, "Stand-in 2.3");
+			Payload.set(uCentralProtocol::CONNECTIONIP, IP);
+			Payload.set("locale", "US");
+			Payload.set(uCentralProtocol::CAPABILITIES, Capabilities);
+		}
+		System.set("id", 1);
+		System.set("host", "loadgen");
+		Message.set("system", System);
+		Message.set(uCentralProtocol::PAYLOAD, Payload);
+		std::ostringstream OS;
+		Message.stringify(OS);
+		return OS.str();
+	}
+
+	void LoadGenerator::SendConnections(std::chrono::steady_clock::time_point Start,
+										std::chrono::steady_clock::time_point End,
+										const std::atomic_bool &Stopped) {
+		if (Settings_.ConnectRate <= 0.0)
+			return;
+		std::mt19937_64 Random(1);
+		std::uniform_real_distribution<double> Uniform(0.0, 1.0);
+		std::vector<bool> Connected(Settings_.Devices, false);
+		auto Interval = std::chrono::duration<double>(1.0 / Settings_.ConnectRate);
+		bool Kafka = Settings_.Via == "kafka";
+
+		for (std::uint64_t i = 0; !Stopped; ++i) {
+			auto When = Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+									Interval * (double)i);
+			if (When >= End)
+				break;
+			std::this_thread::sleep_until(When);
+
+			auto Device = Random() % Settings_.Devices;
+			bool Ping = Connected[Device] && Uniform(Random) < Settings_.PingRatio;
+			Connected[Device] = true;
+			auto Message = ConnectionMessage(Device, Ping);
+			auto Began = std::chrono::steady_clock::now();
+			if (Kafka)
+				KafkaManager()->Deliver(KafkaTopics::CONNECTION, SerialNumber(Device), Message);
+			else
+				AutoDiscovery()->ConnectionReceived(SerialNumber(Device), Message);
+			Connections_.Latency.Observe(std::chrono::steady_clock::now() - Began);
+			Connections_.Sent++;
+			Connections_.Ok++;
+		}
+	}
+
+	int LoadGenerator::Get(const std::string &Path) {
+		Poco::URI URI(MicroServiceGetPublicAPIEndPoint() + Path);
+		Poco::Net::HTTPRequest Request(Poco::Net::HTTPRequest::HTTP_GET, URI.getPathAndQuery(),
+									   Poco::Net::HTTPMessage::HTTP_1_1);
+		Request.add("Authorization", "Bearer " + Settings_.Token);
+		auto Session = OpenAPIClientPool::instance().Acquire(URI, 30000);
+		Session->sendRequest(Request);
+		Poco::Net::HTTPResponse Response;
+		auto &is = Session->receiveResponse(Response);
+		Session.Done(Response, is);
+		return Response.getStatus();
+	}
+
+	void LoadGenerator::SendRest(std::chrono::steady_clock::time_point Start,
+								 std::chrono::steady_clock::time_point End,
+								 std::atomic_uint64_t &Slot, const std::atomic_bool &Stopped) {
+		auto Interval = std::chrono::duration<double>(1.0 / Settings_.RestRate);
+		while (!Stopped) {
+			auto i = Slot++;
+			auto When = Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+									Interval * (double)i);
+			if (When >= End)
+				break;
+			std::this_thread::sleep_until(When);
+
+			auto Path = Settings_.RestPaths[i % Settings_.RestPaths.size()];
+			if (auto P = Path.find("{serial}"); P != std::string::npos)
+				Path.replace(P, 8, SerialNumber((i * 7919) % Settings_.Devices));
+			Rest_.Sent++;
+			try {
+				auto Status = Get(Path);
+				if (Status >= 500)
+					Rest_.ServerErrors++;
+				else if (Status >= 400)
+					Rest_.ClientErrors++;
+				else
+					Rest_.Ok++;
+			} catch (...) {
+				Rest_.Failures++;
+			}
+			Rest_.Latency.Observe(std::chrono::steady_clock::now() - When);
+		}
+	}
+
+	void LoadGenerator::Run(const std::atomic_bool &Stopped) {
+		auto Start = std::chrono::steady_clock::now();
+		auto End = Start + std::chrono::seconds(Settings_.Duration);
+
+		std::vector<std::thread> Workers;
+		std::atomic_uint64_t Slot{0};
+		Workers.emplace_back([&] { SendConnections(Start, End, Stopped); });
+		if (Settings_.RestRate > 0.0) {
+			for (std::uint64_t i = 0; i < Settings_.RestThreads; ++i)
+				Workers.emplace_back([&] { SendRest(Start, End, Slot, Stopped); });
+		}
+		for (auto &W : Workers)
+			W.join();
+		Elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		//	Connections are processed asynchronously: wait for the backlog to clear.
+		auto DrainStart = std::chrono::steady_clock::now();
+		auto DrainEnd = DrainStart + std::chrono::seconds(Settings_.DrainTimeout);
+		while (!Stopped && AutoDiscovery()->Pending() > 0 &&
+			   std::chrono::steady_clock::now() < DrainEnd)
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		Drain_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - DrainStart).count();
+		Undrained_ = AutoDiscovery()->Pending();
+	}
+
+	void LoadGenerator::to_json(Poco::JSON::Object &Obj) const {
+		Poco::JSON::Object C, R;
+		Connections_.to_json(C, Elapsed_);
+		C.set("via", Settings_.Via);
+		C.set("drainSeconds", Drain_);
+		C.set("undrained", Undrained_);
+		Rest_.to_json(R, Elapsed_);
+		Obj.set("seconds", Elapsed_);
+		Obj.set("connections", C);
+		Obj.set("rest", R);
+	}
+
+} // namespace OpenWifi::LoadGen
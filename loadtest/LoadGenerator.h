@@ -0,0 +1,82 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+
+#include "StandInServices.h"
+#include "framework/MetricsRegistry.h"
+
+namespace OpenWifi::LoadGen {
+
+	struct Settings {
+		std::string Via{"queue"}; //	queue: AutoDiscovery directly, kafka: through KafkaManager
+		double ConnectRate = 100.0;
+		double PingRatio = 0.8;
+		std::uint64_t Devices = 10000;
+		std::string DeviceType{"edgecore_eap101"};
+		double RestRate = 20.0;
+		std::uint64_t RestThreads = 8;
+		std::vector<std::string> RestPaths;
+		std::string Token{"loadgen"};
+		std::uint64_t Duration = 60;
+		std::uint64_t DrainTimeout = 120;
+
+		void Load(const StandIn::Options &O);
+	};
+
+	struct Counters {
+		MetricsHistogram Latency;
+		std::atomic_uint64_t Sent{0};
+		std::atomic_uint64_t Ok{0};
+		std::atomic_uint64_t ClientErrors{0};
+		std::atomic_uint64_t ServerErrors{0};
+		std::atomic_uint64_t Failures{0};
+
+		void to_json(Poco::JSON::Object &Obj, double Seconds) const;
+	};
+
+	//	Replays device connections and REST calls against the owprov running in this process.
+	//	Both streams are open loop: calls are scheduled at the requested rate and REST latency
+	//	is measured from the scheduled time, so a slow server shows up as latency instead of
+	//	as a lower rate.
+	class LoadGenerator {
+	  public:
+		explicit LoadGenerator(Settings S) : Settings_(std::move(S)) {}
+
+		//	Waits for the REST API to answer. Returns false on timeout or when Stopped is set.
+		bool WaitForService(const std::atomic_bool &Stopped, std::chrono::seconds Timeout);
+		//	Announces micro services to owprov, as their service_events join message would.
+		static void Announce(const std::vector<std::string> &JoinEvents);
+
+		void Run(const std::atomic_bool &Stopped);
+		void to_json(Poco::JSON::Object &Obj) const;
+
+	  private:
+		Settings Settings_;
+		Counters Connections_;
+		Counters Rest_;
+		double Elapsed_ = 0.0;
+		double Drain_ = 0.0;
+		std::uint64_t Undrained_ = 0;
+
+		void SendConnections(std::chrono::steady_clock::time_point Start,
+							 std::chrono::steady_clock::time_point End,
+							 const std::atomic_bool &Stopped);
+		void SendRest(std::chrono::steady_clock::time_point Start,
+					  std::chrono::steady_clock::time_point End, std::atomic_uint64_t &Slot,
+					  const std::atomic_bool &Stopped);
+		[[nodiscard]] std::string SerialNumber(std::uint64_t Device) const;
+		[[nodiscard]] std::string ConnectionMessage(std::uint64_t Device, bool Ping) const;
+		int Get(const std::string &Path);
+	};
+
+} // namespace OpenWifi::LoadGen
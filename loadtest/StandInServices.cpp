@@ -0,0 +1,333 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/StreamCopier.h"
+#include "Poco/StringTokenizer.h"
+#include "Poco/URI.h"
+
+#include "StandInServices.h"
+
+namespace OpenWifi::StandIn {
+
+	void Options::Parse(int argc, char **argv) {
+		for (int i = 1; i < argc; ++i) {
+			std::string Arg(argv[i]);
+			auto Equal = Arg.find('=');
+			if (Arg.empty() || Arg[0] == '-' || Equal == std::string::npos || Equal == 0)
+				continue;
+			Values_[Arg.substr(0, Equal)] = Arg.substr(Equal + 1);
+		}
+	}
+
+	std::string Options::Get(const std::string &Service, const std::string &Name,
+							 const std::string &Default) const {
+		if (auto Hint = Values_.find(Service + "." + Name); Hint != Values_.end())
+			return Hint->second;
+		if (auto Hint = Values_.find(Name); Hint != Values_.end())
+			return Hint->second;
+		return Default;
+	}
+
+	std::uint64_t Options::GetInt(const std::string &Service, const std::string &Name,
+								  std::uint64_t Default) const {
+		auto Value = Get(Service, Name, "");
+		return Value.empty() ? Default : std::strtoull(Value.c_str(), nullptr, 10);
+	}
+
+	Behaviour Options::Get(const std::string &Service) const {
+		Behaviour B;
+		B.Latency = GetInt(Service, "latency", 0);
+		B.Jitter = GetInt(Service, "jitter", 0);
+		B.ErrorRate = std::strtod(Get(Service, "errors", "0").c_str(), nullptr);
+		return B;
+	}
+
+	std::string JoinEvent(const std::string &Type, const std::string &EndPoint,
+						  const std::string &Key) {
+		Poco::JSON::Object Event;
+		Event.set("event", "join");
+		Event.set("id", std::hash<std::string>{}(EndPoint) % 1000000000ULL);
+		Event.set("type", Type);
+		Event.set("publicEndPoint", EndPoint);
+		Event.set("privateEndPoint", EndPoint);
+		Event.set("key", Key);
+		Event.set("version", "standin");
+		std::ostringstream OS;
+		Event.stringify(OS);
+		return OS.str();
+	}
+
+	class RequestHandler : public Poco::Net::HTTPRequestHandler {
+	  public:
+		explicit RequestHandler(Service &S) : Service_(S) {}
+
+		void handleRequest(Poco::Net::HTTPServerRequest &Request,
+						   Poco::Net::HTTPServerResponse &Response) override {
+			std::string Body;
+			Poco::StreamCopier::copyToString(Request.stream(), Body);
+
+			Poco::JSON::Object Answer;
+			int Status;
+			if (!Service_.Delay()) {
+				Status = Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE;
+				Answer.set("ErrorCode", Status);
+				Answer.set("ErrorDetails", Request.getURI());
+				Answer.set("ErrorDescription", "Injected error.");
+			} else {
+				try {
+					Status = Service_.Answer(Request.getMethod(), Poco::URI(Request.getURI()).getPath(),
+											 Request, Body, Answer);
+				} catch (const Poco::Exception &E) {
+					Status = Poco::Net::HTTPResponse::HTTP_BAD_REQUEST;
+					Answer.set("ErrorCode", Status);
+					Answer.set("ErrorDetails", E.displayText());
+				}
+			}
+
+			Response.setStatus((Poco::Net::HTTPResponse::HTTPStatus)Status);
+			Response.setKeepAlive(Request.getKeepAlive());
+			if (Status == Poco::Net::HTTPResponse::HTTP_NO_CONTENT) {
+				Response.setContentLength(0);
+				Response.send();
+				return;
+			}
+			std::ostringstream OS;
+			Answer.stringify(OS);
+			auto Text = OS.str();
+			Response.setContentType("application/json");
+			Response.setContentLength(Text.size());
+			Response.send() << Text;
+		}
+
+	  private:
+		Service &Service_;
+	};
+
+	class RequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory {
+	  public:
+		explicit RequestHandlerFactory(Service &S) : Service_(S) {}
+		Poco::Net::HTTPRequestHandler *
+		createRequestHandler([[maybe_unused]] const Poco::Net::HTTPServerRequest &R) override {
+			return new RequestHandler(Service_);
+		}
+
+	  private:
+		Service &Service_;
+	};
+
+	Service::Service(std::string Type, const Behaviour &B, std::string Host, std::uint16_t Port,
+					 std::string Key)
+		: Type_(std::move(Type)), Behaviour_(B), Host_(std::move(Host)), Port_(Port),
+		  Key_(std::move(Key)), Random_(std::random_device{}()) {}
+
+	Service::~Service() { Stop(); }
+
+	void Service::Start() {
+		auto Params = new Poco::Net::HTTPServerParams;
+		Params->setMaxThreads(64);
+		Params->setMaxQueued(1024);
+		Params->setKeepAlive(true);
+		Server_ = std::make_unique<Poco::Net::HTTPServer>(new RequestHandlerFactory(*this),
+														  Poco::Net::ServerSocket(Port_), Params);
+		Server_->start();
+	}
+
+	void Service::Stop() {
+		if (Server_) {
+			Server_->stopAll(true);
+			Server_.reset();
+		}
+	}
+
+	std::string Service::EndPoint() const {
+		return "http://" + Host_ + ":" + std::to_string(Port_);
+	}
+
+	bool Service::Delay() {
+		std::uint64_t Wait;
+		bool Fail;
+		{
+			std::lock_guard G(RandomMutex_);
+			Wait = Behaviour_.Latency + (Behaviour_.Jitter ? Random_() % (Behaviour_.Jitter + 1) : 0);
+			Fail = Behaviour_.ErrorRate > 0.0 &&
+				   std::uniform_real_distribution<double>(0.0, 1.0)(Random_) < Behaviour_.ErrorRate;
+		}
+		if (Wait)
+			std::this_thread::sleep_for(std::chrono::milliseconds(Wait));
+		return !Fail;
+	}
+
+	//	Path segments after /api/v1.
+	static std::vector<std::string> Segments(const std::string &Path) {
+		Poco::StringTokenizer T(Path, "/", Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+		std::vector<std::string> Result;
+		for (std::size_t i = 2; i < T.count(); ++i)
+			Result.emplace_back(T[i]);
+		return Result;
+	}
+
+	static std::string Parameter(const Poco::Net::HTTPServerRequest &Request,
+								 const std::string &Name) {
+		for (const auto &[Key, Value] : Poco::URI(Request.getURI()).getQueryParameters())
+			if (Key == Name)
+				return Value;
+		return "";
+	}
+
+	static std::uint64_t Now() {
+		return std::chrono::duration_cast<std::chrono::seconds>(
+				   std::chrono::system_clock::now().time_since_epoch())
+			.count();
+	}
+
+	int Gateway::Answer(const std::string &Method, const std::string &Path,
+						[[maybe_unused]] const Poco::Net::HTTPServerRequest &Request,
+						const std::string &Body, Poco::JSON::Object &Response) {
+		auto S = Segments(Path);
+		if (S.size() == 1 && S[0] == "radiusProxyConfig") {
+			std::lock_guard G(Mutex_);
+			if (Method == Poco::Net::HTTPRequest::HTTP_PUT)
+				RadiusProxyConfig_ = Body;
+			else if (Method != Poco::Net::HTTPRequest::HTTP_GET)
+				return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+			Poco::JSON::Parser P;
+			auto Config = P.parse(RadiusProxyConfig_).extract<Poco::JSON::Object::Ptr>();
+			for (const auto &[Key, Value] : *Config)
+				Response.set(Key, Value);
+			return Poco::Net::HTTPResponse::HTTP_OK;
+		}
+
+		if (S.size() < 2 || S[0] != "device")
+			return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+
+		Response.set("serialNumber", S[1]);
+		if (S.size() == 2)
+			return Poco::Net::HTTPResponse::HTTP_OK;
+
+		//	A device command that completes at once.
+		if (Method != Poco::Net::HTTPRequest::HTTP_POST)
+			return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+		Poco::JSON::Object Status;
+		Status.set("error", 0);
+		Status.set("text", "Success");
+		Poco::JSON::Object Results;
+		Results.set("serial", S[1]);
+		Results.set("status", Status);
+		Response.set("command", S[2]);
+		Response.set("UUID", std::to_string(Now()) + "-" + S[1]);
+		Response.set("errorCode", 0);
+		Response.set("errorText", "");
+		Response.set("status", "completed");
+		Response.set("completed", Now());
+		Response.set("results", Results);
+		return Poco::Net::HTTPResponse::HTTP_OK;
+	}
+
+	static Poco::JSON::Object::Ptr MakeFirmware(const std::string &DeviceType, int Index,
+												bool Latest) {
+		auto F = Poco::makeShared<Poco::JSON::Object>();
+		auto Revision = "Stand-in " + DeviceType + " 2." + std::to_string(Index);
+		F->set("id", "standin-" + DeviceType + "-" + std::to_string(Index));
+		F->set("deviceType", DeviceType);
+		F->set("revision", Revision);
+		F->set("release", "standin");
+		F->set("description", Revision);
+		F->set("image", DeviceType + "-2." + std::to_string(Index) + ".bin");
+		F->set("uri", "http://localhost/firmware/" + DeviceType + "-2." + std::to_string(Index) +
+						  ".bin");
+		F->set("imageDate", 1700000000 + Index * 86400);
+		F->set("created", 1700000000 + Index * 86400);
+		F->set("size", 16 * 1024 * 1024);
+		F->set("latest", Latest);
+		return F;
+	}
+
+	int Firmware::Answer(const std::string &Method, const std::string &Path,
+						 const Poco::Net::HTTPServerRequest &Request,
+						 [[maybe_unused]] const std::string &Body, Poco::JSON::Object &Response) {
+		static constexpr int Revisions = 4;
+		auto S = Segments(Path);
+		if (Method != Poco::Net::HTTPRequest::HTTP_GET || S.size() != 1 || S[0] != "firmwares")
+			return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+
+		auto DeviceType = Parameter(Request, "deviceType");
+		if (DeviceType.empty())
+			DeviceType = "generic";
+		if (Parameter(Request, "latestOnly") == "true") {
+			auto Latest = MakeFirmware(DeviceType, Revisions - 1, true);
+			for (const auto &[Key, Value] : *Latest)
+				Response.set(Key, Value);
+			return Poco::Net::HTTPResponse::HTTP_OK;
+		}
+		Poco::JSON::Array Firmwares;
+		for (int i = 0; i < Revisions; ++i)
+			Firmwares.add(MakeFirmware(DeviceType, i, i == Revisions - 1));
+		Response.set("firmwares", Firmwares);
+		return Poco::Net::HTTPResponse::HTTP_OK;
+	}
+
+	static Poco::JSON::Object::Ptr MakeUser(const std::string &Id, const std::string &Role) {
+		auto U = Poco::makeShared<Poco::JSON::Object>();
+		U->set("id", Id);
+		U->set("name", "Stand-in " + Role);
+		U->set("email", Id + "@standin.local");
+		U->set("userRole", Role);
+		U->set("validated", true);
+		return U;
+	}
+
+	int Security::Answer(const std::string &Method, const std::string &Path,
+						 const Poco::Net::HTTPServerRequest &Request,
+						 [[maybe_unused]] const std::string &Body, Poco::JSON::Object &Response) {
+		auto S = Segments(Path);
+		if (S.empty())
+			return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+
+		if (Method == Poco::Net::HTTPRequest::HTTP_GET &&
+			(S[0] == "validateToken" || S[0] == "validateSubToken" || S[0] == "validateApiKey")) {
+			auto Token = Parameter(Request, S[0] == "validateApiKey" ? "apikey" : "token");
+			auto Sub = S[0] == "validateSubToken";
+			Poco::JSON::Object TokenInfo;
+			TokenInfo.set("access_token", Token);
+			TokenInfo.set("token_type", "Bearer");
+			TokenInfo.set("created", Now());
+			TokenInfo.set("expires_in", 86400);
+			TokenInfo.set("idle_timeout", 86400);
+			Response.set("tokenInfo", TokenInfo);
+			Response.set("userInfo", MakeUser(Sub ? "standin-subscriber" : "standin-root",
+											  Sub ? "subscriber" : "root"));
+			Response.set("expiresOn", Now() + 86400);
+			return Poco::Net::HTTPResponse::HTTP_OK;
+		}
+
+		if (S[0] == "subusers" && Method == Poco::Net::HTTPRequest::HTTP_GET) {
+			Response.set("users", Poco::JSON::Array());
+			return Poco::Net::HTTPResponse::HTTP_OK;
+		}
+
+		if (S.size() == 2 && (S[0] == "user" || S[0] == "subuser")) {
+			if (Method == Poco::Net::HTTPRequest::HTTP_DELETE)
+				return Poco::Net::HTTPResponse::HTTP_NO_CONTENT;
+			if (Method != Poco::Net::HTTPRequest::HTTP_GET)
+				return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+			auto User = MakeUser(S[1], S[0] == "user" ? "root" : "subscriber");
+			for (const auto &[Key, Value] : *User)
+				Response.set(Key, Value);
+			return Poco::Net::HTTPResponse::HTTP_OK;
+		}
+		return Poco::Net::HTTPResponse::HTTP_NOT_FOUND;
+	}
+
+} // namespace OpenWifi::StandIn
@@ -0,0 +1,114 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerRequest.h"
+
+namespace OpenWifi::StandIn {
+
+	//	How a stand-in answers: every call waits Latency plus up to Jitter milliseconds, and
+	//	ErrorRate of the calls fail with a 503 after waiting.
+	struct Behaviour {
+		std::uint64_t Latency = 0;
+		std::uint64_t Jitter = 0;
+		double ErrorRate = 0.0;
+	};
+
+	//	"name=value" settings from the command line; arguments starting with '-' are left alone.
+	//	A setting may be scoped to one service with its type as prefix: owgw.latency=40
+	//	overrides latency=5 for the gateway only.
+	class Options {
+	  public:
+		void Parse(int argc, char **argv);
+		[[nodiscard]] std::string Get(const std::string &Service, const std::string &Name,
+									  const std::string &Default) const;
+		[[nodiscard]] std::uint64_t GetInt(const std::string &Service, const std::string &Name,
+										   std::uint64_t Default) const;
+		[[nodiscard]] Behaviour Get(const std::string &Service) const;
+
+	  private:
+		std::map<std::string, std::string> Values_;
+	};
+
+	//	The service_events join message a micro service posts when it starts.
+	std::string JoinEvent(const std::string &Type, const std::string &EndPoint,
+						  const std::string &Key);
+
+	class Service {
+	  public:
+		Service(std::string Type, const Behaviour &B, std::string Host, std::uint16_t Port,
+				std::string Key);
+		virtual ~Service();
+
+		void Start();
+		void Stop();
+
+		[[nodiscard]] const std::string &Type() const { return Type_; }
+		[[nodiscard]] std::string EndPoint() const;
+		[[nodiscard]] std::string JoinEvent() const {
+			return StandIn::JoinEvent(Type_, EndPoint(), Key_);
+		}
+
+		//	Sleeps for the configured latency. Returns false when the call must fail.
+		bool Delay();
+
+		//	Answers a call: returns the HTTP status and fills Response.
+		virtual int Answer(const std::string &Method, const std::string &Path,
+						   const Poco::Net::HTTPServerRequest &Request, const std::string &Body,
+						   Poco::JSON::Object &Response) = 0;
+
+	  private:
+		std::string Type_;
+		Behaviour Behaviour_;
+		std::string Host_;
+		std::uint16_t Port_;
+		std::string Key_;
+		std::unique_ptr<Poco::Net::HTTPServer> Server_;
+		std::mutex RandomMutex_;
+		std::mt19937_64 Random_;
+	};
+
+	//	owgw: device commands, device updates and the RADIUS proxy configuration.
+	class Gateway : public Service {
+	  public:
+		using Service::Service;
+		int Answer(const std::string &Method, const std::string &Path,
+				   const Poco::Net::HTTPServerRequest &Request, const std::string &Body,
+				   Poco::JSON::Object &Response) override;
+
+	  private:
+		std::mutex Mutex_;
+		std::string RadiusProxyConfig_{R"lit({"pools":[]})lit"};
+	};
+
+	//	owfms: firmware lists and latest firmware per device type.
+	class Firmware : public Service {
+	  public:
+		using Service::Service;
+		int Answer(const std::string &Method, const std::string &Path,
+				   const Poco::Net::HTTPServerRequest &Request, const std::string &Body,
+				   Poco::JSON::Object &Response) override;
+	};
+
+	//	owsec: token and API key validation, users and subscribers. Every token is valid and
+	//	belongs to a root user.
+	class Security : public Service {
+	  public:
+		using Service::Service;
+		int Answer(const std::string &Method, const std::string &Path,
+				   const Poco::Net::HTTPServerRequest &Request, const std::string &Body,
+				   Poco::JSON::Object &Response) override;
+	};
+
+} // namespace OpenWifi::StandIn
@@ -0,0 +1,118 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/SSLManager.h"
+#include "Poco/Util/ServerApplication.h"
+
+#include "Daemon.h"
+#include "LoadGenerator.h"
+#include "StandInServices.h"
+#include "framework/MetricsRegistry.h"
+
+//	Runs owprov in this process, points it at the gateway, security and firmware stand-ins, then
+//	replays device connections and REST calls at a fixed rate. Arguments starting with '-' go to
+//	owprov (--config=...), the rest are load settings:
+//
+//	  standin=embedded|external	run the stand-ins here, or use owprov_standin at <type>.endpoint
+//	  via=queue|kafka				connections go to AutoDiscovery or through KafkaManager
+//	  connect.rate=100 ping.ratio=0.8 devices=10000 devicetype=edgecore_eap101
+//	  rest.rate=20 rest.threads=8 rest.paths=/inventory/{serial},... token=loadgen
+//	  duration=60 drain.timeout=120 output=FILE metrics=FILE
+//	  latency=MS jitter=MS errors=RATE and <type>.port, <type>.latency... as for owprov_standin
+int main(int argc, char **argv) {
+	using namespace OpenWifi;
+
+	StandIn::Options O;
+	O.Parse(argc, argv);
+	std::vector<char *> DaemonArgs{argv[0]};
+	for (int i = 1; i < argc; ++i)
+		if (argv[i][0] == '-')
+			DaemonArgs.push_back(argv[i]);
+
+	//	Every thread inherits the mask, so the daemon's termination wait gets the signals.
+	sigset_t Signals;
+	sigemptyset(&Signals);
+	sigaddset(&Signals, SIGINT);
+	sigaddset(&Signals, SIGQUIT);
+	sigaddset(&Signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &Signals, nullptr);
+
+	std::vector<std::unique_ptr<StandIn::Service>> StandIns;
+	std::vector<std::string> JoinEvents;
+	auto Key = O.Get("", "key", "standin");
+	for (const auto &[Type, Port] : std::vector<std::pair<std::string, std::uint64_t>>{
+			 {"owgw", 17002}, {"owsec", 17001}, {"owfms", 17004}}) {
+		auto P = (std::uint16_t)O.GetInt(Type, "port", Port);
+		if (O.Get("", "standin", "embedded") != "embedded") {
+			JoinEvents.emplace_back(StandIn::JoinEvent(
+				Type, O.Get(Type, "endpoint", "http://localhost:" + std::to_string(P)), Key));
+			continue;
+		}
+		if (P == 0)
+			continue;
+		auto Host = O.Get("", "host", "localhost");
+		std::unique_ptr<StandIn::Service> S;
+		if (Type == "owgw")
+			S = std::make_unique<StandIn::Gateway>(Type, O.Get(Type), Host, P, Key);
+		else if (Type == "owsec")
+			S = std::make_unique<StandIn::Security>(Type, O.Get(Type), Host, P, Key);
+		else
+			S = std::make_unique<StandIn::Firmware>(Type, O.Get(Type), Host, P, Key);
+		S->Start();
+		JoinEvents.emplace_back(S->JoinEvent());
+		StandIns.emplace_back(std::move(S));
+	}
+
+	Poco::Net::SSLManager::instance().initializeServer(nullptr, nullptr, nullptr);
+	std::atomic_bool Stopped{false};
+	int ExitCode = 0;
+	std::thread Service([&] {
+		try {
+			ExitCode = Daemon::instance()->run((int)DaemonArgs.size(), DaemonArgs.data());
+		} catch (const Poco::Exception &E) {
+			std::cerr << E.displayText() << std::endl;
+			ExitCode = Poco::Util::Application::EXIT_SOFTWARE;
+		}
+		Stopped = true;
+	});
+
+	LoadGen::Settings S;
+	S.Load(O);
+	LoadGen::LoadGenerator Generator(S);
+	if (Generator.WaitForService(Stopped, std::chrono::seconds(120))) {
+		LoadGen::LoadGenerator::Announce(JoinEvents);
+		Generator.Run(Stopped);
+
+		Poco::JSON::Object Results;
+		Generator.to_json(Results);
+		Results.stringify(std::cout, 2);
+		std::cout << std::endl;
+		if (auto Output = O.Get("", "output", ""); !Output.empty()) {
+			std::ofstream F(Output, std::ios::trunc);
+			Results.stringify(F, 2);
+		}
+		if (auto Metrics = O.Get("", "metrics", ""); !Metrics.empty()) {
+			std::ofstream F(Metrics, std::ios::trunc);
+			F << MetricsRegistry()->Prometheus();
+		}
+	} else {
+		std::cerr << "owprov did not start." << std::endl;
+		ExitCode = ExitCode ? ExitCode : 1;
+	}
+
+	if (!Stopped)
+		Poco::Util::ServerApplication::terminate();
+	Service.join();
+	for (auto &StandIn : StandIns)
+		StandIn->Stop();
+	Poco::Net::SSLManager::instance().shutdown();
+	return ExitCode;
+}
@@ -0,0 +1,57 @@
+//
+// Created by stephane bourque on 2023-11-27.
+//
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "StandInServices.h"
+
+//	Runs the owgw, owsec and owfms stand-ins until interrupted. The service_events join message
+//	of each stand-in is printed at start: post them on the bus to point a real owprov at them.
+//
+//	owprov_standin [host=localhost] [key=standin] [latency=MS] [jitter=MS] [errors=RATE]
+//				   [owgw.port=17002] [owsec.port=17001] [owfms.port=17004] [<type>.<setting>=...]
+int main(int argc, char **argv) {
+	using namespace OpenWifi::StandIn;
+
+	Options O;
+	O.Parse(argc, argv);
+
+	sigset_t Signals;
+	sigemptyset(&Signals);
+	sigaddset(&Signals, SIGINT);
+	sigaddset(&Signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &Signals, nullptr);
+
+	std::vector<std::unique_ptr<Service>> Services;
+	auto Port = [&](const std::string &Type, std::uint64_t Default) {
+		return (std::uint16_t)O.GetInt(Type, "port", Default);
+	};
+	auto Host = O.Get("", "host", "localhost");
+	auto Key = O.Get("", "key", "standin");
+	if (auto P = Port("owgw", 17002); P != 0)
+		Services.emplace_back(std::make_unique<Gateway>("owgw", O.Get("owgw"), Host, P, Key));
+	if (auto P = Port("owsec", 17001); P != 0)
+		Services.emplace_back(std::make_unique<Security>("owsec", O.Get("owsec"), Host, P, Key));
+	if (auto P = Port("owfms", 17004); P != 0)
+		Services.emplace_back(std::make_unique<Firmware>("owfms", O.Get("owfms"), Host, P, Key));
+
+	try {
+		for (auto &S : Services) {
+			S->Start();
+			std::cout << S->JoinEvent() << std::endl;
+		}
+	} catch (const Poco::Exception &E) {
+		std::cerr << E.displayText() << std::endl;
+		return 1;
+	}
+
+	int Signal;
+	sigwait(&Signals, &Signal);
+	for (auto &S : Services)
+		S->Stop();
+	return 0;
+}
@@ -9,6 +9,8 @@
 #include "Poco/StringTokenizer.h"
 #include "fmt/format.h"
 
+#include <algorithm>
+
 #include <RadiusEndpointTypes/OrionWifi.h>
 #include <RadiusEndpointTypes/GlobalReach.h>
 #include <RadiusEndpointTypes/Radsec.h>
@@ -16,6 +18,83 @@
 
 namespace OpenWifi {
 
+	const char *APConfigProfile::Name(Stage S) {
+		switch (S) {
+		case Stage::fetch:
+			return "fetch";
+		case Stage::parse:
+			return "parse";
+		case Stage::variables:
+			return "variables";
+		case Stage::radius:
+			return "radius";
+		case Stage::overrides:
+			return "overrides";
+		default:
+			return "other";
+		}
+	}
+
+	void APConfigProfile::End() {
+		Total_ = Clock::now() - Start_;
+		static const auto Histograms = [] {
+			std::array<MetricsHistogram *, (std::size_t)Stage::count + 1> H{};
+			for (std::size_t i = 0; i < H.size(); ++i)
+				H[i] = &MetricsRegistry()->Histogram(
+					"owprov_config_stage_duration_seconds",
+					"Time spent computing device configurations, by stage.",
+					{{"stage", i < (std::size_t)Stage::count ? Name((Stage)i) : "total"}});
+			return H;
+		}();
+		for (std::size_t i = 0; i < Stages_.size(); ++i)
+			if (Stages_[i].Calls)
+				Histograms[i]->Observe(Stages_[i].Time);
+		Histograms.back()->Observe(Total_);
+	}
+
+	void APConfigProfile::to_json(Poco::JSON::Object &Obj) const {
+		auto Micros = [](Clock::duration D) {
+			return (std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+		};
+		Obj.set("totalMicroseconds", Micros(Total_));
+		Obj.set("dbQueries", Queries_);
+		Obj.set("bytesParsed", Bytes_);
+
+		Poco::JSON::Array Stages;
+		auto Other = Total_;
+		for (std::size_t i = 0; i < Stages_.size(); ++i) {
+			Poco::JSON::Object S;
+			S.set("stage", Name((Stage)i));
+			S.set("calls", Stages_[i].Calls);
+			S.set("microseconds", Micros(Stages_[i].Time));
+			Stages.add(S);
+			Other -= Stages_[i].Time;
+		}
+		Poco::JSON::Object S;
+		S.set("stage", "other");
+		S.set("microseconds", Micros(std::max(Other, Clock::duration::zero())));
+		Stages.add(S);
+		Obj.set("stages", Stages);
+
+		std::vector<decltype(Sources_)::const_pointer> BySpent;
+		for (const auto &Entry : Sources_)
+			BySpent.push_back(&Entry);
+		std::sort(BySpent.begin(), BySpent.end(),
+				  [](auto A, auto B) { return A->second.Time > B->second.Time; });
+		Poco::JSON::Array Sources;
+		for (const auto *Entry : BySpent) {
+			Poco::JSON::Object O;
+			O.set("kind", Entry->first.first);
+			O.set("id", Entry->first.second);
+			O.set("name", Entry->second.Name);
+			O.set("microseconds", Micros(Entry->second.Time));
+			O.set("dbQueries", Entry->second.Queries);
+			O.set("bytesParsed", Entry->second.Bytes);
+			Sources.add(O);
+		}
+		Obj.set("sources", Sources);
+	}
+
 	APConfig::APConfig(const std::string &SerialNumber, const std::string &DeviceType,
 					   Poco::Logger &L, bool Explain)
 		: SerialNumber_(SerialNumber), DeviceType_(DeviceType), Logger_(L), Explain_(Explain) {}
@@ -60,19 +139,37 @@ namespace OpenWifi {
 		 */
 	}
 
+    //  The provider output only depends on the endpoint, except for the nas-identifier which
+    //  defaults to the serial number: render once per endpoint version and fill that in per device.
     bool APConfig::InsertRadiusEndPoint(const ProvObjects::RADIUSEndPoint &RE, Poco::JSON::Object &Result) {
         if(RE.UseGWProxy) {
-            Poco::JSON::Object  ServerSettings;
-            if (RE.Type == "orion") {
-                return OpenRoaming_Orion()->Render(RE, SerialNumber_, Result);
-            } else if (RE.Type == "globalreach") {
-                return OpenRoaming_GlobalReach()->Render(RE, SerialNumber_, Result);
-            } else if (RE.Type == "radsec") {
-                return OpenRoaming_Radsec()->Render(RE, SerialNumber_, Result);
-            } else if (RE.Type == "generic") {
-                return OpenRoaming_GenericRadius()->Render(RE, SerialNumber_, Result);
+            auto &Cache = StorageService()->RadiusEndpointDB().RenderCache();
+            auto Rendered = Cache.GetRender(RE);
+            if(Rendered == nullptr) {
+                auto R = std::make_shared<RadiusEndpointCache::Rendered>();
+                R->Modified = RE.info.modified;
+                R->DeviceNasIdentifier = RE.NasIdentifier.empty();
+                if (RE.Type == "orion") {
+                    R->Result = OpenRoaming_Orion()->Render(RE, "", R->Fragment);
+                } else if (RE.Type == "globalreach") {
+                    R->Result = OpenRoaming_GlobalReach()->Render(RE, "", R->Fragment);
+                } else if (RE.Type == "radsec") {
+                    R->Result = OpenRoaming_Radsec()->Render(RE, "", R->Fragment);
+                } else if (RE.Type == "generic") {
+                    R->Result = OpenRoaming_GenericRadius()->Render(RE, "", R->Fragment);
+                } else {
+                    R->Fragment.set("radius", Poco::JSON::Object());
+                }
+                Cache.SetRender(RE, R);
+                Rendered = R;
+            }
+            for(const auto &Name:Rendered->Fragment.getNames()) {
+                Result.set(Name, Rendered->Fragment.get(Name));
+            }
+            if(Rendered->DeviceNasIdentifier && Rendered->Fragment.has("nas-identifier")) {
+                Result.set("nas-identifier", SerialNumber_);
             }
-            Result.set( "radius" , ServerSettings);
+            return Rendered->Result;
         } else {
             std::cout << "Radius proxy off" << RE.info.name << std::endl;
         }
@@ -85,12 +182,24 @@ namespace OpenWifi {
 		Once the top-level variable is resolved, this will be called to resolve any
 		variables nested within the top-level variable.
 		*/
+		APConfigProfile::SourceScope Source(Profile_, "variableBlock", uuid);
 		ProvObjects::VariableBlock VB;
-		if (StorageService()->VariablesDB().GetRecord("id", uuid, VB)) {
+		bool Found;
+		{
+			APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+			Profile_.Query();
+			Found = StorageService()->VariablesDB().GetRecord("id", uuid, VB);
+		}
+		if (Found) {
+			Source.Name(VB.info.name);
 			for (const auto &var: VB.variables) {
-				Poco::JSON::Parser P;
-				auto VariableBlockInfo =
-					P.parse(var.value).extract<Poco::JSON::Object::Ptr>();
+				Poco::JSON::Object::Ptr VariableBlockInfo;
+				{
+					APConfigProfile::Scope Parse(Profile_, APConfigProfile::Stage::parse);
+					Profile_.Parsed(var.value.size());
+					Poco::JSON::Parser P;
+					VariableBlockInfo = P.parse(var.value).extract<Poco::JSON::Object::Ptr>();
+				}
 				auto VarNames = VariableBlockInfo->getNames();
 				for (const auto &j: VarNames) {
 					if(VariableBlockInfo->isArray(j)) {
@@ -151,7 +260,16 @@ namespace OpenWifi {
                 auto EndPointId = Original.get(i).toString();
                 ProvObjects::RADIUSEndPoint RE;
 //                std::cout << "ID->" << EndPointId << std::endl;
-                if(StorageService()->RadiusEndpointDB().GetRecord("id",EndPointId,RE)) {
+                APConfigProfile::SourceScope Source(Profile_, "radiusEndpoint", EndPointId);
+                bool Found;
+                {
+                    APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+                    Profile_.Query();
+                    Found = StorageService()->RadiusEndpointDB().GetRecord("id",EndPointId,RE);
+                }
+                if(Found) {
+                    Source.Name(RE.info.name);
+                    APConfigProfile::Scope Radius(Profile_, APConfigProfile::Stage::radius);
                     InsertRadiusEndPoint(RE, Result);
                 } else {
                     poco_error(Logger_, fmt::format("RADIUS Endpoint {} could not be found. Please delete this configuration and recreate it."));
@@ -208,29 +326,32 @@ namespace OpenWifi {
 
 	bool APConfig::Get(Poco::JSON::Object::Ptr &Configuration) {
 
+		Profile_.Begin();
 		if (Config_.empty()) {
 			Explanation_.clear();
 			try {
 				if (!Sub_) {
 					ProvObjects::InventoryTag D;
-					if (StorageService()->InventoryDB().GetRecord("serialNumber", SerialNumber_,
-																  D)) {
-						if (!D.deviceConfiguration.empty()) {
-							// std::cout << "Adding device specific configuration: " << D.deviceConfiguration.size() << std::endl;
-							AddConfiguration(D.deviceConfiguration);
-						} else {
-							// std::cout << "No device specific configuration." << std::endl;
-						}
-						if (!D.entity.empty()) {
-							AddEntityConfig(D.entity);
-						} else if (!D.venue.empty()) {
-							AddVenueConfig(D.venue);
-						}
+					bool Found;
+					{
+						APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+						Profile_.Query();
+						Found = StorageService()->InventoryDB().GetRecord("serialNumber",
+																		  SerialNumber_, D);
+					}
+					if (Found) {
+						AddDeviceConfig(D);
 					}
 				} else {
 					ProvObjects::SubscriberDevice D;
-					if (StorageService()->SubscriberDeviceDB().GetRecord("serialNumber",
-																		 SerialNumber_, D)) {
+					bool Found;
+					{
+						APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+						Profile_.Query();
+						Found = StorageService()->SubscriberDeviceDB().GetRecord("serialNumber",
+																				 SerialNumber_, D);
+					}
+					if (Found) {
 						// Subscriber path resolves a configuration UUID. Ensure device-type matching
 						// uses the subscriber device type before loading configuration blocks.
 						DeviceType_ = D.deviceType;
@@ -245,127 +366,154 @@ namespace OpenWifi {
 			}
 		}
 
+		bool Merged = false;
 		try {
-			std::set<std::string> Sections;
-			for (const auto &i : Config_) {
+			Merge(Configuration);
+			Merged = true;
+			ApplyOverrides(Configuration);
+		} catch (...) {
+		}
+		Profile_.End();
+		return Merged && !Config_.empty();
+	}
+
+	void APConfig::Merge(Poco::JSON::Object::Ptr &Configuration) {
+		std::set<std::string> Sections;
+		for (const auto &i : Config_) {
+			APConfigProfile::SourceScope Source(Profile_, "configuration", i.info.id);
+			Source.Name(i.info.name);
+			Poco::JSON::Object::Ptr O;
+			{
+				APConfigProfile::Scope Parse(Profile_, APConfigProfile::Stage::parse);
+				Profile_.Parsed(i.element.configuration.size());
 				Poco::JSON::Parser P;
-				auto O = P.parse(i.element.configuration).extract<Poco::JSON::Object::Ptr>();
-				auto Names = O->getNames();
-				for (const auto &SectionName : Names) {
-					auto InsertInfo = Sections.insert(SectionName);
-					if (InsertInfo.second) {
-						if (O->isArray(SectionName)) {
-							auto OriginalArray = O->getArray(SectionName);
-							if (Explain_) {
-								Poco::JSON::Object ExObj;
-								ExObj.set("from-uuid", i.info.id);
-								ExObj.set("from-name", i.info.name);
-								ExObj.set("action", "added");
-								ExObj.set("element", OriginalArray);
-								Explanation_.add(ExObj);
-							}
-                            Poco::JSON::Array ExpandedArray;
-							ReplaceVariablesInArray(*OriginalArray, ExpandedArray);
-							Configuration->set(SectionName, ExpandedArray);
-						} else if (O->isObject(SectionName)) {
-							auto OriginalSection =
-								O->get(SectionName).extract<Poco::JSON::Object::Ptr>();
-							if (Explain_) {
-								Poco::JSON::Object ExObj;
-								ExObj.set("from-uuid", i.info.id);
-								ExObj.set("from-name", i.info.name);
-								ExObj.set("action", "added");
-								ExObj.set("element", OriginalSection);
-								Explanation_.add(ExObj);
-							}
-                            Poco::JSON::Object ExpandedSection;
-							ReplaceVariablesInObject(*OriginalSection, ExpandedSection);
-							Configuration->set(SectionName, ExpandedSection);
-						} else {
-                            poco_warning(Logger(), fmt::format("Unknown config element type: {}",O->get(SectionName).toString()));
+				O = P.parse(i.element.configuration).extract<Poco::JSON::Object::Ptr>();
+			}
+			auto Names = O->getNames();
+			for (const auto &SectionName : Names) {
+				auto InsertInfo = Sections.insert(SectionName);
+				if (InsertInfo.second) {
+					if (O->isArray(SectionName)) {
+						auto OriginalArray = O->getArray(SectionName);
+						if (Explain_) {
+							Poco::JSON::Object ExObj;
+							ExObj.set("from-uuid", i.info.id);
+							ExObj.set("from-name", i.info.name);
+							ExObj.set("action", "added");
+							ExObj.set("element", OriginalArray);
+							Explanation_.add(ExObj);
 						}
-					} else {
+                        Poco::JSON::Array ExpandedArray;
+						APConfigProfile::Scope Variables(Profile_,
+														 APConfigProfile::Stage::variables);
+						ReplaceVariablesInArray(*OriginalArray, ExpandedArray);
+						Configuration->set(SectionName, ExpandedArray);
+					} else if (O->isObject(SectionName)) {
+						auto OriginalSection =
+							O->get(SectionName).extract<Poco::JSON::Object::Ptr>();
 						if (Explain_) {
 							Poco::JSON::Object ExObj;
 							ExObj.set("from-uuid", i.info.id);
 							ExObj.set("from-name", i.info.name);
-							ExObj.set("action", "ignored");
-							ExObj.set("reason", "weight insufficient");
-							ExObj.set("element", O->get(SectionName));
+							ExObj.set("action", "added");
+							ExObj.set("element", OriginalSection);
 							Explanation_.add(ExObj);
 						}
+                        Poco::JSON::Object ExpandedSection;
+						APConfigProfile::Scope Variables(Profile_,
+														 APConfigProfile::Stage::variables);
+						ReplaceVariablesInObject(*OriginalSection, ExpandedSection);
+						Configuration->set(SectionName, ExpandedSection);
+					} else {
+                        poco_warning(Logger(), fmt::format("Unknown config element type: {}",O->get(SectionName).toString()));
+					}
+				} else {
+					if (Explain_) {
+						Poco::JSON::Object ExObj;
+						ExObj.set("from-uuid", i.info.id);
+						ExObj.set("from-name", i.info.name);
+						ExObj.set("action", "ignored");
+						ExObj.set("reason", "weight insufficient");
+						ExObj.set("element", O->get(SectionName));
+						Explanation_.add(ExObj);
 					}
 				}
 			}
+		}
+	}
 
-			//  Apply overrides...
-			ProvObjects::ConfigurationOverrideList COL;
-			if (StorageService()->OverridesDB().GetRecord("serialNumber", SerialNumber_, COL)) {
-				for (const auto &col : COL.overrides) {
-					const auto Tokens = Poco::StringTokenizer(col.parameterName, ".");
-					if (Tokens[0] == "radios" && Tokens.count() == 3) {
-						std::uint64_t RadioIndex = std::strtoull(Tokens[1].c_str(), nullptr, 10);
-						if (RadioIndex < MaximumPossibleRadios) {
-							auto RadioArray = Configuration->getArray("radios");
-							if (RadioIndex < RadioArray->size()) {
-								auto IndexedRadio =
-									RadioArray->get(RadioIndex).extract<Poco::JSON::Object::Ptr>();
-								if (Tokens[2] == "tx-power") {
+	void APConfig::ApplyOverrides(Poco::JSON::Object::Ptr &Configuration) {
+		ProvObjects::ConfigurationOverrideList COL;
+		bool Found;
+		{
+			APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+			Profile_.Query();
+			Found = StorageService()->OverridesDB().GetRecord("serialNumber", SerialNumber_, COL);
+		}
+		if (Found) {
+			APConfigProfile::Scope Overrides(Profile_, APConfigProfile::Stage::overrides);
+			for (const auto &col : COL.overrides) {
+				const auto Tokens = Poco::StringTokenizer(col.parameterName, ".");
+				if (Tokens[0] == "radios" && Tokens.count() == 3) {
+					std::uint64_t RadioIndex = std::strtoull(Tokens[1].c_str(), nullptr, 10);
+					if (RadioIndex < MaximumPossibleRadios) {
+						auto RadioArray = Configuration->getArray("radios");
+						if (RadioIndex < RadioArray->size()) {
+							auto IndexedRadio =
+								RadioArray->get(RadioIndex).extract<Poco::JSON::Object::Ptr>();
+							if (Tokens[2] == "tx-power") {
+								IndexedRadio->set(
+									"tx-power",
+									std::strtoull(col.parameterValue.c_str(), nullptr, 10));
+								if (Explain_) {
+									Poco::JSON::Object ExObj;
+									ExObj.set("from-name", "overrides");
+									ExObj.set("override", col.parameterName);
+									ExObj.set("source", col.source);
+									ExObj.set("reason", col.reason);
+									ExObj.set("value", col.parameterValue);
+									Explanation_.add(ExObj);
+								}
+								RadioArray->set(RadioIndex, IndexedRadio);
+								Configuration->set("radios", RadioArray);
+							} else if (Tokens[2] == "channel") {
+								if (col.parameterValue == "auto") {
+									IndexedRadio->set("channel", "auto");
+								} else {
 									IndexedRadio->set(
-										"tx-power",
+										"channel",
 										std::strtoull(col.parameterValue.c_str(), nullptr, 10));
-									if (Explain_) {
-										Poco::JSON::Object ExObj;
-										ExObj.set("from-name", "overrides");
-										ExObj.set("override", col.parameterName);
-										ExObj.set("source", col.source);
-										ExObj.set("reason", col.reason);
-										ExObj.set("value", col.parameterValue);
-										Explanation_.add(ExObj);
-									}
-									RadioArray->set(RadioIndex, IndexedRadio);
-									Configuration->set("radios", RadioArray);
-								} else if (Tokens[2] == "channel") {
-									if (col.parameterValue == "auto") {
-										IndexedRadio->set("channel", "auto");
-									} else {
-										IndexedRadio->set(
-											"channel",
-											std::strtoull(col.parameterValue.c_str(), nullptr, 10));
-									}
-									// std::cout << "Setting channel in radio " << RadioIndex << std::endl;
-									if (Explain_) {
-										Poco::JSON::Object ExObj;
-										ExObj.set("from-name", "overrides");
-										ExObj.set("override", col.parameterName);
-										ExObj.set("source", col.source);
-										ExObj.set("reason", col.reason);
-										ExObj.set("value", col.parameterValue);
-										Explanation_.add(ExObj);
-									}
-									RadioArray->set(RadioIndex, IndexedRadio);
-									Configuration->set("radios", RadioArray);
-								} else {
-									poco_error(
-										Logger(),
-										fmt::format("{}: Unsupported override variable name {}",
-													col.parameterName));
 								}
+								// std::cout << "Setting channel in radio " << RadioIndex << std::endl;
+								if (Explain_) {
+									Poco::JSON::Object ExObj;
+									ExObj.set("from-name", "overrides");
+									ExObj.set("override", col.parameterName);
+									ExObj.set("source", col.source);
+									ExObj.set("reason", col.reason);
+									ExObj.set("value", col.parameterValue);
+									Explanation_.add(ExObj);
+								}
+								RadioArray->set(RadioIndex, IndexedRadio);
+								Configuration->set("radios", RadioArray);
+							} else {
+								poco_error(
+									Logger(),
+									fmt::format("{}: Unsupported override variable name {}",
+												col.parameterName));
 							}
-						} else {
-							poco_error(Logger(), fmt::format("{}: radio index out of range in {}",
-															 col.parameterName));
 						}
 					} else {
-						poco_error(Logger(),
-								   fmt::format("{}: Unsupported override variable name {}",
-											   col.parameterName));
+						poco_error(Logger(), fmt::format("{}: radio index out of range in {}",
+														 col.parameterName));
 					}
+				} else {
+					poco_error(Logger(),
+							   fmt::format("{}: Unsupported override variable name {}",
+										   col.parameterName));
 				}
 			}
-		} catch (...) {
 		}
-		return !Config_.empty();
 	}
 
 	static bool DeviceTypeMatch(const std::string &DeviceType, const Types::StringVec &Types) {
@@ -402,8 +550,16 @@ namespace OpenWifi {
 		if (UUID.empty())
 			return;
 
+		APConfigProfile::SourceScope Source(Profile_, "configuration", UUID);
 		ProvObjects::DeviceConfiguration Config;
-		if (StorageService()->ConfigurationDB().GetRecord("id", UUID, Config)) {
+		bool Found;
+		{
+			APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+			Profile_.Query();
+			Found = StorageService()->ConfigurationDB().GetRecord("id", UUID, Config);
+		}
+		if (Found) {
+			Source.Name(Config.info.name);
 //            std::cout << Config.info.name << ":" << Config.configuration.size() << std::endl;
 			if (!Config.configuration.empty()) {
 				if (DeviceTypeMatch(DeviceType_, Config.deviceTypes)) {
@@ -440,9 +596,28 @@ namespace OpenWifi {
 		}
 	}
 
+	void APConfig::AddDeviceConfig(const ProvObjects::InventoryTag &D) {
+		if (!D.deviceConfiguration.empty()) {
+			AddConfiguration(D.deviceConfiguration);
+		}
+		if (!D.entity.empty()) {
+			AddEntityConfig(D.entity);
+		} else if (!D.venue.empty()) {
+			AddVenueConfig(D.venue);
+		}
+	}
+
 	void APConfig::AddEntityConfig(const std::string &UUID) {
+		APConfigProfile::SourceScope Source(Profile_, "entity", UUID);
 		ProvObjects::Entity E;
-		if (StorageService()->EntityDB().GetRecord("id", UUID, E)) {
+		bool Found;
+		{
+			APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+			Profile_.Query();
+			Found = StorageService()->EntityDB().GetRecord("id", UUID, E);
+		}
+		if (Found) {
+			Source.Name(E.info.name);
 			AddConfiguration(E.configurations);
 			if (!E.parent.empty()) {
 				AddEntityConfig(E.parent);
@@ -452,8 +627,16 @@ namespace OpenWifi {
 	}
 
 	void APConfig::AddVenueConfig(const std::string &UUID) {
+		APConfigProfile::SourceScope Source(Profile_, "venue", UUID);
 		ProvObjects::Venue V;
-		if (StorageService()->VenueDB().GetRecord("id", UUID, V)) {
+		bool Found;
+		{
+			APConfigProfile::Scope Fetch(Profile_, APConfigProfile::Stage::fetch);
+			Profile_.Query();
+			Found = StorageService()->VenueDB().GetRecord("id", UUID, V);
+		}
+		if (Found) {
+			Source.Name(V.info.name);
 			AddConfiguration(V.configurations);
 			if (!V.entity.empty()) {
 				AddEntityConfig(V.entity);
@@ -6,6 +6,10 @@
 
 #include "Poco/Logger.h"
 #include "RESTObjects//RESTAPI_ProvObjects.h"
+#include "framework/MetricsRegistry.h"
+#include <array>
+#include <chrono>
+#include <map>
 #include <string>
 
 namespace OpenWifi {
@@ -18,6 +22,116 @@ namespace OpenWifi {
 	};
 	typedef std::vector<VerboseElement> ConfigVec;
 
+	//	Where APConfig::Get spends its time. Stages nest: a variable block read while expanding
+	//	variables counts as fetch, not as variables, so stage times add up to the total, with
+	//	"other" for merging. When collected, sources hold the inclusive time, record reads and
+	//	JSON bytes of each configuration, entity, venue, variable block and RADIUS endpoint
+	//	involved. Record reads include those answered by the ORM caches.
+	class APConfigProfile {
+	  public:
+		enum class Stage : std::size_t { fetch, parse, variables, radius, overrides, count };
+		using Clock = std::chrono::steady_clock;
+
+		struct Source {
+			std::string Name;
+			Clock::duration Time{};
+			std::uint64_t Queries = 0, Bytes = 0;
+		};
+
+		class Scope {
+		  public:
+			Scope(APConfigProfile &P, Stage S) : P_(P) { P_.Enter(S); }
+			~Scope() { P_.Leave(); }
+			Scope(const Scope &) = delete;
+			Scope &operator=(const Scope &) = delete;
+
+		  private:
+			APConfigProfile &P_;
+		};
+
+		//	Only records anything when sources are collected.
+		class SourceScope {
+		  public:
+			SourceScope(APConfigProfile &P, const char *Kind, const std::string &Id) : P_(P) {
+				if (!P.CollectSources_)
+					return;
+				S_ = &P.Sources_[std::make_pair(std::string{Kind}, Id)];
+				Start_ = Clock::now();
+				Queries_ = P.Queries_;
+				Bytes_ = P.Bytes_;
+			}
+			~SourceScope() {
+				if (S_ == nullptr)
+					return;
+				S_->Time += Clock::now() - Start_;
+				S_->Queries += P_.Queries_ - Queries_;
+				S_->Bytes += P_.Bytes_ - Bytes_;
+			}
+			inline void Name(const std::string &N) {
+				if (S_ != nullptr)
+					S_->Name = N;
+			}
+			SourceScope(const SourceScope &) = delete;
+			SourceScope &operator=(const SourceScope &) = delete;
+
+		  private:
+			APConfigProfile &P_;
+			Source *S_ = nullptr;
+			Clock::time_point Start_;
+			std::uint64_t Queries_ = 0, Bytes_ = 0;
+		};
+
+		//	Sources are only worth their cost when the profile is returned to the caller.
+		inline void CollectSources(bool On) { CollectSources_ = On; }
+
+		inline void Begin() {
+			bool CollectSources = CollectSources_;
+			*this = APConfigProfile{};
+			CollectSources_ = CollectSources;
+			Start_ = Clock::now();
+		}
+
+		//	Totals go to the owprov_config_stage_duration_seconds histograms.
+		void End();
+
+		inline void Query() { ++Queries_; }
+		inline void Parsed(std::size_t Bytes) { Bytes_ += Bytes; }
+
+		void to_json(Poco::JSON::Object &Obj) const;
+
+	  private:
+		struct StageTotal {
+			Clock::duration Time{};
+			std::uint64_t Calls = 0;
+		};
+
+		std::array<StageTotal, (std::size_t)Stage::count> Stages_{};
+		std::vector<Stage> Stack_;
+		std::map<std::pair<std::string, std::string>, Source> Sources_;
+		Clock::time_point Start_, Mark_;
+		Clock::duration Total_{};
+		std::uint64_t Queries_ = 0, Bytes_ = 0;
+		bool CollectSources_ = false;
+
+		inline void Enter(Stage S) {
+			auto Now = Clock::now();
+			if (!Stack_.empty())
+				Stages_[(std::size_t)Stack_.back()].Time += Now - Mark_;
+			Stack_.push_back(S);
+			++Stages_[(std::size_t)S].Calls;
+			Mark_ = Now;
+		}
+
+		inline void Leave() {
+			auto Now = Clock::now();
+			Stages_[(std::size_t)Stack_.back()].Time += Now - Mark_;
+			Stack_.pop_back();
+			Mark_ = Now;
+		}
+
+		static const char *Name(Stage S);
+	};
+
 	class APConfig {
 	  public:
 		explicit APConfig(const std::string &SerialNumber, const std::string &DeviceType,
@@ -31,7 +145,18 @@ namespace OpenWifi {
 		void AddConfiguration(const ProvObjects::DeviceConfigurationElementVec &Elements);
 		void AddVenueConfig(const std::string &UUID);
 		void AddEntityConfig(const std::string &UUID);
+		//	The device's own configuration, then that of its entity or venue chain.
+		void AddDeviceConfig(const ProvObjects::InventoryTag &D);
+
+		//	The two steps of Get, for callers that collect the configurations themselves:
+		//	merging and expanding what was added, then applying the device's overrides.
+		void Merge(Poco::JSON::Object::Ptr &Configuration);
+		void ApplyOverrides(Poco::JSON::Object::Ptr &Configuration);
+		[[nodiscard]] inline bool Empty() const { return Config_.empty(); }
 		const Poco::JSON::Array &Explanation() { return Explanation_; };
+		const APConfigProfile &Profile() const { return Profile_; }
+		//	Also collect the per source detail of the profile. Stage totals are always kept.
+		inline void ProfileSources(bool On) { Profile_.CollectSources(On); }
 
 	  private:
 		std::string SerialNumber_;
@@ -42,6 +167,7 @@ namespace OpenWifi {
 		Types::StringPairVec Errors;
 		bool Explain_ = false;
 		Poco::JSON::Array Explanation_;
+		APConfigProfile Profile_;
 		bool Sub_ = false;
 		Poco::Logger &Logger() { return Logger_; }
 
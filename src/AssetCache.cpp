@@ -0,0 +1,97 @@
+//
+// Created by stephane bourque on 2022-03-11.
+//
+
+#include <sstream>
+
+#include "Poco/DeflatingStream.h"
+#include "Poco/File.h"
+
+#include "AssetCache.h"
+#include "Daemon.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	static constexpr uint64_t AssetRecheckInterval = 10;
+
+	AssetCache::AssetPtr AssetCache::Get(const std::string &Name) {
+		if (Name.empty() || Name.find('/') != std::string::npos ||
+			Name.find("..") != std::string::npos)
+			return nullptr;
+
+		auto Now = Utils::Now();
+		{
+			std::shared_lock Lock(Mutex_);
+			auto hint = Assets_.find(Name);
+			if (hint != Assets_.end() && (Now - hint->second->Checked) < AssetRecheckInterval) {
+				Stats_.Hit();
+				return hint->second;
+			}
+		}
+
+		//	Either unknown or due for a check: a cheap stat decides whether the copy is still good.
+		Poco::File F(Daemon()->AssetDir() + "/" + Name);
+		if (!F.exists() || !F.isFile()) {
+			Invalidate(Name);
+			return nullptr;
+		}
+		auto LastModified = (uint64_t)F.getLastModified().epochTime();
+		auto Size = (uint64_t)F.getSize();
+
+		std::unique_lock Lock(Mutex_);
+		auto hint = Assets_.find(Name);
+		if (hint != Assets_.end() && hint->second->LastModified == LastModified &&
+			hint->second->Size == Size) {
+			hint->second->Checked = Now;
+			Stats_.Hit();
+			return hint->second;
+		}
+		Stats_.Miss();
+		auto Loaded = Load(Name);
+		if (Loaded == nullptr) {
+			Assets_.erase(Name);
+			return nullptr;
+		}
+		return Assets_[Name] = Loaded;
+	}
+
+	void AssetCache::Invalidate(const std::string &Name) {
+		std::unique_lock Lock(Mutex_);
+		Assets_.erase(Name);
+	}
+
+	void AssetCache::Clear() {
+		std::unique_lock Lock(Mutex_);
+		Assets_.clear();
+	}
+
+	AssetCache::AssetPtr AssetCache::Load(const std::string &Name) {
+		try {
+			Poco::File F(Daemon()->AssetDir() + "/" + Name);
+			auto A = std::make_shared<Asset>();
+			A->Content = Utils::LoadFile(F);
+			A->LastModified = (uint64_t)F.getLastModified().epochTime();
+			A->Size = A->Content.size();
+			A->Checked = Utils::Now();
+			auto MT = Utils::FindMediaType(F);
+			A->ContentType = MT.ContentType;
+			A->Binary = MT.Encoding == Utils::BINARY;
+			auto Hash = Utils::ComputeHash(A->Content).substr(0, 32);
+			A->ETag = "\"" + Hash + "\"";
+			A->GzippedETag = "\"" + Hash + "-gzip\"";
+
+			std::ostringstream OS;
+			Poco::DeflatingOutputStream Deflater(OS, Poco::DeflatingStreamBuf::STREAM_GZIP, 9);
+			Deflater << A->Content;
+			Deflater.close();
+			if (OS.str().size() < A->Content.size())
+				A->Gzipped = OS.str();
+			return A;
+		} catch (const Poco::Exception &E) {
+			Poco::Logger::get("ASSET-CACHE").log(E);
+		}
+		return nullptr;
+	}
+
+} // namespace OpenWifi
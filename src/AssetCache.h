@@ -0,0 +1,60 @@
+//
+// Created by stephane bourque on 2022-03-11.
+//
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include "Poco/Timestamp.h"
+
+#include "framework/MetricsRegistry.h"
+
+namespace OpenWifi {
+
+	//	In-memory copy of the files under Daemon()->AssetDir(), each kept alongside its gzip form
+	//	and a strong ETag per encoding. Entries are loaded on first use, re-checked against the file at most
+	//	every few seconds, and dropped by FileDownloader when it replaces a file.
+	class AssetCache {
+	  public:
+		struct Asset {
+			std::string Content;
+			std::string Gzipped; //	empty when compression does not make the file smaller
+			std::string ContentType;
+			std::string ETag;
+			std::string GzippedETag;
+			bool Binary = false;
+			uint64_t LastModified = 0;
+			uint64_t Size = 0;
+			//	Last time the file was found unchanged. Moved forward in place, even on a shared
+			//	entry.
+			mutable std::atomic_uint64_t Checked = 0;
+		};
+		using AssetPtr = std::shared_ptr<const Asset>;
+
+		static auto instance() {
+			static auto instance_ = new AssetCache;
+			return instance_;
+		}
+
+		AssetPtr Get(const std::string &Name);
+		void Invalidate(const std::string &Name);
+		void Clear();
+
+	  private:
+		std::shared_mutex Mutex_;
+		std::map<std::string, AssetPtr> Assets_;
+		MetricsCacheStats Stats_{"assets"};
+
+		static AssetPtr Load(const std::string &Name);
+
+		AssetCache() noexcept = default;
+	};
+
+	inline auto AssetCache() { return AssetCache::instance(); }
+
+} // namespace OpenWifi
@@ -7,6 +7,7 @@
 #include "StorageService.h"
 #include "framework/KafkaManager.h"
 #include "framework/KafkaTopics.h"
+#include "framework/MetricsRegistry.h"
 #include "framework/ow_constants.h"
 
 namespace OpenWifi {
@@ -18,6 +19,9 @@ namespace OpenWifi {
 			this->ConnectionReceived(Key, Payload);
 		};
 		ConnectionWatcherId_ = KafkaManager()->RegisterTopicWatcher(KafkaTopics::CONNECTION, F);
+		MetricsRegistry()->GaugeFunction("owprov_queue_depth", "Messages waiting in internal queues.",
+										 [this] { return (double)Queue_.size(); },
+										 {{"queue", "autodiscovery"}});
 		Worker_.start(*this);
 		return 0;
 	};
@@ -40,6 +40,7 @@ namespace OpenWifi {
 			Queue_.enqueueNotification(new DiscoveryMessage(Key, Payload));
 		}
 		void run() override;
+		[[nodiscard]] inline auto Pending() { return Queue_.size(); }
 
 	  private:
 		uint64_t ConnectionWatcherId_ = 0;
@@ -16,12 +16,14 @@
 #include "DeviceTypeCache.h"
 #include "FileDownloader.h"
 #include "FindCountry.h"
+#include "InventorySearchIndex.h"
 #include "JobController.h"
 #include "SerialNumberCache.h"
 #include "Signup.h"
 #include "StorageService.h"
 #include "UI_Prov_WebSocketNotifications.h"
 #include "framework/ConfigurationValidator.h"
+#include "framework/OpenAPIAsync.h"
 #include "framework/UI_WebSocketClientServer.h"
 #include <RadiusEndpointTypes/GlobalReach.h>
 #include <RadiusEndpointTypes/OrionWifi.h>
@@ -37,9 +39,11 @@ namespace OpenWifi {
 								   vDAEMON_CONFIG_ENV_VAR, vDAEMON_APP_NAME, vDAEMON_BUS_TIMER,
 								   SubSystemVec{OpenWifi::StorageService(), DeviceTypeCache(),
 												ConfigurationValidator(), SerialNumberCache(),
-												AutoDiscovery(), JobController(),
-												UI_WebSocketClientServer(), FindCountryFromIP(),
-												FileDownloader(),
+												InventorySearchIndex(), AutoDiscovery(),
+												JobController(), UI_WebSocketClientServer(),
+												FindCountryFromIP(),
+												FileDownloader(), OpenAPIAsync(),
+												OpenAPIAsyncEngine::Hedges(),
                                                 OpenRoaming_GlobalReach(),
                                                 OpenRoaming_Orion(), OpenRoaming_Radsec(),
                                                 OpenRoaming_GenericRadius()
@@ -79,6 +83,7 @@ namespace OpenWifi {
 
 } // namespace OpenWifi
 
+#ifndef OWPROV_NO_MAIN
 int main(int argc, char **argv) {
 	int ExitCode;
 	try {
@@ -100,5 +105,6 @@ int main(int argc, char **argv) {
 	std::cout << "Exitcode: " << ExitCode << std::endl;
 	return ExitCode;
 }
+#endif
 
 // end of namespace
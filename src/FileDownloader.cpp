@@ -3,8 +3,11 @@
 //
 
 #include "FileDownloader.h"
+#include "AssetCache.h"
 #include "Daemon.h"
 
+#include "Poco/File.h"
+
 namespace OpenWifi {
 	int FileDownloader::Start() {
 		poco_information(Logger(), "Starting...");
@@ -40,9 +43,15 @@ namespace OpenWifi {
 			try {
 				std::string FileContent;
 				if (Utils::wgets(url, FileContent)) {
-					std::ofstream OutputStream(Daemon()->AssetDir() + "/" + filename,
-											   std::ios_base::out | std::ios_base::trunc);
-					OutputStream << FileContent;
+					//	Write aside and rename so the asset server never sees a partial file.
+					auto FileName = Daemon()->AssetDir() + "/" + filename;
+					{
+						std::ofstream OutputStream(FileName + ".download",
+												   std::ios_base::out | std::ios_base::trunc);
+						OutputStream << FileContent;
+					}
+					Poco::File(FileName + ".download").renameTo(FileName);
+					AssetCache()->Invalidate(filename);
 					Logger().warning(Poco::format("File %s was downloaded", url));
 				}
 			} catch (...) {
@@ -4,8 +4,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <fstream>
+#include <shared_mutex>
+
+#include "Poco/ExpireLRUCache.h"
+#include "Poco/File.h"
 #include "Poco/Net/IPAddress.h"
+#include "Poco/NumberParser.h"
+#include "Poco/String.h"
+#include "Poco/StringTokenizer.h"
+#include "Poco/Timer.h"
 
+#include "framework/MetricsRegistry.h"
 #include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
 
@@ -16,8 +27,17 @@ namespace OpenWifi {
 	class IPToCountryProvider {
 	  public:
 		virtual bool Init() = 0;
-		virtual Poco::URI URI(const std::string &IPAddress) = 0;
-		virtual std::string Country(const std::string &Response) = 0;
+		virtual Poco::URI URI([[maybe_unused]] const std::string &IPAddress) { return {}; }
+		virtual std::string Country([[maybe_unused]] const std::string &Response) { return ""; }
+		//	Remote providers answer through URI() and Country(); local ones override this.
+		virtual std::string Lookup(const std::string &IPAddress) {
+			std::string Response;
+			if (Utils::wgets(URI(IPAddress).toString(), Response))
+				return Country(Response);
+			return "";
+		}
+		//	Returns true when the provider's data changed, so cached answers must be dropped.
+		virtual bool Refresh() { return false; }
 		virtual ~IPToCountryProvider(){};
 	};
 
@@ -113,6 +133,196 @@ namespace OpenWifi {
 		std::string Key_;
 	};
 
+	//	Offline provider: a CSV of address ranges loaded into a sorted table and searched with a
+	//	binary search. Each line is "first,last,CC" (addresses or decimal numbers, as in the
+	//	common free range databases) or "prefix/len,CC". IPv4 is stored as IPv4-mapped IPv6.
+	class IPRangeTable : public IPToCountryProvider {
+	  public:
+		static std::string Name() { return "local"; }
+
+		//	A missing file is not an error: it is picked up by the next reload once it appears.
+		//	Lookups meanwhile find nothing, so the default country is used.
+		inline bool Init() override {
+			FileName_ = MicroServiceConfigGetString("iptocountry.local.file",
+													MicroServiceDataDirectory() + "/ip2country.csv");
+			if (!Refresh())
+				poco_warning(Poco::Logger::get("IPTOC-SVR"),
+							 fmt::format("No address ranges loaded from {} yet.", FileName_));
+			return true;
+		}
+
+		inline std::string Lookup(const std::string &IPAddress) override {
+			Poco::Net::IPAddress IP;
+			if (!Poco::Net::IPAddress::tryParse(IPAddress, IP))
+				return "";
+			auto Key = ToKey(IP);
+			std::shared_ptr<const Table> T;
+			{
+				std::shared_lock G(Mutex_);
+				T = Table_;
+			}
+			if (T == nullptr)
+				return "";
+			auto It = std::upper_bound(
+				T->begin(), T->end(), Key,
+				[](const Key_t &K, const Range &R) { return K < R.First; });
+			if (It == T->begin())
+				return "";
+			--It;
+			return Key <= It->Last ? std::string(It->Country, 2) : "";
+		}
+
+		//	Reloads the table when the file changed. The old table stays in use until the new
+		//	one is complete.
+		inline bool Refresh() override {
+			try {
+				Poco::File F(FileName_);
+				if (!F.exists())
+					return false;
+				auto Modified = F.getLastModified().epochTime();
+				if (Modified == Modified_)
+					return false;
+				auto T = Load(FileName_);
+				if (T == nullptr)
+					return false;
+				poco_information(Poco::Logger::get("IPTOC-SVR"),
+								 fmt::format("Loaded {} address ranges from {}.", T->size(),
+											 FileName_));
+				std::unique_lock G(Mutex_);
+				Table_ = std::move(T);
+				Modified_ = Modified;
+				return true;
+			} catch (const Poco::Exception &E) {
+				Poco::Logger::get("IPTOC-SVR").log(E);
+			} catch (const std::exception &E) {
+				poco_error(Poco::Logger::get("IPTOC-SVR"),
+						   fmt::format("Cannot load {}: {}", FileName_, E.what()));
+			}
+			return false;
+		}
+
+	  private:
+		using Key_t = std::pair<std::uint64_t, std::uint64_t>;
+		struct Range {
+			Key_t First, Last;
+			char Country[2];
+		};
+		using Table = std::vector<Range>;
+
+		std::string FileName_;
+		std::time_t Modified_ = 0;
+		std::shared_mutex Mutex_;
+		std::shared_ptr<const Table> Table_;
+
+		static inline Key_t ToKey(const Poco::Net::IPAddress &IP) {
+			if (IP.family() == Poco::Net::IPAddress::IPv4) {
+				auto Bytes = (const unsigned char *)IP.addr();
+				return {0, 0x0000ffff00000000ULL | ((std::uint64_t)Bytes[0] << 24) |
+							   ((std::uint64_t)Bytes[1] << 16) | ((std::uint64_t)Bytes[2] << 8) |
+							   (std::uint64_t)Bytes[3]};
+			}
+			auto Bytes = (const unsigned char *)IP.addr();
+			Key_t K{0, 0};
+			for (int i = 0; i < 8; i++) {
+				K.first = (K.first << 8) | Bytes[i];
+				K.second = (K.second << 8) | Bytes[i + 8];
+			}
+			return K;
+		}
+
+		//	A decimal number as used by range databases: < 2^32 is IPv4, otherwise IPv6. Numbers
+		//	past 2^128 are rejected.
+		static inline bool DecimalToKey(const std::string &S, Key_t &K) {
+			if (S.empty() || S.find_first_not_of("0123456789") != std::string::npos)
+				return false;
+			std::uint64_t Hi = 0, Lo = 0;
+			for (auto c : S) {
+				//	(Hi, Lo) = (Hi, Lo) * 10 + digit, with Lo in two 32 bit halves.
+				std::uint64_t Low = (Lo & 0xffffffffULL) * 10 + (std::uint64_t)(c - '0');
+				std::uint64_t High = (Lo >> 32) * 10 + (Low >> 32);
+				std::uint64_t Carry = High >> 32;
+				Lo = (High << 32) | (Low & 0xffffffffULL);
+				if (Hi > (~0ULL - Carry) / 10)
+					return false;
+				Hi = Hi * 10 + Carry;
+			}
+			if (Hi == 0 && Lo <= 0xffffffffULL)
+				Lo |= 0x0000ffff00000000ULL;
+			K = {Hi, Lo};
+			return true;
+		}
+
+		static inline bool ParseKey(const std::string &S, Key_t &K) {
+			Poco::Net::IPAddress IP;
+			if (Poco::Net::IPAddress::tryParse(S, IP)) {
+				K = ToKey(IP);
+				return true;
+			}
+			return DecimalToKey(S, K);
+		}
+
+		static inline bool ParsePrefix(const std::string &S, Key_t &First, Key_t &Last) {
+			auto Slash = S.find('/');
+			Poco::Net::IPAddress IP;
+			if (Slash == std::string::npos || !Poco::Net::IPAddress::tryParse(S.substr(0, Slash), IP))
+				return false;
+			int Len;
+			if (!Poco::NumberParser::tryParse(S.substr(Slash + 1), Len))
+				return false;
+			if (IP.family() == Poco::Net::IPAddress::IPv4)
+				Len += 96;
+			if (Len < 0 || Len > 128)
+				return false;
+			First = ToKey(IP);
+			auto HostBits = 128 - Len;
+			Key_t Mask{HostBits >= 64 ? (HostBits >= 128 ? ~0ULL : (1ULL << (HostBits - 64)) - 1)
+									  : 0,
+					   HostBits >= 64 ? ~0ULL : (HostBits == 0 ? 0 : (1ULL << HostBits) - 1)};
+			First = {First.first & ~Mask.first, First.second & ~Mask.second};
+			Last = {First.first | Mask.first, First.second | Mask.second};
+			return true;
+		}
+
+		static inline std::string Unquote(std::string S) {
+			Poco::trimInPlace(S);
+			if (S.size() >= 2 && S.front() == '"' && S.back() == '"')
+				S = S.substr(1, S.size() - 2);
+			return S;
+		}
+
+		static std::shared_ptr<const Table> Load(const std::string &FileName) {
+			std::ifstream In(FileName);
+			if (!In)
+				return nullptr;
+			auto T = std::make_shared<Table>();
+			std::string Line;
+			while (std::getline(In, Line)) {
+				if (Line.empty() || Line[0] == '#')
+					continue;
+				Poco::StringTokenizer Fields(Line, ",");
+				Range R{};
+				std::string Country;
+				if (Fields.count() >= 3 && ParseKey(Unquote(Fields[0]), R.First) &&
+					ParseKey(Unquote(Fields[1]), R.Last)) {
+					Country = Unquote(Fields[2]);
+				} else if (Fields.count() >= 2 && ParsePrefix(Unquote(Fields[0]), R.First, R.Last)) {
+					Country = Unquote(Fields[1]);
+				} else {
+					continue;
+				}
+				if (Country.size() != 2 || Country == "-" || R.Last < R.First)
+					continue;
+				R.Country[0] = Country[0];
+				R.Country[1] = Country[1];
+				T->push_back(R);
+			}
+			std::sort(T->begin(), T->end(),
+					  [](const Range &A, const Range &B) { return A.First < B.First; });
+			T->shrink_to_fit();
+			return T;
+		}
+	};
+
 	template <typename BaseClass, typename T, typename... Args>
 	std::unique_ptr<BaseClass> IPLocationProvider(const std::string &RequestProvider) {
 		if (T::Name() == RequestProvider) {
@@ -136,22 +346,38 @@ namespace OpenWifi {
 			poco_notice(Logger(), "Starting...");
 			ProviderName_ = MicroServiceConfigGetString("iptocountry.provider", "");
 			if (!ProviderName_.empty()) {
-				Provider_ = IPLocationProvider<IPToCountryProvider, IPInfo, IPData, IP2Location>(
-					ProviderName_);
+				Provider_ = IPLocationProvider<IPToCountryProvider, IPRangeTable, IPInfo, IPData,
+											   IP2Location>(ProviderName_);
 				if (Provider_ != nullptr) {
 					Enabled_ = Provider_->Init();
 				}
 			}
 			Default_ = MicroServiceConfigGetString("iptocountry.default", "US");
+			Cache_ = std::make_unique<Poco::ExpireLRUCache<std::string, std::string>>(
+				MicroServiceConfigGetInt("iptocountry.cache.size", 4096),
+				MicroServiceConfigGetInt("iptocountry.cache.ttl", 24 * 60 * 60) * 1000);
+			if (Enabled_ && ProviderName_ == IPRangeTable::Name()) {
+				auto Period = MicroServiceConfigGetInt("iptocountry.local.reload", 300) * 1000;
+				RefreshCallback_ = std::make_unique<Poco::TimerCallback<FindCountryFromIP>>(
+					*this, &FindCountryFromIP::onRefresh);
+				Timer_.setStartInterval(Period);
+				Timer_.setPeriodicInterval(Period);
+				Timer_.start(*RefreshCallback_);
+			}
 			return 0;
 		}
 
 		inline void Stop() final {
 			poco_notice(Logger(), "Stopping...");
-			//	Nothing to do - just to provide the same look at the others.
+			Timer_.stop();
 			poco_notice(Logger(), "Stopped...");
 		}
 
+		inline void onRefresh([[maybe_unused]] Poco::Timer &timer) {
+			if (Provider_->Refresh())
+				Cache_->clear();
+		}
+
 		[[nodiscard]] static inline std::string ReformatAddress(const std::string &I) {
 			if (I.substr(0, 7) == "::ffff:") {
 				std::string ip = I.substr(7);
@@ -169,13 +395,16 @@ namespace OpenWifi {
 		inline std::string Get(const std::string &IP) {
 			if (!Enabled_)
 				return Default_;
+			if (auto Hit = Cache_->get(IP); !Hit.isNull()) {
+				CacheStats_.Hit();
+				return *Hit;
+			}
+			CacheStats_.Miss();
 			try {
-				std::string URL = Provider_->URI(IP).toString();
-				std::string Response;
-				if (Utils::wgets(URL, Response)) {
-					auto Answer = Provider_->Country(Response);
-					if (!Answer.empty())
-						return Answer;
+				auto Answer = Provider_->Lookup(IP);
+				if (!Answer.empty()) {
+					Cache_->add(IP, Answer);
+					return Answer;
 				}
 			} catch (...) {
 			}
@@ -186,9 +415,13 @@ namespace OpenWifi {
 
 	  private:
 		bool Enabled_ = false;
+		MetricsCacheStats CacheStats_{"iptocountry"};
 		std::string Default_;
 		std::unique_ptr<IPToCountryProvider> Provider_;
 		std::string ProviderName_;
+		std::unique_ptr<Poco::ExpireLRUCache<std::string, std::string>> Cache_;
+		Poco::Timer Timer_;
+		std::unique_ptr<Poco::TimerCallback<FindCountryFromIP>> RefreshCallback_;
 
 		FindCountryFromIP() noexcept : SubSystemServer("IpToCountry", "IPTOC-SVR", "iptocountry") {}
 	};
@@ -0,0 +1,106 @@
+//
+// Created by stephane bourque on 2023-11-30.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "RESTObjects/RESTAPI_ProvObjects.h"
+
+namespace OpenWifi::InventoryCSV {
+
+	//	Columns, in export order. Import finds them by the names in its header record.
+	inline const std::vector<std::string> Columns{
+		"serialNumber",		  "name",			  "description", "deviceType", "devClass",
+		"entity",			  "venue",			  "subscriber",	 "location",   "contact",
+		"deviceConfiguration", "managementPolicy", "state",		 "locale",	   "realMacAddress",
+		"platform",			  "qrCode",			  "geoCode",	 "doNotAllowOverrides"};
+
+	inline std::string Field(const std::string &V) {
+		if (V.find_first_of(",\"\r\n") == std::string::npos)
+			return V;
+		std::string Quoted{"\""};
+		for (const auto &c : V) {
+			if (c == '"')
+				Quoted += '"';
+			Quoted += c;
+		}
+		return Quoted + "\"";
+	}
+
+	inline void WriteHeader(std::ostream &Out) {
+		for (std::size_t i = 0; i < Columns.size(); ++i)
+			Out << (i ? "," : "") << Columns[i];
+		Out << "\r\n";
+	}
+
+	inline void Write(std::ostream &Out, const ProvObjects::InventoryTag &T) {
+		for (const auto &V :
+			 {T.serialNumber, T.info.name, T.info.description, T.deviceType, T.devClass, T.entity,
+			  T.venue, T.subscriber, T.location, T.contact, T.deviceConfiguration,
+			  T.managementPolicy, T.state, T.locale, T.realMacAddress, T.platform, T.qrCode,
+			  T.geoCode}) {
+			Out << Field(V) << ',';
+		}
+		Out << (T.doNotAllowOverrides ? "true" : "false") << "\r\n";
+	}
+
+	//	Reads one record, as in RFC 4180: records end with LF or CRLF, and quoted fields may hold
+	//	commas, line breaks and quotes written as "". Lines is set to the number of lines the
+	//	record took. Returns false at the end of the stream. An empty line is a record with one
+	//	empty field.
+	inline bool Read(std::istream &In, std::vector<std::string> &Fields, std::uint64_t &Lines) {
+		Fields.assign(1, std::string{});
+		Lines = 0;
+		bool Quoted = false, Any = false;
+		char c;
+		while (In.get(c)) {
+			Any = true;
+			if (Quoted) {
+				if (c == '"' && In.peek() == '"') {
+					In.get(c);
+					Fields.back() += '"';
+				} else if (c == '"') {
+					Quoted = false;
+				} else {
+					if (c == '\n')
+						++Lines;
+					Fields.back() += c;
+				}
+			} else if (c == '"') {
+				Quoted = true;
+			} else if (c == ',') {
+				Fields.emplace_back();
+			} else if (c == '\n') {
+				++Lines;
+				return true;
+			} else if (c != '\r' || In.peek() != '\n') {
+				Fields.back() += c;
+			}
+		}
+		if (Any)
+			++Lines;
+		return Any;
+	}
+
+	//	The JSON object of a record, with the fields named in Header. Unknown columns are ignored.
+	inline Poco::JSON::Object::Ptr Row(const std::vector<std::string> &Header,
+									   const std::vector<std::string> &Values) {
+		auto Row = Poco::makeShared<Poco::JSON::Object>();
+		for (std::size_t i = 0; i < Header.size() && i < Values.size(); ++i) {
+			if (Header[i] == "doNotAllowOverrides")
+				Row->set(Header[i], Values[i] == "true" || Values[i] == "1");
+			else if (std::find(Columns.begin(), Columns.end(), Header[i]) != Columns.end())
+				Row->set(Header[i], Values[i]);
+		}
+		return Row;
+	}
+
+} // namespace OpenWifi::InventoryCSV
@@ -0,0 +1,394 @@
+//
+// Created by stephane bourque on 2023-12-01.
+//
+
+#include <algorithm>
+#include <cctype>
+
+#include "InventorySearchIndex.h"
+#include "StorageService.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	namespace {
+		constexpr char Boundary = '\x01';
+		constexpr std::size_t MaxDescription = 256;
+
+		//	Lowercases S onto Out, turning each run of characters other than letters and digits
+		//	into one boundary. Out must end with a boundary, and still does.
+		void AppendWords(const std::string &S, std::string &Out) {
+			for (auto C : S) {
+				if (std::isalnum((unsigned char)C))
+					Out += (char)std::tolower((unsigned char)C);
+				else if (Out.back() != Boundary)
+					Out += Boundary;
+			}
+			if (Out.back() != Boundary)
+				Out += Boundary;
+		}
+
+		std::string WithoutColons(const std::string &S) {
+			std::string R;
+			std::copy_if(S.begin(), S.end(), std::back_inserter(R),
+						 [](char C) { return C != ':'; });
+			return R;
+		}
+
+		bool LooksLikeMac(const std::string &S) {
+			return S.find(':') != std::string::npos &&
+				   std::all_of(S.begin(), S.end(),
+							   [](char C) { return C == ':' || std::isxdigit((unsigned char)C); });
+		}
+	} // namespace
+
+	int InventorySearchIndex::Start() {
+		Active_ = MicroServiceConfigGetBool("inventory.search.enabled", true);
+		if (!Active_) {
+			poco_information(Logger(), "Disabled: inventory searches use SQL.");
+			return 0;
+		}
+		poco_information(Logger(), "Starting...");
+		Rebuild();
+		std::lock_guard G(RebuildMutex_);
+		Running_ = true;
+		Rebuilder_ = std::thread([this] { Rebuilder(); });
+		return 0;
+	}
+
+	void InventorySearchIndex::Stop() {
+		poco_information(Logger(), "Stopping...");
+		{
+			std::lock_guard G(RebuildMutex_);
+			Running_ = false;
+		}
+		RebuildCV_.notify_all();
+		if (Rebuilder_.joinable())
+			Rebuilder_.join();
+		Active_ = Ready_ = false;
+		std::unique_lock G(IndexMutex_);
+		Live_ = Tables{};
+		Journal_.clear();
+		Journaling_ = false;
+		poco_information(Logger(), "Stopped...");
+	}
+
+	//	Builds a new index from the table, then swaps it in. The current index keeps answering
+	//	and taking writes meanwhile; those writes are also journaled and replayed on the new
+	//	one, so nothing deleted comes back and nothing created goes missing.
+	void InventorySearchIndex::Rebuild() {
+		{
+			std::unique_lock G(IndexMutex_);
+			Journal_.clear();
+			Journaling_ = true;
+		}
+		Tables Next;
+		StorageService()->InventoryDB().Iterate([&Next](const ProvObjects::InventoryTag &T) {
+			if (!T.info.id.empty())
+				Next.Update(MakeDocument(T));
+			return true;
+		});
+
+		std::unique_lock G(IndexMutex_);
+		for (auto &C : Journal_) {
+			if (C.FieldName.empty())
+				Next.Update(std::move(C.D));
+			else
+				Next.Remove(C.FieldName, C.Value);
+		}
+		Journal_.clear();
+		Journaling_ = false;
+		Live_ = std::move(Next);
+		Ready_ = true;
+		poco_information(Logger(), fmt::format("Indexed {} devices.", Live_.ById.size()));
+	}
+
+	void InventorySearchIndex::RequestRebuild() {
+		{
+			std::lock_guard G(RebuildMutex_);
+			RebuildRequested_ = true;
+		}
+		RebuildCV_.notify_one();
+	}
+
+	//	Requests made during a rebuild are served by one more rebuild after it.
+	void InventorySearchIndex::Rebuilder() {
+		Utils::SetThreadName("inv-reindex");
+		while (true) {
+			{
+				std::unique_lock G(RebuildMutex_);
+				RebuildCV_.wait(G, [this] { return !Running_ || RebuildRequested_; });
+				if (!Running_)
+					return;
+				RebuildRequested_ = false;
+			}
+			Rebuild();
+		}
+	}
+
+	void InventorySearchIndex::Add(const ProvObjects::InventoryTag &T) {
+		if (!Active_ || T.info.id.empty())
+			return;
+		auto D = MakeDocument(T);
+		std::unique_lock G(IndexMutex_);
+		if (Journaling_)
+			Journal_.push_back(Change{D, "", ""});
+		Live_.Update(std::move(D));
+	}
+
+	void InventorySearchIndex::Remove(const std::string &FieldName, const std::string &Value) {
+		if (!Active_)
+			return;
+		{
+			std::unique_lock G(IndexMutex_);
+			if (Journaling_)
+				Journal_.push_back(Change{Document{}, FieldName, Value});
+			if (Live_.Remove(FieldName, Value))
+				return;
+		}
+		//	The index does not hold that field: the table knows what is left.
+		poco_information(Logger(),
+						 fmt::format("Devices deleted by {}: rebuilding the index.", FieldName));
+		RequestRebuild();
+	}
+
+	void InventorySearchIndex::Tables::Update(Document &&D) {
+		if (auto It = ById.find(D.Id); It != ById.end()) {
+			auto Id = It->second;
+			if (Docs[Id].SameAs(D))
+				return;
+			Unlink(Id);
+			Docs[Id] = std::move(D);
+			Link(Id);
+			return;
+		}
+		//	A device created again under a new id replaces the old one.
+		if (auto It = BySerial.find(D.SerialNumber); It != BySerial.end())
+			Unlink(It->second);
+		auto Id = (DocId)Docs.size();
+		Docs.emplace_back(std::move(D));
+		Link(Id);
+		Compact();
+	}
+
+	bool InventorySearchIndex::Tables::Remove(const std::string &FieldName,
+											  const std::string &Value) {
+		if (FieldName == "id" || FieldName == "serialNumber") {
+			auto &Map = FieldName == "id" ? ById : BySerial;
+			if (auto It = Map.find(Value); It != Map.end())
+				Unlink(It->second);
+		} else if (FieldName == "entity" || FieldName == "venue") {
+			for (DocId Id = 0; Id < Docs.size(); ++Id) {
+				const auto &D = Docs[Id];
+				if (D.Live && (FieldName == "entity" ? D.Entity : D.Venue) == Value)
+					Unlink(Id);
+			}
+		} else {
+			return false;
+		}
+		Compact();
+		return true;
+	}
+
+	bool InventorySearchIndex::Search(const Query &Q, std::vector<Match> &Matches,
+									  std::uint64_t &Total) {
+		Total = 0;
+		if (!Ready_)
+			return false;
+
+		auto N = Needle(Q.Text, Q.Prefix);
+		std::vector<std::uint32_t> Keys;
+		GramsOf(N, Keys);
+
+		std::shared_lock G(IndexMutex_);
+		std::vector<const Postings *> Lists;
+		for (auto K : Keys) {
+			auto It = Live_.Grams.find(K);
+			if (It == Live_.Grams.end())
+				return true;
+			Lists.push_back(&It->second);
+		}
+		for (auto Tag : Q.Tags) {
+			auto It = Live_.TagPostings.find(Tag);
+			if (It == Live_.TagPostings.end())
+				return true;
+			Lists.push_back(&It->second);
+		}
+
+		Postings Candidates;
+		if (Lists.empty()) {
+			for (const auto &[Id, Doc] : Live_.ById)
+				Candidates.push_back(Doc);
+		} else {
+			std::sort(Lists.begin(), Lists.end(),
+					  [](const Postings *A, const Postings *B) { return A->size() < B->size(); });
+			Candidates = *Lists.front();
+			for (std::size_t i = 1; i < Lists.size() && !Candidates.empty(); ++i) {
+				Postings Next;
+				std::set_intersection(Candidates.begin(), Candidates.end(), Lists[i]->begin(),
+									  Lists[i]->end(), std::back_inserter(Next));
+				Candidates.swap(Next);
+			}
+		}
+
+		std::vector<DocId> Hits;
+		for (auto Id : Candidates) {
+			const auto &D = Live_.Docs[Id];
+			if (!D.Live || (!N.empty() && D.Text.find(N) == std::string::npos))
+				continue;
+			if ((!Q.Entity.empty() && D.Entity != Q.Entity) ||
+				(!Q.Venue.empty() && D.Venue != Q.Venue))
+				continue;
+			if ((Q.Entities || Q.Venues) && !(Q.Entities && Q.Entities->count(D.Entity)) &&
+				!(Q.Venues && Q.Venues->count(D.Venue)))
+				continue;
+			Hits.push_back(Id);
+		}
+
+		Total = Hits.size();
+		if (Q.Offset >= Total)
+			return true;
+		auto End = std::min<std::uint64_t>(Total, Q.Offset + Q.Limit);
+		std::partial_sort(Hits.begin(), Hits.begin() + (std::ptrdiff_t)End, Hits.end(),
+						  [this](DocId A, DocId B) {
+							  return Live_.Docs[A].SerialNumber < Live_.Docs[B].SerialNumber;
+						  });
+		for (auto i = Q.Offset; i < End; ++i) {
+			const auto &D = Live_.Docs[Hits[i]];
+			Matches.emplace_back(Match{D.Id, D.SerialNumber});
+		}
+		return true;
+	}
+
+	InventorySearchIndex::Document
+	InventorySearchIndex::MakeDocument(const ProvObjects::InventoryTag &T) {
+		Document D;
+		D.Id = T.info.id;
+		D.SerialNumber = T.serialNumber;
+		D.Entity = T.entity;
+		D.Venue = T.venue;
+		D.Tags = T.info.tags;
+		std::sort(D.Tags.begin(), D.Tags.end());
+		D.Tags.erase(std::unique(D.Tags.begin(), D.Tags.end()), D.Tags.end());
+		D.Text = Boundary;
+		AppendWords(T.serialNumber, D.Text);
+		AppendWords(T.info.name, D.Text);
+		AppendWords(T.info.description.substr(0, MaxDescription), D.Text);
+		AppendWords(WithoutColons(T.realMacAddress), D.Text);
+		return D;
+	}
+
+	//	What a query must find in a document's text: its words with a boundary in front, so they
+	//	start a word, unless it is an infix query of at least 3 characters. MAC addresses are
+	//	indexed without their colons.
+	std::string InventorySearchIndex::Needle(const std::string &Text, bool Prefix) {
+		std::string N{Boundary};
+		AppendWords(LooksLikeMac(Text) ? WithoutColons(Text) : Text, N);
+		N.pop_back();
+		if (N.size() <= 1)
+			return "";
+		if (!Prefix && N.size() > 3)
+			N.erase(0, 1);
+		return N;
+	}
+
+	//	Every trigram of S, and a key for the first character of each word so that one letter
+	//	queries have a posting list too.
+	void InventorySearchIndex::GramsOf(const std::string &S, std::vector<std::uint32_t> &Keys) {
+		for (std::size_t i = 0; i + 2 < S.size(); ++i)
+			Keys.push_back((std::uint32_t)(unsigned char)S[i] << 16 |
+						   (std::uint32_t)(unsigned char)S[i + 1] << 8 |
+						   (std::uint32_t)(unsigned char)S[i + 2]);
+		for (std::size_t i = 0; i + 1 < S.size(); ++i)
+			if (S[i] == Boundary && S[i + 1] != Boundary)
+				Keys.push_back(0x01000000u | (std::uint32_t)(unsigned char)S[i + 1]);
+		std::sort(Keys.begin(), Keys.end());
+		Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+	}
+
+	//	Documents only get new ids, so insertions nearly always append.
+	void InventorySearchIndex::Insert(Postings &P, DocId Id) {
+		if (P.empty() || P.back() < Id) {
+			P.push_back(Id);
+			return;
+		}
+		auto It = std::lower_bound(P.begin(), P.end(), Id);
+		if (It == P.end() || *It != Id)
+			P.insert(It, Id);
+	}
+
+	void InventorySearchIndex::Erase(Postings &P, DocId Id) {
+		auto It = std::lower_bound(P.begin(), P.end(), Id);
+		if (It != P.end() && *It == Id)
+			P.erase(It);
+	}
+
+	void InventorySearchIndex::Tables::Link(DocId Id) {
+		auto &D = Docs[Id];
+		D.Live = true;
+		ById[D.Id] = Id;
+		BySerial[D.SerialNumber] = Id;
+		std::vector<std::uint32_t> Keys;
+		GramsOf(D.Text, Keys);
+		for (auto K : Keys)
+			Insert(Grams[K], Id);
+		for (auto Tag : D.Tags)
+			Insert(TagPostings[Tag], Id);
+	}
+
+	void InventorySearchIndex::Tables::Unlink(DocId Id) {
+		auto &D = Docs[Id];
+		if (!D.Live)
+			return;
+		std::vector<std::uint32_t> Keys;
+		GramsOf(D.Text, Keys);
+		for (auto K : Keys) {
+			auto It = Grams.find(K);
+			if (It == Grams.end())
+				continue;
+			Erase(It->second, Id);
+			if (It->second.empty())
+				Grams.erase(It);
+		}
+		for (auto Tag : D.Tags) {
+			auto It = TagPostings.find(Tag);
+			if (It == TagPostings.end())
+				continue;
+			Erase(It->second, Id);
+			if (It->second.empty())
+				TagPostings.erase(It);
+		}
+		if (auto It = ById.find(D.Id); It != ById.end() && It->second == Id)
+			ById.erase(It);
+		if (auto It = BySerial.find(D.SerialNumber); It != BySerial.end() && It->second == Id)
+			BySerial.erase(It);
+		D = Document{};
+	}
+
+	//	Deleted devices leave empty slots in Docs. Once they outnumber the live ones, the live
+	//	documents are renumbered and the postings rebuilt.
+	void InventorySearchIndex::Tables::Compact() {
+		auto Dead = Docs.size() - ById.size();
+		if (Dead < 1024 || Dead < ById.size())
+			return;
+		std::vector<Document> Live;
+		Live.reserve(ById.size());
+		for (auto &D : Docs)
+			if (D.Live)
+				Live.emplace_back(std::move(D));
+		Docs.clear();
+		ById.clear();
+		BySerial.clear();
+		Grams.clear();
+		TagPostings.clear();
+		for (auto &D : Live) {
+			auto Id = (DocId)Docs.size();
+			Docs.emplace_back(std::move(D));
+			Link(Id);
+		}
+	}
+
+} // namespace OpenWifi
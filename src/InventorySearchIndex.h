@@ -0,0 +1,138 @@
+//
+// Created by stephane bourque on 2023-12-01.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "RESTObjects/RESTAPI_ProvObjects.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Posting lists over the serial number, name, description and MAC address of every device,
+	//	and over its tags, so inventory searches do not scan the table. Text is indexed by
+	//	trigrams, with word starts marked: an infix query intersects the lists of its trigrams, a
+	//	prefix query those of its marked ones, and the candidates are then checked against the
+	//	text. InventoryDB keeps it current as records are created, updated and deleted; reads
+	//	never change it, so a read from a lagging replica cannot bring back older values. A
+	//	delete the index cannot apply by itself (by a field it does not hold) schedules a
+	//	rebuild: a new index is built from the table on a background thread, with the writes
+	//	made meanwhile replayed on it, and then replaces the current one.
+	class InventorySearchIndex : public SubSystemServer {
+	  public:
+		struct Query {
+			std::string Text;
+			bool Prefix = false;   //	match word starts only
+			Types::TagList Tags;   //	every tag must be on the device
+			std::string Entity;	   //	exact filters, when set
+			std::string Venue;
+			//	RBAC scope, when set: a device matches if its entity or its venue is listed.
+			const std::set<std::string> *Entities = nullptr;
+			const std::set<std::string> *Venues = nullptr;
+			std::uint64_t Offset = 0;
+			std::uint64_t Limit = 100;
+		};
+
+		struct Match {
+			std::string Id;
+			std::string SerialNumber;
+		};
+
+		static auto instance() {
+			static auto instance_ = new InventorySearchIndex;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+
+		//	A device created or updated.
+		void Add(const ProvObjects::InventoryTag &T);
+		void Remove(const std::string &FieldName, const std::string &Value);
+
+		//	Matches in serial number order, Offset and Limit applied, and how many there are in
+		//	all. Returns false while the index is disabled or loading: callers then use SQL.
+		bool Search(const Query &Q, std::vector<Match> &Matches, std::uint64_t &Total);
+
+	  private:
+		using DocId = std::uint32_t;
+		using Postings = std::vector<DocId>;
+
+		struct Document {
+			std::string Id;
+			std::string SerialNumber;
+			std::string Entity;
+			std::string Venue;
+			std::string Text;
+			Types::TagList Tags;
+			bool Live = false;
+
+			[[nodiscard]] inline bool SameAs(const Document &D) const {
+				return SerialNumber == D.SerialNumber && Entity == D.Entity && Venue == D.Venue &&
+					   Text == D.Text && Tags == D.Tags;
+			}
+		};
+
+		//	One complete index: the live one, or one being rebuilt.
+		struct Tables {
+			std::vector<Document> Docs;
+			std::unordered_map<std::string, DocId> ById;
+			std::unordered_map<std::string, DocId> BySerial;
+			std::unordered_map<std::uint32_t, Postings> Grams;
+			std::unordered_map<std::uint64_t, Postings> TagPostings;
+
+			void Update(Document &&D);
+			//	False when the index does not hold FieldName.
+			bool Remove(const std::string &FieldName, const std::string &Value);
+			void Link(DocId Id);
+			void Unlink(DocId Id);
+			void Compact();
+		};
+
+		//	A write made while a rebuild reads the table.
+		struct Change {
+			Document D; //	created or updated, when FieldName is empty
+			std::string FieldName, Value;
+		};
+
+		std::shared_mutex IndexMutex_;
+		Tables Live_;
+		bool Journaling_ = false;
+		std::vector<Change> Journal_;
+		std::atomic_bool Active_ = false;
+		std::atomic_bool Ready_ = false;
+
+		std::mutex RebuildMutex_;
+		std::condition_variable RebuildCV_;
+		std::thread Rebuilder_;
+		bool Running_ = false;
+		bool RebuildRequested_ = false;
+
+		static Document MakeDocument(const ProvObjects::InventoryTag &T);
+		static std::string Needle(const std::string &Text, bool Prefix);
+		static void GramsOf(const std::string &S, std::vector<std::uint32_t> &Keys);
+		static void Insert(Postings &P, DocId Id);
+		static void Erase(Postings &P, DocId Id);
+
+		void Rebuild();
+		void RequestRebuild();
+		void Rebuilder();
+
+		InventorySearchIndex() noexcept
+			: SubSystemServer("InventorySearchIndex", "INV-SEARCH", "inventory.search") {}
+	};
+
+	inline auto InventorySearchIndex() { return InventorySearchIndex::instance(); }
+
+} // namespace OpenWifi
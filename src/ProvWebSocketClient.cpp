@@ -4,6 +4,8 @@
 
 #include "ProvWebSocketClient.h"
 
+#include "InventorySearchIndex.h"
+#include "RESTAPI/RESTAPI_db_helpers.h"
 #include "SerialNumberCache.h"
 #include "StorageService.h"
 #include "framework/UI_WebSocketClientServer.h"
@@ -117,10 +119,50 @@ namespace OpenWifi {
 		Answer = SS.str();
 	}
 
+	void ProvWebSocketClient::ws_command_inventory_search(
+		const Poco::JSON::Object::Ptr &O, bool &Done, std::string &Answer,
+		const SecurityObjects::UserInfo &UserInfo) {
+		Done = false;
+		InventorySearchIndex::Query Q;
+		Q.Text = O->optValue<std::string>("text", "");
+		Q.Prefix = O->optValue<std::string>("mode", "infix") == "prefix";
+		if (O->isArray("tags")) {
+			for (const auto &Tag : *O->getArray("tags"))
+				Q.Tags.push_back(Tag.convert<std::uint64_t>());
+		}
+		Q.Limit = std::min<std::uint64_t>(O->optValue<std::uint64_t>("limit", 50), 200);
+
+		std::set<std::string> Entities, Venues;
+		if (UserInfo.userRole != SecurityObjects::ROOT) {
+			InventoryReadScope(UserInfo.id, Entities, Venues);
+			Q.Entities = &Entities;
+			Q.Venues = &Venues;
+		}
+
+		std::vector<InventorySearchIndex::Match> Matches;
+		std::uint64_t Total = 0;
+		if (!InventorySearchIndex()->Search(Q, Matches, Total)) {
+			Answer = std::string{R"lit({ "error" : "inventory search is not available" })lit"};
+			return;
+		}
+		Poco::JSON::Array Arr;
+		for (const auto &M : Matches) {
+			Poco::JSON::Object Device;
+			Device.set("id", M.Id);
+			Device.set("serialNumber", M.SerialNumber);
+			Arr.add(Device);
+		}
+		Poco::JSON::Object RetObj;
+		RetObj.set("devices", Arr);
+		RetObj.set("total", Total);
+		std::ostringstream SS;
+		Poco::JSON::Stringifier::stringify(RetObj, SS);
+		Answer = SS.str();
+	}
+
 	void
 	ProvWebSocketClient::Processor(const Poco::JSON::Object::Ptr &O, std::string &Result,
-								   bool &Done,
-								   [[maybe_unused]] const SecurityObjects::UserInfo &UserInfo) {
+								   bool &Done, const SecurityObjects::UserInfo &UserInfo) {
 		try {
 			if (O->has("command") && O->has("id")) {
 				auto id = (uint64_t)O->get("id");
@@ -128,6 +170,8 @@ namespace OpenWifi {
 				auto Command = O->get("command").toString();
 				if (Command == "serial_number_search" && O->has("serial_prefix")) {
 					ws_command_serial_number_search(O, Done, Answer);
+				} else if (Command == "inventory_search" && (O->has("text") || O->has("tags"))) {
+					ws_command_inventory_search(O, Done, Answer, UserInfo);
 				} else if (UI_WebSocketClientServer()->GeoCodeEnabled() &&
 						   Command == "address_completion" && O->has("address")) {
 					ws_command_address_completion(O, Done, Answer);
@@ -24,6 +24,9 @@ namespace OpenWifi {
 									   std::string &Answer);
 		void ws_command_subdevice_search(const Poco::JSON::Object::Ptr &O, bool &Done,
 										 std::string &Answer);
+		void ws_command_inventory_search(const Poco::JSON::Object::Ptr &O, bool &Done,
+										 std::string &Answer,
+										 const SecurityObjects::UserInfo &UserInfo);
 		std::string GoogleGeoCodeCall(const std::string &A);
 
 	  private:
@@ -3,19 +3,42 @@
 //
 
 #include "RESTAPI_asset_server.h"
-#include "Daemon.h"
-#include "Poco/File.h"
+#include "AssetCache.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/RESTAPI_JSONStreamWriter.h"
 #include "framework/ow_constants.h"
 
 namespace OpenWifi {
 	void RESTAPI_asset_server::DoGet() {
-		Poco::File AssetFile;
-
 		std::string AssetName = GetBinding(RESTAPI::Protocol::ID, "");
-		AssetFile = Daemon()->AssetDir() + "/" + AssetName;
-		if (!AssetFile.isFile()) {
+		auto Asset = AssetCache()->Get(AssetName);
+		if (Asset == nullptr) {
 			return NotFound();
 		}
-		SendFile(AssetFile);
+
+		static const auto CacheControl =
+			MicroServiceConfigGetString("assets.cachecontrol", "public, max-age=3600");
+		Response->set("Cache-Control", CacheControl);
+		//	Each encoding is its own representation, with its own ETag.
+		bool Gzip = !Asset->Gzipped.empty() && RESTAPI_JSONStreamWriter::AcceptsGzip(*Request);
+		if (!Asset->Gzipped.empty())
+			Response->set("Vary", "Accept-Encoding");
+		if (NotModified(Gzip ? Asset->GzippedETag : Asset->ETag, Asset->LastModified)) {
+			return;
+		}
+
+		PrepareResponse();
+		Response->setContentType(Asset->ContentType);
+		if (Asset->Binary) {
+			Response->set("Content-Transfer-Encoding", "binary");
+		}
+		Response->setChunkedTransferEncoding(false);
+		const std::string *Body = &Asset->Content;
+		if (Gzip) {
+			Response->set("Content-Encoding", "gzip");
+			Body = &Asset->Gzipped;
+		}
+		Response->setContentLength(Body->size());
+		Response->send().write(Body->data(), (std::streamsize)Body->size());
 	}
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
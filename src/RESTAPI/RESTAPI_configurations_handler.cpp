@@ -57,6 +57,8 @@ namespace OpenWifi {
 			return ReturnObject("affectedDevices", DeviceSerialNumbers);
 		} else if (QB_.AdditionalInfo) {
 			AddExtendedInfo(Existing, Answer);
+		} else if (NotModified(Existing)) {
+			return;
 		}
 		Existing.to_json(Answer);
 		ReturnObject(Answer);
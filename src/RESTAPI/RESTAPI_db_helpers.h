@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <array>
+#include <map>
+#include <optional>
+#include <set>
 #include <utility>
 
 #include "Poco/StringTokenizer.h"
@@ -22,129 +26,145 @@ namespace OpenWifi {
 		J.set("id", O.id);
 	}
 
-	template <typename R, typename Q = decltype(R{}.entity)>
-	void Extend_entity(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.entity.empty()) {
-				Poco::JSON::Object EntObj;
-				ProvObjects::Entity Entity;
-				if (StorageService()->EntityDB().GetRecord("id", T.entity, Entity)) {
-					AddInfoBlock(Entity.info, EntObj);
-				}
-				EI.set("entity", EntObj);
+	//	The references resolved into extendedInfo.
+	enum class ExtendedRef {
+		entity,
+		venue,
+		contact,
+		location,
+		managementPolicy,
+		deviceConfiguration,
+		count
+	};
+
+	//	Resolves references one record at a time, from the database.
+	class StorageNames {
+	  public:
+		std::optional<ProvObjects::ObjectInfo> Info(ExtendedRef Kind, const std::string &Id) const {
+			switch (Kind) {
+			case ExtendedRef::entity:
+				return Get(StorageService()->EntityDB(), Id);
+			case ExtendedRef::venue:
+				return Get(StorageService()->VenueDB(), Id);
+			case ExtendedRef::contact:
+				return Get(StorageService()->ContactDB(), Id);
+			case ExtendedRef::location:
+				return Get(StorageService()->LocationDB(), Id);
+			case ExtendedRef::managementPolicy:
+				return Get(StorageService()->PolicyDB(), Id);
+			case ExtendedRef::deviceConfiguration:
+				return Get(StorageService()->ConfigurationDB(), Id);
+			default:
+				return std::nullopt;
 			}
 		}
+
+		//	Email and description.
+		std::optional<std::pair<std::string, std::string>>
+		Subscriber(const std::string &Id) const {
+			ProvObjects::SignupEntry Signup;
+			if (StorageService()->SignupDB().GetRecord("userid", Id, Signup))
+				return std::make_pair(Signup.email, Signup.info.description);
+			return std::nullopt;
+		}
+
+	  private:
+		template <typename DB>
+		static std::optional<ProvObjects::ObjectInfo> Get(DB &DBInstance, const std::string &Id) {
+			typename DB::RecordVec::value_type R;
+			if (DBInstance.GetRecord("id", Id, R))
+				return R.info;
+			return std::nullopt;
+		}
+	};
+
+	template <typename Names>
+	void ExtendReference(const Names &N, ExtendedRef Kind, const char *Name, const std::string &Id,
+						 Poco::JSON::Object &EI) {
+		if (Id.empty())
+			return;
+		Poco::JSON::Object Obj;
+		if (auto Info = N.Info(Kind, Id))
+			AddInfoBlock(*Info, Obj);
+		EI.set(Name, Obj);
 	}
-	template <typename... Ts> void Extend_entity(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+
+	template <typename R, typename Names, typename Q = decltype(R{}.entity)>
+	void Extend_entity(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::entity, "entity", T.entity, EI);
+	}
+	template <typename... Ts> void Extend_entity(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R, typename Q = decltype(R{}.managementPolicy)>
-	void Extend_managementPolicy(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.managementPolicy.empty()) {
-				Poco::JSON::Object PolObj;
-				ProvObjects::ManagementPolicy Policy;
-				if (StorageService()->PolicyDB().GetRecord("id", T.managementPolicy, Policy)) {
-					AddInfoBlock(Policy.info, PolObj);
-				}
-				EI.set("managementPolicy", PolObj);
-			}
-		}
+	template <typename R, typename Names, typename Q = decltype(R{}.managementPolicy)>
+	void Extend_managementPolicy(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::managementPolicy, "managementPolicy",
+							T.managementPolicy, EI);
 	}
-	template <typename... Ts> void Extend_managementPolicy(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+	template <typename... Ts> void Extend_managementPolicy(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R, typename Q = decltype(R{}.venue)>
-	void Extend_venue(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.venue.empty()) {
-				Poco::JSON::Object VenObj;
-				ProvObjects::Venue Venue;
-				if (StorageService()->VenueDB().GetRecord("id", T.venue, Venue)) {
-					AddInfoBlock(Venue.info, VenObj);
-				}
-				EI.set("venue", VenObj);
-			}
-		}
+	template <typename R, typename Names, typename Q = decltype(R{}.venue)>
+	void Extend_venue(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::venue, "venue", T.venue, EI);
+	}
+	template <typename... Ts> void Extend_venue(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
-	template <typename... Ts> void Extend_venue(Ts... args) { static_assert(sizeof...(args) == 2); }
 
-	template <typename R, typename Q = decltype(std::declval<R>().subscriber)>
-	void Extend_subscriber(const R &T, Poco::JSON::Object &EI) {
+	template <typename R, typename Names, typename Q = decltype(std::declval<R>().subscriber)>
+	void Extend_subscriber(const R &T, Poco::JSON::Object &EI, const Names &N) {
 		if constexpr (std::is_same_v<Q, std::string>) {
 			if (!T.subscriber.empty()) {
 				Poco::JSON::Object SubObj;
-				ProvObjects::SignupEntry Signup;
-				if (StorageService()->SignupDB().GetRecord("userid", T.subscriber, Signup)) {
-					SubObj.set("email", Signup.email);
-					SubObj.set("description", Signup.info.description);
+				if (auto Signup = N.Subscriber(T.subscriber)) {
+					SubObj.set("email", Signup->first);
+					SubObj.set("description", Signup->second);
 				}
 				SubObj.set("id", T.subscriber);
 				EI.set("subscriber", SubObj);
 			}
 		}
 	}
-	template <typename... Ts> void Extend_subscriber(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+	template <typename... Ts> void Extend_subscriber(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R, typename Q = decltype(R{}.contact)>
-	void Extend_contact(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.contact.empty()) {
-				Poco::JSON::Object ConObj;
-				ProvObjects::Contact Contact;
-				if (StorageService()->ContactDB().GetRecord("id", T.contact, Contact)) {
-					AddInfoBlock(Contact.info, ConObj);
-				}
-				EI.set("contact", ConObj);
-			}
-		}
+	template <typename R, typename Names, typename Q = decltype(R{}.contact)>
+	void Extend_contact(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::contact, "contact", T.contact, EI);
 	}
-	template <typename... Ts> void Extend_contact(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+	template <typename... Ts> void Extend_contact(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R, typename Q = decltype(R{}.location)>
-	void Extend_location(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.location.empty()) {
-				Poco::JSON::Object LocObj;
-				ProvObjects::Location Location;
-				if (StorageService()->LocationDB().GetRecord("id", T.location, Location)) {
-					AddInfoBlock(Location.info, LocObj);
-				}
-				EI.set("location", LocObj);
-			}
-		}
+	template <typename R, typename Names, typename Q = decltype(R{}.location)>
+	void Extend_location(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::location, "location", T.location, EI);
 	}
-	template <typename... Ts> void Extend_location(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+	template <typename... Ts> void Extend_location(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R, typename Q = decltype(R{}.deviceConfiguration)>
-	void Extend_deviceConfiguration(const R &T, Poco::JSON::Object &EI) {
-		if constexpr (std::is_same_v<Q, std::string>) {
-			if (!T.deviceConfiguration.empty()) {
-				Poco::JSON::Object DevObj;
-				ProvObjects::DeviceConfiguration DevConf;
-				if (StorageService()->ConfigurationDB().GetRecord("id", T.deviceConfiguration,
-																  DevConf)) {
-					AddInfoBlock(DevConf.info, DevObj);
-				}
-				EI.set("deviceConfiguration", DevObj);
-			}
-		}
+	template <typename R, typename Names, typename Q = decltype(R{}.deviceConfiguration)>
+	void Extend_deviceConfiguration(const R &T, Poco::JSON::Object &EI, const Names &N) {
+		if constexpr (std::is_same_v<Q, std::string>)
+			ExtendReference(N, ExtendedRef::deviceConfiguration, "deviceConfiguration",
+							T.deviceConfiguration, EI);
 		if constexpr (std::is_same_v<Q, Types::UUIDvec_t>) {
 			if (!T.deviceConfiguration.empty()) {
 				Poco::JSON::Array ObjArr;
-				ProvObjects::DeviceConfiguration DevConf;
 				for (const auto &i : T.deviceConfiguration) {
-					if (StorageService()->ConfigurationDB().GetRecord("id", i, DevConf)) {
+					if (auto Info = N.Info(ExtendedRef::deviceConfiguration, i)) {
 						Poco::JSON::Object InnerObj;
-						AddInfoBlock(DevConf.info, InnerObj);
+						AddInfoBlock(*Info, InnerObj);
 						ObjArr.add(InnerObj);
 					}
 				}
@@ -152,37 +172,151 @@ namespace OpenWifi {
 			}
 		}
 	}
-
-	template <typename... Ts> void Extend_deviceConfiguration(Ts... args) {
-		static_assert(sizeof...(args) == 2);
+	template <typename... Ts> void Extend_deviceConfiguration(const Ts &...args) {
+		static_assert(sizeof...(args) == 3);
 	}
 
-	template <typename R> bool AddExtendedInfo(const R &T, Poco::JSON::Object &O) {
+	//	Names resolves the references: StorageNames, or an ExtendedInfoBatch for a whole page.
+	template <typename R, typename Names = StorageNames>
+	bool AddExtendedInfo(const R &T, Poco::JSON::Object &O, const Names &N = Names{}) {
 		Poco::JSON::Object EI;
-		Extend_entity(T, EI);
-		Extend_deviceConfiguration(T, EI);
-		Extend_location(T, EI);
-		Extend_contact(T, EI);
-		Extend_venue(T, EI);
-		Extend_subscriber(T, EI);
-		Extend_managementPolicy(T, EI);
+		Extend_entity(T, EI, N);
+		Extend_deviceConfiguration(T, EI, N);
+		Extend_location(T, EI, N);
+		Extend_contact(T, EI, N);
+		Extend_venue(T, EI, N);
+		Extend_subscriber(T, EI, N);
+		Extend_managementPolicy(T, EI, N);
 		O.set("extendedInfo", EI);
 		return true;
 	}
 
+	//	Resolves the extendedInfo references of a whole page of records with one query per
+	//	referenced table, instead of one GetRecord per reference per row. Like GetRecord, the
+	//	first record found for a subscriber id wins.
+	class ExtendedInfoBatch {
+	  public:
+		template <typename T> void Prepare(const std::vector<T> &Records) {
+			//	The Extend_ helpers find the references: a first pass only notes them.
+			Collector C{*this};
+			for (const auto &i : Records) {
+				Poco::JSON::Object Unused;
+				OpenWifi::AddExtendedInfo(i, Unused, C);
+			}
+			Fetch(StorageService()->EntityDB(), ExtendedRef::entity);
+			Fetch(StorageService()->VenueDB(), ExtendedRef::venue);
+			Fetch(StorageService()->ContactDB(), ExtendedRef::contact);
+			Fetch(StorageService()->LocationDB(), ExtendedRef::location);
+			Fetch(StorageService()->PolicyDB(), ExtendedRef::managementPolicy);
+			Fetch(StorageService()->ConfigurationDB(), ExtendedRef::deviceConfiguration);
+			if (!Subscribers_.empty()) {
+				SignupDB::RecordVec Signups;
+				StorageService()->SignupDB().GetRecordsIn("userid", Keys(Subscribers_), Signups);
+				for (const auto &s : Signups) {
+					auto &Entry = Subscribers_[s.userId];
+					if (!Entry.has_value())
+						Entry = std::make_pair(s.email, s.info.description);
+				}
+			}
+		}
+
+		template <typename R> bool AddExtendedInfo(const R &T, Poco::JSON::Object &O) const {
+			return OpenWifi::AddExtendedInfo(T, O, *this);
+		}
+
+		std::optional<ProvObjects::ObjectInfo> Info(ExtendedRef Kind, const std::string &Id) const {
+			const auto &Map = Infos_[(std::size_t)Kind];
+			auto hint = Map.find(Id);
+			return hint == Map.end() ? std::nullopt : hint->second;
+		}
+
+		std::optional<std::pair<std::string, std::string>>
+		Subscriber(const std::string &Id) const {
+			auto hint = Subscribers_.find(Id);
+			return hint == Subscribers_.end() ? std::nullopt : hint->second;
+		}
+
+	  private:
+		using InfoMap = std::map<std::string, std::optional<ProvObjects::ObjectInfo>>;
+		std::array<InfoMap, (std::size_t)ExtendedRef::count> Infos_;
+		std::map<std::string, std::optional<std::pair<std::string, std::string>>> Subscribers_;
+
+		template <typename M> static std::vector<std::string> Keys(const M &Map) {
+			std::vector<std::string> R;
+			R.reserve(Map.size());
+			for (const auto &[id, _] : Map)
+				R.emplace_back(id);
+			return R;
+		}
+
+		struct Collector {
+			ExtendedInfoBatch &Batch;
+			std::optional<ProvObjects::ObjectInfo> Info(ExtendedRef Kind,
+														const std::string &Id) const {
+				Batch.Infos_[(std::size_t)Kind][Id];
+				return std::nullopt;
+			}
+			std::optional<std::pair<std::string, std::string>>
+			Subscriber(const std::string &Id) const {
+				Batch.Subscribers_[Id];
+				return std::nullopt;
+			}
+		};
+
+		template <typename DB> void Fetch(DB &DBInstance, ExtendedRef Kind) {
+			auto &Map = Infos_[(std::size_t)Kind];
+			if (Map.empty())
+				return;
+			typename DB::RecordVec Records;
+			DBInstance.GetRecordsIn("id", Keys(Map), Records);
+			for (const auto &r : Records)
+				Map[r.info.id] = r.info;
+		}
+	};
+
 	template <typename T>
-	void MakeJSONObjectArray(const char *ArrayName, const std::vector<T> &V, RESTAPIHandler &R) {
-		Poco::JSON::Array ObjArray;
+	void MakeJSONObjectArray(const char *ArrayName, const std::vector<T> &V, RESTAPIHandler &R,
+							 const std::string &NextCursor = "") {
+		ExtendedInfoBatch ExtendedInfo;
+		if (R.NeedAdditionalInfo())
+			ExtendedInfo.Prepare(V);
+		else if (R.NotModified(V))
+			return;
+		auto Writer = R.StreamArray(ArrayName);
+		if (!NextCursor.empty())
+			Writer.Trailer("nextCursor", NextCursor);
 		for (const auto &i : V) {
 			Poco::JSON::Object Obj;
 			i.to_json(Obj);
 			if (R.NeedAdditionalInfo())
-				AddExtendedInfo(i, Obj);
-			ObjArray.add(Obj);
+				ExtendedInfo.AddExtendedInfo(i, Obj);
+			Writer.Add(Obj);
 		}
-		Poco::JSON::Object Answer;
-		Answer.set(ArrayName, ObjArray);
-		return R.ReturnObject(Answer);
+	}
+
+	//	Reads one page of a list: after the cursor, in id order, when the client pages with
+	//	cursor=, otherwise at offset in OrderBy order. Answers and returns false on a bad cursor.
+	template <typename DB>
+	bool GetPage(DB &DBInstance, RESTAPIHandler &R, typename DB::RecordVec &Records,
+				 std::string &NextCursor, const std::string &Where = "",
+				 const std::string &OrderBy = "") {
+		if (!R.QB_.UseCursor) {
+			DBInstance.GetRecords(R.QB_.Offset, R.QB_.Limit, Records, Where, OrderBy);
+			return true;
+		}
+		if (DBInstance.GetRecordsPage(R.QB_.Cursor, R.QB_.Limit, Records, NextCursor, Where))
+			return true;
+		R.BadRequest(RESTAPI::Errors::InvalidCursor);
+		return false;
+	}
+
+	template <typename DB>
+	void ReturnPage(const char *ArrayName, DB &DBInstance, RESTAPIHandler &R,
+					const std::string &Where = "", const std::string &OrderBy = "") {
+		typename DB::RecordVec Entries;
+		std::string NextCursor;
+		if (GetPage(DBInstance, R, Entries, NextCursor, Where, OrderBy))
+			MakeJSONObjectArray(ArrayName, Entries, R, NextCursor);
 	}
 
 	inline static bool is_uuid(const std::string &u) { return u.find('-') != std::string::npos; }
@@ -283,6 +417,60 @@ namespace OpenWifi {
 		}
 	}
 
+	//	The entities and venues whose devices a user other than ROOT may list: exact venues of
+	//	venue roles, plus entities of entity roles with their venues, minus denied exact venues.
+	inline void InventoryReadScope(const std::string &UserId, std::set<std::string> &AllowedEntities,
+								   std::set<std::string> &AllowedVenues) {
+		std::vector<ProvObjects::ManagementRole> Roles;
+		std::set<std::string> DeniedVenues;
+		auto RoleAllowsDeviceRead = [&](const ProvObjects::ManagementRole &role) {
+			ProvObjects::ManagementPolicy Policy;
+			if (!AuthCache::GetInstance()->GetPolicy(role.managementPolicy, Policy)) {
+				if (!StorageService()->PolicyDB().GetRecord("id", role.managementPolicy, Policy)) {
+					return false;
+				}
+				AuthCache::GetInstance()->SetPolicy(role.managementPolicy, Policy);
+			}
+			return RESTAPIHandler::PolicyAllows(Policy, "inventory",
+												Poco::Net::HTTPRequest::HTTP_GET);
+		};
+
+		if (RESTAPIHandler::FindAllUserRoles(UserId, Roles)) {
+			// 1. Process exact venue-scoped roles (ONLY exact venue, no child venue expansion)
+			for (const auto &role : Roles) {
+				if (!role.venue.empty()) {
+					if (RoleAllowsDeviceRead(role)) {
+						AllowedVenues.insert(role.venue);
+					} else {
+						DeniedVenues.insert(role.venue);
+					}
+				}
+			}
+
+			// 2. Process entity-scoped roles (Covers entity + all venues owned by entity, except denied exact venues)
+			for (const auto &role : Roles) {
+				if (role.venue.empty() && !role.entity.empty()) {
+					if (RoleAllowsDeviceRead(role)) {
+						AllowedEntities.insert(role.entity);
+						ProvObjects::Entity EntRec;
+						if (StorageService()->EntityDB().GetRecord("id", role.entity, EntRec)) {
+							for (const auto &vId : EntRec.venues) {
+								if (!DeniedVenues.count(vId)) {
+									AllowedVenues.insert(vId);
+								}
+							}
+						}
+					}
+				}
+			}
+
+			// 3. Enforce shadowing: remove any explicitly denied exact venues
+			for (const auto &vId : DeniedVenues) {
+				AllowedVenues.erase(vId);
+			}
+		}
+	}
+
 	template <typename DB>
 	void ListHandler(const char *BlockName, DB &DBInstance, RESTAPIHandler &R) {
 		auto Entity = R.GetParameter("entity", "");
@@ -315,25 +503,27 @@ namespace OpenWifi {
 		}
 		if (!Entity.empty()) {
 			RecVec Entries;
-			DBInstance.GetRecords(R.QB_.Offset, R.QB_.Limit, Entries, " entity=' " + Entity + "'");
+			std::string NextCursor;
+			if (!GetPage(DBInstance, R, Entries, NextCursor, " entity=' " + Entity + "'"))
+				return;
 			if (R.QB_.CountOnly)
 				return R.ReturnCountOnly(Entries.size());
-			return MakeJSONObjectArray(BlockName, Entries, R);
+			return MakeJSONObjectArray(BlockName, Entries, R, NextCursor);
 		}
 		if (!Venue.empty()) {
 			RecVec Entries;
-			DBInstance.GetRecords(R.QB_.Offset, R.QB_.Limit, Entries, " venue=' " + Venue + "'");
+			std::string NextCursor;
+			if (!GetPage(DBInstance, R, Entries, NextCursor, " venue=' " + Venue + "'"))
+				return;
 			if (R.QB_.CountOnly)
 				return R.ReturnCountOnly(Entries.size());
-			return MakeJSONObjectArray(BlockName, Entries, R);
+			return MakeJSONObjectArray(BlockName, Entries, R, NextCursor);
 		} else if (R.QB_.CountOnly) {
 			Poco::JSON::Object Answer;
 			auto C = DBInstance.Count();
 			return R.ReturnCountOnly(C);
 		} else {
-			RecVec Entries;
-			DBInstance.GetRecords(R.QB_.Offset, R.QB_.Limit, Entries);
-			return MakeJSONObjectArray(BlockName, Entries, R);
+			return ReturnPage(BlockName, DBInstance, R);
 		}
 	}
 
@@ -341,7 +531,6 @@ namespace OpenWifi {
 	void ListHandlerForOperator(const char *BlockName, db_type &DB, RESTAPIHandler &R,
 								const Types::UUID_t &OperatorId,
 								const Types::UUID_t &subscriberId = "") {
-		typedef typename db_type::RecordVec RecVec;
 		typedef typename db_type::RecordName RecType;
 
 		auto whereClause =
@@ -358,9 +547,7 @@ namespace OpenWifi {
 			return ReturnRecordList<decltype(DB), RecType>(BlockName, DB, R);
 		}
 
-		RecVec Entries;
-		DB.GetRecords(R.QB_.Offset, R.QB_.Limit, Entries, whereClause);
-		return MakeJSONObjectArray(BlockName, Entries, R);
+		return ReturnPage(BlockName, DB, R, whereClause);
 	}
 
 	template <typename db_type, typename ObjectDB>
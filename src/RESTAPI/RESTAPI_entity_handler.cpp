@@ -24,6 +24,9 @@ namespace OpenWifi {
 			return NotFound();
 		}
 
+		if (!NeedAdditionalInfo() && NotModified(Existing))
+			return;
+
 		Poco::JSON::Object Answer;
 		Existing.to_json(Answer);
 		if (NeedAdditionalInfo())
@@ -16,9 +16,7 @@ namespace OpenWifi {
 					auto C = DB_.Count();
 					return ReturnCountOnly(C);
 				} else {
-					EntityDB::RecordVec Entities;
-					DB_.GetRecords(QB_.Offset, QB_.Limit, Entities);
-					return MakeJSONObjectArray("entities", Entities, *this);
+					return ReturnPage("entities", DB_, *this);
 				}
 			} else {
 				return ReturnRecordList<EntityDB, ProvObjects::Entity>("entities", DB_, *this);
@@ -316,9 +314,7 @@ namespace OpenWifi {
 			return ReturnObject(ScopedTree);
 		}
 
-		EntityDB::RecordVec FilteredEntities;
-		DB_.GetRecords(QB_.Offset, QB_.Limit, FilteredEntities, ScopeWhere);
-		return MakeJSONObjectArray("entities", FilteredEntities, *this);
+		return ReturnPage("entities", DB_, *this, ScopeWhere);
 	}
 
 	void RESTAPI_entity_list_handler::DoPost() {
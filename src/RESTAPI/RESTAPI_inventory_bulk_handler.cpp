@@ -0,0 +1,331 @@
+//
+// Created by stephane bourque on 2023-11-30.
+//
+
+#include "RESTAPI_inventory_bulk_handler.h"
+
+#include <algorithm>
+#include <future>
+#include <map>
+#include <set>
+
+#include "DeviceTypeCache.h"
+#include "InventoryCSV.h"
+#include "RESTAPI/RESTAPI_db_helpers.h"
+#include "SerialNumberCache.h"
+#include "StorageService.h"
+#include "framework/utils.h"
+#include "sdks/SDK_gw.h"
+
+namespace OpenWifi {
+
+	//	Validates rows as POST /inventory/{serialNumber} would, and writes them BatchSize at a
+	//	time. References (venues, entities...) are checked once per import, and the parents'
+	//	device and inUse lists are updated once per parent at the end.
+	class InventoryImport {
+	  public:
+		InventoryImport(InventoryDB &DB, const SecurityObjects::UserInfo &User,
+						std::uint64_t BatchSize)
+			: DB_(DB), User_(User), BatchSize_(BatchSize) {}
+
+		void Add(std::uint64_t Line, const Poco::JSON::Object::Ptr &Row) {
+			ProvObjects::InventoryTag Tag;
+			if (!Tag.from_json(Row))
+				return Fail(Line, "", RESTAPI::Errors::InvalidJSONDocument);
+			if (!NormalizeMac(Tag.serialNumber))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::InvalidSerialNumber);
+			if (!Seen_.insert(Tag.serialNumber).second)
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::SerialNumberExists);
+			if (!Provisioning::DeviceClass::Validate(Tag.devClass.c_str()))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::InvalidDeviceClass);
+			if (Tag.devClass.empty())
+				Tag.devClass = Provisioning::DeviceClass::ANY;
+			if (Tag.deviceType.empty() || !DeviceTypeCache()->IsAcceptableDeviceType(Tag.deviceType))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::InvalidDeviceTypes);
+			if (!Tag.venue.empty() && !Tag.entity.empty())
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::NotBoth);
+			if (EntityDB::IsRoot(Tag.entity) ||
+				!Known(Entities_, StorageService()->EntityDB(), Tag.entity))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::ValidNonRootUUID);
+			if (!Tag.venue.empty()) {
+				auto It = Venues_.find(Tag.venue);
+				if (It == Venues_.end()) {
+					ProvObjects::Venue V;
+					bool Usable = StorageService()->VenueDB().GetRecord("id", Tag.venue, V) &&
+								  V.subscriber.empty();
+					It = Venues_.emplace(Tag.venue, Usable).first;
+				}
+				if (!It->second)
+					return Fail(Line, Tag.serialNumber, RESTAPI::Errors::VenueMustExist);
+			}
+			if (!Known(Locations_, StorageService()->LocationDB(), Tag.location))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::LocationMustExist);
+			if (!Known(Contacts_, StorageService()->ContactDB(), Tag.contact))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::ContactMustExist);
+			if (!Known(Configurations_, StorageService()->ConfigurationDB(),
+					   Tag.deviceConfiguration))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::ConfigurationMustExist);
+			if (!Known(Policies_, StorageService()->PolicyDB(), Tag.managementPolicy))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::UnknownManagementPolicyUUID);
+
+			if (!Row->has("name") || Row->get("name").toString().empty())
+				Row->set("name", Tag.serialNumber);
+			if (!ProvObjects::CreateObjectInfo(Row, User_, Tag.info))
+				return Fail(Line, Tag.serialNumber, RESTAPI::Errors::NameMustBeSet);
+
+			Lines_.push_back(Line);
+			Pending_.emplace_back(std::move(Tag));
+			if (Pending_.size() >= BatchSize_)
+				Flush();
+		}
+
+		void Fail(std::uint64_t Line, const std::string &SerialNumber,
+				  const RESTAPI::Errors::msg &E) {
+			++Failed_;
+			if (Errors_.size() >= MaxErrors)
+				return;
+			Poco::JSON::Object Error;
+			Error.set("line", Line);
+			Error.set("serialNumber", SerialNumber);
+			Error.set("ErrorCode", E.err_num);
+			Error.set("ErrorDescription", E.err_txt);
+			Errors_.add(Error);
+		}
+
+		void Finish() {
+			Flush();
+			for (const auto &[Venue, Ids] : VenueDevices_)
+				StorageService()->VenueDB().AddVectorMembers(&ProvObjects::Venue::devices, "id",
+															 Venue, Ids);
+			for (const auto &[Entity, Ids] : EntityDevices_)
+				StorageService()->EntityDB().AddVectorMembers(&ProvObjects::Entity::devices, "id",
+															  Entity, Ids);
+			for (const auto &[Id, Ids] : LocationUse_)
+				StorageService()->LocationDB().AddInUse("id", Id, DB_.Prefix(), Ids);
+			for (const auto &[Id, Ids] : ContactUse_)
+				StorageService()->ContactDB().AddInUse("id", Id, DB_.Prefix(), Ids);
+			for (const auto &[Id, Ids] : ConfigurationUse_)
+				StorageService()->ConfigurationDB().AddInUse("id", Id, DB_.Prefix(), Ids);
+			for (const auto &[Id, Ids] : PolicyUse_)
+				StorageService()->PolicyDB().AddInUse("id", Id, DB_.Prefix(), Ids);
+			for (auto &Owner : Ownership_) {
+				if (!Owner.get())
+					++OwnershipErrors_;
+			}
+		}
+
+		void to_json(Poco::JSON::Object &Obj) const {
+			Obj.set("imported", Imported_);
+			Obj.set("failed", Failed_);
+			Obj.set("ownershipErrors", OwnershipErrors_);
+			Obj.set("errors", Errors_);
+		}
+
+		static constexpr std::size_t MaxErrors = 1000;
+
+	  private:
+		InventoryDB &DB_;
+		const SecurityObjects::UserInfo &User_;
+		std::uint64_t BatchSize_;
+		std::uint64_t Imported_ = 0, Failed_ = 0, OwnershipErrors_ = 0;
+		Poco::JSON::Array Errors_;
+		std::set<std::string> Seen_;
+		std::map<std::string, bool> Entities_, Venues_, Locations_, Contacts_, Configurations_,
+			Policies_;
+		std::map<std::string, std::vector<std::string>> VenueDevices_, EntityDevices_,
+			LocationUse_, ContactUse_, ConfigurationUse_, PolicyUse_;
+		ProvObjects::InventoryTagVec Pending_;
+		std::vector<std::uint64_t> Lines_;
+		std::vector<std::future<bool>> Ownership_;
+
+		template <typename DB>
+		static bool Known(std::map<std::string, bool> &Memo, DB &TheDB, const std::string &Id) {
+			if (Id.empty())
+				return true;
+			auto It = Memo.find(Id);
+			if (It == Memo.end())
+				It = Memo.emplace(Id, TheDB.Exists("id", Id)).first;
+			return It->second;
+		}
+
+		void Flush() {
+			if (Pending_.empty())
+				return;
+
+			std::vector<std::string> SerialNumbers;
+			for (const auto &T : Pending_)
+				SerialNumbers.push_back(T.serialNumber);
+			ProvObjects::InventoryTagVec Existing;
+			{
+				ReadRouting::Primary Reads;
+				DB_.GetRecordsIn("serialNumber", SerialNumbers, Existing);
+			}
+			std::set<std::string> Exists;
+			for (const auto &T : Existing)
+				Exists.insert(T.serialNumber);
+
+			ProvObjects::InventoryTagVec Batch;
+			std::vector<std::uint64_t> Lines;
+			for (std::size_t i = 0; i < Pending_.size(); ++i) {
+				if (Exists.count(Pending_[i].serialNumber)) {
+					Fail(Lines_[i], Pending_[i].serialNumber, RESTAPI::Errors::SerialNumberExists);
+				} else {
+					Batch.push_back(std::move(Pending_[i]));
+					Lines.push_back(Lines_[i]);
+				}
+			}
+			Pending_.clear();
+			Lines_.clear();
+
+			ProvObjects::InventoryTagVec Created;
+			if (DB_.CreateRecords(Batch)) {
+				Created = std::move(Batch);
+			} else {
+				//	One bad row fails the whole transaction: find it by writing the rows one by one.
+				for (std::size_t i = 0; i < Batch.size(); ++i) {
+					if (DB_.CreateRecord(Batch[i]))
+						Created.push_back(std::move(Batch[i]));
+					else
+						Fail(Lines[i], Batch[i].serialNumber, RESTAPI::Errors::RecordNotCreated);
+				}
+			}
+
+			SerialNumbers.clear();
+			for (const auto &T : Created) {
+				++Imported_;
+				SerialNumbers.push_back(T.serialNumber);
+				Link(VenueDevices_, T.venue, T.info.id);
+				Link(EntityDevices_, T.entity, T.info.id);
+				Link(LocationUse_, T.location, T.info.id);
+				Link(ContactUse_, T.contact, T.info.id);
+				Link(ConfigurationUse_, T.deviceConfiguration, T.info.id);
+				Link(PolicyUse_, T.managementPolicy, T.info.id);
+				if (!T.entity.empty() || !T.venue.empty() || !T.subscriber.empty())
+					Ownership_.emplace_back(SDK::GW::Device::Async::SetOwnerShip(
+						T.serialNumber, T.entity, T.venue, T.subscriber));
+			}
+			SerialNumberCache()->AddSerialNumbers(SerialNumbers);
+		}
+
+		static void Link(std::map<std::string, std::vector<std::string>> &Links,
+						 const std::string &Parent, const std::string &Id) {
+			if (!Parent.empty())
+				Links[Parent].push_back(Id);
+		}
+	};
+
+	bool RESTAPI_inventory_bulk_handler::CSV() {
+		auto Format = GetParameter("format", "");
+		if (!Format.empty())
+			return Format == "csv";
+		auto Type = Request->getMethod() == Poco::Net::HTTPRequest::HTTP_POST
+						? Request->getContentType()
+						: Request->get("Accept", "");
+		return Type.find("text/csv") != std::string::npos;
+	}
+
+	void RESTAPI_inventory_bulk_handler::DoGet() {
+		if (!Internal_ && UserInfo_.userinfo.userRole != SecurityObjects::ROOT)
+			return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+
+		std::string Where, UUID;
+		if (HasParameter("entity", UUID))
+			Where = DB_.OP("entity", ORM::EQ, UUID);
+		else if (HasParameter("venue", UUID))
+			Where = DB_.OP("venue", ORM::EQ, UUID);
+		auto AsCSV = CSV();
+		auto BatchSize = std::clamp<std::uint64_t>(GetParameter("batch", 1000), 1, 10000);
+
+		PrepareResponse();
+		Response->setContentType(AsCSV ? "text/csv" : "application/x-ndjson");
+		Response->setChunkedTransferEncoding(true);
+		std::unique_ptr<Poco::DeflatingOutputStream> Deflater;
+		std::ostream *Out;
+		if (RESTAPI_JSONStreamWriter::AcceptsGzip(*Request)) {
+			Response->set("Content-Encoding", "gzip");
+			Deflater = std::make_unique<Poco::DeflatingOutputStream>(
+				Response->send(), Poco::DeflatingStreamBuf::STREAM_GZIP);
+			Out = Deflater.get();
+		} else {
+			Out = &Response->send();
+		}
+
+		if (AsCSV)
+			InventoryCSV::WriteHeader(*Out);
+
+		//	Keyset iteration on the serial number: every batch is an index range scan.
+		std::string After;
+		ProvObjects::InventoryTagVec Tags;
+		while (*Out && DB_.GetRecordsAfter("serialNumber", After, BatchSize, Tags, Where)) {
+			for (const auto &T : Tags) {
+				if (AsCSV) {
+					InventoryCSV::Write(*Out, T);
+				} else {
+					Poco::JSON::Object O;
+					T.to_json(O);
+					O.stringify(*Out);
+					*Out << '\n';
+				}
+			}
+			if (Tags.size() < BatchSize)
+				break;
+			After = Tags.back().serialNumber;
+			Tags.clear();
+		}
+		if (Deflater)
+			Deflater->close();
+	}
+
+	void RESTAPI_inventory_bulk_handler::DoPost() {
+		if (!Internal_ && UserInfo_.userinfo.userRole != SecurityObjects::ROOT)
+			return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+
+		auto AsCSV = CSV();
+		InventoryImport Import(DB_, UserInfo_.userinfo,
+							   std::clamp<std::uint64_t>(GetParameter("batch", 1000), 1, 10000));
+
+		auto &In = Request->stream();
+		std::uint64_t LineNumber = 0;
+		if (AsCSV) {
+			//	Records may span lines: errors give the line each one starts on.
+			std::vector<std::string> Header, Values;
+			std::uint64_t Lines = 0;
+			while (InventoryCSV::Read(In, Values, Lines)) {
+				auto First = LineNumber + 1;
+				LineNumber += Lines;
+				if (Values.size() == 1 && Values.front().empty())
+					continue;
+				if (Header.empty()) {
+					Header = std::move(Values);
+					continue;
+				}
+				Import.Add(First, InventoryCSV::Row(Header, Values));
+			}
+		} else {
+			Poco::JSON::Parser Parser;
+			std::string Line;
+			while (std::getline(In, Line)) {
+				++LineNumber;
+				if (!Line.empty() && Line.back() == '\r')
+					Line.pop_back();
+				if (Line.empty())
+					continue;
+
+				Poco::JSON::Object::Ptr Row;
+				try {
+					Parser.reset();
+					Row = Parser.parse(Line).extract<Poco::JSON::Object::Ptr>();
+				} catch (...) {
+					Import.Fail(LineNumber, "", RESTAPI::Errors::InvalidJSONDocument);
+					continue;
+				}
+				Import.Add(LineNumber, Row);
+			}
+		}
+		Import.Finish();
+
+		Poco::JSON::Object Answer;
+		Import.to_json(Answer);
+		return ReturnObject(Answer);
+	}
+} // namespace OpenWifi
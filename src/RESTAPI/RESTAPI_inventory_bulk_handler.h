@@ -0,0 +1,33 @@
+//
+// Created by stephane bourque on 2023-11-30.
+//
+
+#pragma once
+#include "StorageService.h"
+#include "framework/RESTAPI_Handler.h"
+
+namespace OpenWifi {
+
+	//	Bulk inventory import (POST) and export (GET), streamed as NDJSON or CSV.
+	class RESTAPI_inventory_bulk_handler : public RESTAPIHandler {
+	  public:
+		RESTAPI_inventory_bulk_handler(const RESTAPIHandler::BindingMap &bindings, Poco::Logger &L,
+									   RESTAPI_GenericServerAccounting &Server,
+									   uint64_t TransactionId, bool Internal)
+			: RESTAPIHandler(bindings, L,
+							 std::vector<std::string>{Poco::Net::HTTPRequest::HTTP_GET,
+													  Poco::Net::HTTPRequest::HTTP_POST,
+													  Poco::Net::HTTPRequest::HTTP_OPTIONS},
+							 Server, TransactionId, Internal) {}
+		static auto PathName() { return std::list<std::string>{"/api/v1/inventoryBulk"}; };
+
+	  private:
+		InventoryDB &DB_ = StorageService()->InventoryDB();
+		void DoGet() final;
+		void DoPost() final;
+		void DoPut() final{};
+		void DoDelete() final{};
+
+		bool CSV();
+	};
+} // namespace OpenWifi
@@ -45,6 +45,7 @@ namespace OpenWifi {
 			bool Explain = GetBoolParameter("explain", false);
 
 			APConfig Device(SerialNumber, Existing.deviceType, Logger(), Explain);
+			Device.ProfileSources(GetBoolParameter("profile", false));
 
 			auto Configuration = Poco::makeShared<Poco::JSON::Object>();
 			if (Device.Get(Configuration)) {
@@ -54,6 +55,11 @@ namespace OpenWifi {
 			} else {
 				Answer.set("config", "none");
 			}
+			if (GetBoolParameter("profile", false)) {
+				Poco::JSON::Object Profile;
+				Device.Profile().to_json(Profile);
+				Answer.set("profile", Profile);
+			}
 			return ReturnObject(Answer);
 		} else if (GetBoolParameter("firmwareOptions", false)) {
 			ProvObjects::DeviceRules Rules;
@@ -82,6 +88,7 @@ namespace OpenWifi {
 					   fmt::format("{}: Retrieving configuration.", Existing.serialNumber));
 			auto Device =
 				std::make_shared<APConfig>(SerialNumber, Existing.deviceType, Logger(), false);
+			Device->ProfileSources(GetBoolParameter("profile", false));
 			auto Configuration = Poco::makeShared<Poco::JSON::Object>();
 			Poco::JSON::Object ErrorsObj, WarningsObj;
 			ProvObjects::InventoryConfigApplyResult Results;
@@ -116,6 +123,7 @@ namespace OpenWifi {
 					   fmt::format("{}: Retrieving configuration.", Existing.serialNumber));
 			auto Device =
 				std::make_shared<APConfig>(SerialNumber, Existing.deviceType, Logger(), false);
+			Device->ProfileSources(GetBoolParameter("profile", false));
 			auto Configuration = Poco::makeShared<Poco::JSON::Object>();
 			Poco::JSON::Object ErrorsObj, WarningsObj;
 			ProvObjects::InventoryConfigApplyResult Results;
@@ -126,9 +134,16 @@ namespace OpenWifi {
 			} else {
 				Answer.set("error", 1);
 			}
+			if (GetBoolParameter("profile", false)) {
+				Poco::JSON::Object Profile;
+				Device->Profile().to_json(Profile);
+				Answer.set("profile", Profile);
+			}
 			return ReturnObject(Answer);
 		} else if (QB_.AdditionalInfo) {
 			AddExtendedInfo(Existing, Answer);
+		} else if (NotModified(Existing)) {
+			return;
 		}
 		Existing.to_json(Answer);
 		ReturnObject(Answer);
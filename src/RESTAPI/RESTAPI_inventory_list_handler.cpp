@@ -7,30 +7,135 @@
 //
 
 #include "RESTAPI_inventory_list_handler.h"
+#include "InventorySearchIndex.h"
 #include "RESTAPI/RESTAPI_db_helpers.h"
 #include "StorageService.h"
 
 namespace OpenWifi {
 	void RESTAPI_inventory_list_handler::SendList(const ProvObjects::InventoryTagVec &Tags,
-												  bool SerialOnly) {
-		Poco::JSON::Array Array;
+												  bool SerialOnly, const std::string &NextCursor) {
+		ExtendedInfoBatch ExtendedInfo;
+		if (!SerialOnly && QB_.AdditionalInfo)
+			ExtendedInfo.Prepare(Tags);
+		else if (NotModified(Tags))
+			return;
+		auto Writer = StreamArray(SerialOnly ? "serialNumbers" : "taglist");
+		if (!NextCursor.empty())
+			Writer.Trailer("nextCursor", NextCursor);
 		for (const auto &i : Tags) {
 			if (SerialOnly) {
-				Array.add(i.serialNumber);
+				Writer.Add(i.serialNumber);
 			} else {
 				Poco::JSON::Object O;
 				i.to_json(O);
 				if (QB_.AdditionalInfo)
-					AddExtendedInfo(i, O);
-				Array.add(O);
+					ExtendedInfo.AddExtendedInfo(i, O);
+				Writer.Add(O);
 			}
 		}
-		Poco::JSON::Object Answer;
-		if (SerialOnly)
-			Answer.set("serialNumbers", Array);
-		else
-			Answer.set("taglist", Array);
-		ReturnObject(Answer);
+	}
+
+	//	search= and tags= are answered by the inventory search index, or by SQL when it is off.
+	//	Of the other filters, only entity and venue apply. Returns false for other requests.
+	bool RESTAPI_inventory_list_handler::Search(const std::set<std::string> *Entities,
+												const std::set<std::string> *Venues,
+												const std::string &ScopeWhere, bool SerialOnly) {
+		InventorySearchIndex::Query Q;
+		std::string RawTags;
+		if (HasParameter("tags", RawTags)) {
+			try {
+				Poco::StringTokenizer Tokens(RawTags, ",",
+											 Poco::StringTokenizer::TOK_TRIM |
+												 Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+				for (const auto &Tag : Tokens)
+					Q.Tags.push_back(std::stoull(Tag));
+			} catch (...) {
+				BadRequest(RESTAPI::Errors::MissingOrInvalidParameters);
+				return true;
+			}
+		}
+		if (!HasParameter("search", Q.Text))
+			Q.Text.clear();
+		if (Q.Text.empty() && Q.Tags.empty())
+			return false;
+		Q.Prefix = GetParameter("searchMode", "infix") == "prefix";
+		Q.Entity = GetParameter("entity", "");
+		Q.Venue = GetParameter("venue", "");
+		Q.Entities = Entities;
+		Q.Venues = Venues;
+		Q.Offset = QB_.Offset;
+		Q.Limit = QB_.Limit;
+
+		auto InScope = [&](const ProvObjects::InventoryTag &T) {
+			return (!Entities && !Venues) || (Entities && Entities->count(T.entity)) ||
+				   (Venues && Venues->count(T.venue));
+		};
+
+		ProvObjects::InventoryTagVec Tags;
+		std::vector<InventorySearchIndex::Match> Matches;
+		std::uint64_t Total = 0;
+		if (InventorySearchIndex()->Search(Q, Matches, Total)) {
+			if (QB_.CountOnly) {
+				ReturnCountOnly(Total);
+				return true;
+			}
+			if (SerialOnly) {
+				std::vector<std::string> SerialNumbers;
+				for (const auto &M : Matches)
+					SerialNumbers.push_back(M.SerialNumber);
+				ReturnObject("serialNumbers", SerialNumbers);
+				return true;
+			}
+			std::vector<std::string> Ids;
+			Ids.reserve(Matches.size());
+			for (const auto &M : Matches)
+				Ids.push_back(M.Id);
+			ProvObjects::InventoryTagVec Found;
+			DB_.GetRecordsIn("id", Ids, Found);
+			//	GetRecordsIn returns rows in table order: put them back in match order.
+			std::map<std::string, ProvObjects::InventoryTag *> ById;
+			for (auto &T : Found)
+				ById[T.info.id] = &T;
+			Tags.reserve(Found.size());
+			for (const auto &Id : Ids) {
+				auto Hint = ById.find(Id);
+				if (Hint != ById.end() && InScope(*Hint->second))
+					Tags.emplace_back(std::move(*Hint->second));
+			}
+		} else {
+			std::vector<std::string> Clauses;
+			if (!Q.Text.empty()) {
+				auto Text = ORM::Escape(Poco::toLower(Q.Text));
+				auto Pattern = Q.Prefix ? Text + "%" : "%" + Text + "%";
+				Clauses.push_back(fmt::format(
+					" (lower(name) like '{0}' or lower(description) like '{0}' or serialNumber "
+					"like '{0}' or lower(realMacAddress) like '{0}') ",
+					Pattern));
+			}
+			if (!Q.Entity.empty())
+				Clauses.push_back(DB_.OP("entity", ORM::EQ, Q.Entity));
+			if (!Q.Venue.empty())
+				Clauses.push_back(DB_.OP("venue", ORM::EQ, Q.Venue));
+			if (!ScopeWhere.empty())
+				Clauses.push_back(ScopeWhere);
+			//	tags holds a compact JSON array such as [3,14,15]: match each tag as a whole element.
+			for (auto Tag : Q.Tags) {
+				Clauses.push_back(fmt::format(" (tags='[{0}]' or tags like '[{0},%' or tags like "
+											  "'%,{0},%' or tags like '%,{0}]') ",
+											  Tag));
+			}
+			std::string Where;
+			for (const auto &C : Clauses)
+				Where += (Where.empty() ? "" : " and ") + C;
+
+			if (QB_.CountOnly) {
+				ReturnCountOnly(DB_.Count(Where));
+				return true;
+			}
+			DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, Where, " ORDER BY serialNumber ASC ");
+		}
+		SendList(Tags, SerialOnly);
+		return true;
 	}
 
 	void RESTAPI_inventory_list_handler::DoGet() {
@@ -53,7 +158,9 @@ namespace OpenWifi {
 				}
 			}
 
-			if (!QB_.Select.empty()) {
+			if (Search(nullptr, nullptr, "", SerialOnly)) {
+				return;
+			} else if (!QB_.Select.empty()) {
 				return ReturnRecordList<decltype(DB_)>("taglist", DB_, *this);
 			} else if (HasParameter("entity", UUID)) {
 				if (QB_.CountOnly) {
@@ -61,38 +168,46 @@ namespace OpenWifi {
 					return ReturnCountOnly(C);
 				}
 				ProvObjects::InventoryTagVec Tags;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, DB_.OP("entity", ORM::EQ, UUID), OrderBy);
-				return SendList(Tags, SerialOnly);
+				std::string NextCursor;
+				if (!GetPage(DB_, *this, Tags, NextCursor, DB_.OP("entity", ORM::EQ, UUID), OrderBy))
+					return;
+				return SendList(Tags, SerialOnly, NextCursor);
 			} else if (HasParameter("venue", UUID)) {
 				if (QB_.CountOnly) {
 					auto C = DB_.Count(DB_.OP("venue", ORM::EQ, UUID));
 					return ReturnCountOnly(C);
 				}
 				ProvObjects::InventoryTagVec Tags;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, DB_.OP("venue", ORM::EQ, UUID), OrderBy);
-				return SendList(Tags, SerialOnly);
+				std::string NextCursor;
+				if (!GetPage(DB_, *this, Tags, NextCursor, DB_.OP("venue", ORM::EQ, UUID), OrderBy))
+					return;
+				return SendList(Tags, SerialOnly, NextCursor);
 			} else if (GetBoolParameter("subscribersOnly") && GetBoolParameter("unassigned")) {
 				if (QB_.CountOnly) {
 					auto C = DB_.Count(" devClass='subscriber' and subscriber='' ");
 					return ReturnCountOnly(C);
 				}
 				ProvObjects::InventoryTagVec Tags;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, " devClass='subscriber' and subscriber='' ",
-							   OrderBy);
+				std::string NextCursor;
+				if (!GetPage(DB_, *this, Tags, NextCursor, " devClass='subscriber' and subscriber='' ",
+							 OrderBy))
+					return;
 				if (QB_.CountOnly) {
 					auto C = DB_.Count(DB_.OP("venue", ORM::EQ, UUID));
 					return ReturnCountOnly(C);
 				}
-				return SendList(Tags, SerialOnly);
+				return SendList(Tags, SerialOnly, NextCursor);
 			} else if (GetBoolParameter("subscribersOnly")) {
 				if (QB_.CountOnly) {
 					auto C = DB_.Count(" devClass='subscriber' and subscriber!='' ");
 					return ReturnCountOnly(C);
 				}
 				ProvObjects::InventoryTagVec Tags;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags,
-							   " devClass='subscriber' and subscriber!='' ", OrderBy);
-				return SendList(Tags, SerialOnly);
+				std::string NextCursor;
+				if (!GetPage(DB_, *this, Tags, NextCursor, " devClass='subscriber' and subscriber!='' ",
+							 OrderBy))
+					return;
+				return SendList(Tags, SerialOnly, NextCursor);
 			} else if (GetBoolParameter("unassigned")) {
 				if (QB_.CountOnly) {
 					std::string Empty;
@@ -101,12 +216,14 @@ namespace OpenWifi {
 					return ReturnCountOnly(C);
 				}
 				ProvObjects::InventoryTagVec Tags;
+				std::string NextCursor;
 				std::string Empty;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags,
-							   InventoryDB::OP(DB_.OP("venue", ORM::EQ, Empty), ORM::AND,
-											   DB_.OP("entity", ORM::EQ, Empty)),
-							   OrderBy);
-				return SendList(Tags, SerialOnly);
+				if (!GetPage(DB_, *this, Tags, NextCursor,
+							 InventoryDB::OP(DB_.OP("venue", ORM::EQ, Empty), ORM::AND,
+											 DB_.OP("entity", ORM::EQ, Empty)),
+							 OrderBy))
+					return;
+				return SendList(Tags, SerialOnly, NextCursor);
 			} else if (HasParameter("subscriber", Arg) && !Arg.empty()) {
 				ProvObjects::InventoryTagVec Tags;
 				DB_.GetRecords(0, 100, Tags, " subscriber='" + ORM::Escape(Arg) + "'");
@@ -131,61 +248,17 @@ namespace OpenWifi {
 				}
 			} else {
 				ProvObjects::InventoryTagVec Tags;
-				DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, "", OrderBy);
-				return SendList(Tags, SerialOnly);
+				std::string NextCursor;
+				if (!GetPage(DB_, *this, Tags, NextCursor, "", OrderBy))
+					return;
+				return SendList(Tags, SerialOnly, NextCursor);
 			}
 		}
 
 		// Standard user flow:
-		std::vector<ProvObjects::ManagementRole> Roles;
 		std::set<std::string> AllowedEntities;
 		std::set<std::string> AllowedVenues;
-		std::set<std::string> DeniedVenues;
-		auto RoleAllowsDeviceRead = [&](const ProvObjects::ManagementRole &role) {
-			ProvObjects::ManagementPolicy Policy;
-			if (!AuthCache::GetInstance()->GetPolicy(role.managementPolicy, Policy)) {
-				if (!StorageService()->PolicyDB().GetRecord("id", role.managementPolicy, Policy)) {
-					return false;
-				}
-				AuthCache::GetInstance()->SetPolicy(role.managementPolicy, Policy);
-			}
-			return PolicyAllows(Policy, "inventory", Poco::Net::HTTPRequest::HTTP_GET);
-		};
-
-		if (FindAllUserRoles(UserInfo_.userinfo.id, Roles)) {
-			// 1. Process exact venue-scoped roles (ONLY exact venue, no child venue expansion)
-			for (const auto &role : Roles) {
-				if (!role.venue.empty()) {
-					if (RoleAllowsDeviceRead(role)) {
-						AllowedVenues.insert(role.venue);
-					} else {
-						DeniedVenues.insert(role.venue);
-					}
-				}
-			}
-
-			// 2. Process entity-scoped roles (Covers entity + all venues owned by entity, except denied exact venues)
-			for (const auto &role : Roles) {
-				if (role.venue.empty() && !role.entity.empty()) {
-					if (RoleAllowsDeviceRead(role)) {
-						AllowedEntities.insert(role.entity);
-						ProvObjects::Entity EntRec;
-						if (StorageService()->EntityDB().GetRecord("id", role.entity, EntRec)) {
-							for (const auto &vId : EntRec.venues) {
-								if (!DeniedVenues.count(vId)) {
-									AllowedVenues.insert(vId);
-								}
-							}
-						}
-					}
-				}
-			}
-
-			// 3. Enforce shadowing: remove any explicitly denied exact venues
-			for (const auto &vId : DeniedVenues) {
-				AllowedVenues.erase(vId);
-			}
-		}
+		InventoryReadScope(UserInfo_.userinfo.id, AllowedEntities, AllowedVenues);
 
 		if (AllowedEntities.empty() && AllowedVenues.empty()) {
 			ProvObjects::InventoryTagVec Tags;
@@ -281,6 +354,9 @@ namespace OpenWifi {
 			scopeWhere = venClause;
 		}
 
+		if (Search(&AllowedEntities, &AllowedVenues, scopeWhere, SerialOnly))
+			return;
+
 		std::string FinalWhere;
 		if (!Where.empty() && !scopeWhere.empty()) {
 			FinalWhere = "(" + Where + ") AND " + scopeWhere;
@@ -330,7 +406,9 @@ namespace OpenWifi {
 		}
 
 		ProvObjects::InventoryTagVec Tags;
-		DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, FinalWhere, OrderBy);
-		return SendList(Tags, SerialOnly);
+		std::string NextCursor;
+		if (!GetPage(DB_, *this, Tags, NextCursor, FinalWhere, OrderBy))
+			return;
+		return SendList(Tags, SerialOnly, NextCursor);
 	}
 } // namespace OpenWifi
@@ -30,6 +30,9 @@ namespace OpenWifi {
 		void DoPut() final{};
 		void DoDelete() final{};
 
-		void SendList(const ProvObjects::InventoryTagVec &Tags, bool SerialOnly);
+		void SendList(const ProvObjects::InventoryTagVec &Tags, bool SerialOnly,
+					  const std::string &NextCursor = "");
+		bool Search(const std::set<std::string> *Entities, const std::set<std::string> *Venues,
+					const std::string &ScopeWhere, bool SerialOnly);
 	};
 } // namespace OpenWifi
\ No newline at end of file
@@ -12,9 +12,7 @@ namespace OpenWifi {
 		const char *BlockName{"list"};
 		if (GetBoolParameter("myMaps", false)) {
 			auto where = DB_.OP("creator", ORM::EQ, UserInfo_.userinfo.id);
-			MapDB::RecordVec Maps;
-			DB_.GetRecords(QB_.Offset, QB_.Limit, Maps, where);
-			return MakeJSONObjectArray(BlockName, Maps, *this);
+			return ReturnPage(BlockName, DB_, *this, where);
 		} else if (GetBoolParameter("sharedWithMe", false)) {
 
 		} else {
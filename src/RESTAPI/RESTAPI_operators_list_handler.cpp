@@ -44,21 +44,17 @@ namespace OpenWifi {
 			}
 		}
 
+		//	The operators a non-root user may read, as a restriction on the table, so counting and
+		//	paging (by offset or cursor) run in the database.
+		std::string Where;
+		for (const auto &Id : AllowedOperatorIds)
+			Where += (Where.empty() ? "id in ('" : ",'") + ORM::Escape(Id) + "'";
+		if (!Where.empty())
+			Where += ")";
+		bool NoneAllowed = !AllOperatorsAllowed && AllowedOperatorIds.empty();
+
 		if (QB_.CountOnly) {
-			if (AllOperatorsAllowed) {
-				auto Count = DB_.Count();
-				return ReturnCountOnly(Count);
-			} else {
-				std::vector<ProvObjects::Operator> AllEntries;
-				DB_.GetRecords(0, 100000, AllEntries);
-				uint64_t Count = 0;
-				for (const auto &op : AllEntries) {
-					if (AllowedOperatorIds.count(op.info.id)) {
-						Count++;
-					}
-				}
-				return ReturnCountOnly(Count);
-			}
+			return ReturnCountOnly(NoneAllowed ? 0 : DB_.Count(Where));
 		}
 
 		if (!QB_.Select.empty()) {
@@ -86,22 +82,9 @@ namespace OpenWifi {
 			}
 		}
 
-		std::vector<ProvObjects::Operator> Entries;
-		if (AllOperatorsAllowed) {
-			DB_.GetRecords(QB_.Offset, QB_.Limit, Entries);
-		} else {
-			std::vector<ProvObjects::Operator> AllEntries;
-			DB_.GetRecords(0, 100000, AllEntries);
-			std::vector<ProvObjects::Operator> FilteredEntries;
-			for (const auto &op : AllEntries) {
-				if (AllowedOperatorIds.count(op.info.id)) {
-					FilteredEntries.push_back(op);
-				}
-			}
-			for (size_t i = QB_.Offset; i < FilteredEntries.size() && Entries.size() < QB_.Limit; ++i) {
-				Entries.push_back(FilteredEntries[i]);
-			}
+		if (NoneAllowed) {
+			return MakeJSONObjectArray("operators", std::vector<ProvObjects::Operator>{}, *this);
 		}
-		return MakeJSONObjectArray("operators", Entries, *this);
+		return ReturnPage("operators", DB_, *this, Where);
 	}
 } // namespace OpenWifi
@@ -9,6 +9,7 @@
 #include "RESTAPI/RESTAPI_contact_list_handler.h"
 #include "RESTAPI/RESTAPI_entity_handler.h"
 #include "RESTAPI/RESTAPI_entity_list_handler.h"
+#include "RESTAPI/RESTAPI_inventory_bulk_handler.h"
 #include "RESTAPI/RESTAPI_inventory_handler.h"
 #include "RESTAPI/RESTAPI_inventory_list_handler.h"
 #include "RESTAPI/RESTAPI_iptocountry_handler.h"
@@ -45,6 +46,8 @@
 #include "RESTAPI/RESTAPI_radiusendpoint_list_handler.h"
 #include "RESTAPI/RESTAPI_radius_endpoint_handler.h"
 
+#include "framework/RESTAPI_MetricsHandler.h"
+#include "framework/RESTAPI_RouteTrie.h"
 #include "framework/RESTAPI_SystemCommand.h"
 #include "framework/RESTAPI_WebSocketServer.h"
 #include "framework/RESTAPI_SystemConfiguration.h"
@@ -54,12 +57,12 @@ namespace OpenWifi {
 	Poco::Net::HTTPRequestHandler *
 	RESTAPI_ExtRouter(const std::string &Path, RESTAPIHandler::BindingMap &Bindings,
 					  Poco::Logger &L, RESTAPI_GenericServerAccounting &S, uint64_t TransactionId) {
-		return RESTAPI_Router<
+		static const auto Routes = RESTAPI_RouteTrie::Build<
 			RESTAPI_system_command, RESTAPI_system_configuration,
             RESTAPI_entity_handler, RESTAPI_entity_list_handler,
 			RESTAPI_contact_handler, RESTAPI_contact_list_handler, RESTAPI_location_handler,
 			RESTAPI_location_list_handler, RESTAPI_venue_handler, RESTAPI_venue_list_handler,
-			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler,
+			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler, RESTAPI_inventory_bulk_handler,
 			RESTAPI_managementPolicy_handler, RESTAPI_managementPolicy_list_handler,
 			RESTAPI_managementRole_handler, RESTAPI_managementRole_list_handler,
 			RESTAPI_configurations_handler,
@@ -75,19 +78,20 @@ namespace OpenWifi {
             RESTAPI_openroaming_gr_acct_handler, RESTAPI_openroaming_gr_list_acct_handler,
             RESTAPI_openroaming_gr_cert_handler, RESTAPI_openroaming_gr_list_certificates,
             RESTAPI_openroaming_orion_acct_handler, RESTAPI_openroaming_orion_list_acct_handler,
-            RESTAPI_radiusendpoint_list_handler, RESTAPI_radius_endpoint_handler>(
-			Path, Bindings, L, S, TransactionId);
+            RESTAPI_radiusendpoint_list_handler, RESTAPI_radius_endpoint_handler>();
+		return Routes.Dispatch(Path, Bindings, L, S, TransactionId, false);
 	}
 
 	Poco::Net::HTTPRequestHandler *
 	RESTAPI_IntRouter(const std::string &Path, RESTAPIHandler::BindingMap &Bindings,
 					  Poco::Logger &L, RESTAPI_GenericServerAccounting &S, uint64_t TransactionId) {
-		return RESTAPI_Router_I<
-			RESTAPI_system_command, RESTAPI_system_configuration, RESTAPI_entity_handler,
+		static const auto Routes = RESTAPI_RouteTrie::Build<
+			RESTAPI_system_command, RESTAPI_system_configuration, RESTAPI_metrics_handler,
+			RESTAPI_entity_handler,
             RESTAPI_entity_list_handler,
 			RESTAPI_contact_handler, RESTAPI_contact_list_handler, RESTAPI_location_handler,
 			RESTAPI_location_list_handler, RESTAPI_venue_handler, RESTAPI_venue_list_handler,
-			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler,
+			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler, RESTAPI_inventory_bulk_handler,
 			RESTAPI_managementPolicy_handler, RESTAPI_managementPolicy_list_handler,
 			RESTAPI_managementRole_handler, RESTAPI_managementRole_list_handler,
 			RESTAPI_configurations_handler,
@@ -103,7 +107,7 @@ namespace OpenWifi {
             RESTAPI_openroaming_gr_acct_handler, RESTAPI_openroaming_gr_list_acct_handler,
             RESTAPI_openroaming_gr_cert_handler, RESTAPI_openroaming_gr_list_certificates,
             RESTAPI_openroaming_orion_acct_handler, RESTAPI_openroaming_orion_list_acct_handler,
-            RESTAPI_radiusendpoint_list_handler, RESTAPI_radius_endpoint_handler>(
-                    Path, Bindings, L, S,TransactionId);
+            RESTAPI_radiusendpoint_list_handler, RESTAPI_radius_endpoint_handler>();
+		return Routes.Dispatch(Path, Bindings, L, S, TransactionId, true);
 	}
 } // namespace OpenWifi
@@ -73,6 +73,8 @@ namespace OpenWifi {
 		Poco::JSON::Object Answer;
 		if (QB_.AdditionalInfo)
 			AddExtendedInfo(Existing, Answer);
+		else if (NotModified(Existing))
+			return;
 
 		Existing.to_json(Answer);
 		ReturnObject(Answer);
@@ -17,9 +17,11 @@ namespace OpenWifi {
 				return ListHandler<VenueDB>("venues", DB_, *this);
 			}
 			VenueDB::RecordVec Venues;
+			std::string NextCursor;
 			auto Where = fmt::format(" deviceRules LIKE '%{}%' ", RRMvendor);
-			DB_.GetRecords(QB_.Offset, QB_.Limit, Venues, Where, " ORDER BY name ");
-			return ReturnObject("venues",Venues);
+			if (!GetPage(DB_, *this, Venues, NextCursor, Where, " ORDER BY name "))
+				return;
+			return ReturnObject("venues", Venues, NextCursor);
 		}
 
 		// Standard user flow:
@@ -97,7 +99,9 @@ namespace OpenWifi {
 		}
 
 		VenueDB::RecordVec FilteredVenues;
-		DB_.GetRecords(QB_.Offset, QB_.Limit, FilteredVenues, FinalWhere, " ORDER BY name ");
-		return ReturnObject("venues", FilteredVenues);
+		std::string NextCursor;
+		if (!GetPage(DB_, *this, FilteredVenues, NextCursor, FinalWhere, " ORDER BY name "))
+			return;
+		return ReturnObject("venues", FilteredVenues, NextCursor);
 	}
 } // namespace OpenWifi
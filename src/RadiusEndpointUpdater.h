@@ -3,6 +3,10 @@
 //
 
 #pragma once
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
 #include <vector>
 #include <utility>
 #include <framework/AppServiceRegistry.h>
@@ -64,138 +68,60 @@ namespace OpenWifi {
             }
         }
 
+        //  Builds the pool list from every endpoint and pushes it to the gateway. Pools are kept
+        //  from the previous run and only rebuilt when the endpoint or the account material it
+        //  uses changed. The list is always sent: the gateway may have restarted or been changed
+        //  since the last push.
         inline bool UpdateEndpoints( RESTAPIHandler *Client, std::uint64_t & ErrorCode,
                                      std::string & ErrorDetails,
                                      std::string & ErrorDescription) {
 
             std::vector<ProvObjects::RADIUSEndPoint>    Endpoints;
-            GWObjects::RadiusProxyPoolList  Pools;
-            StorageService()->RadiusEndpointDB().GetRecords(0,500,Endpoints);
+            StorageService()->RadiusEndpointDB().Iterate([&](const ProvObjects::RADIUSEndPoint &E) {
+                Endpoints.emplace_back(E);
+                return true;
+            });
+            std::sort(Endpoints.begin(), Endpoints.end(), [](const auto &A, const auto &B) {
+                return A.info.id < B.info.id;
+            });
+
+            auto &S = State();
+            std::lock_guard     G(S.Mutex);
+            S.Used.clear();
 
+            GWObjects::RadiusProxyPoolList  Pools;
+            std::map<std::string, CachedPool>   Built;
             for(const auto &Endpoint:Endpoints) {
-                GWObjects::RadiusProxyPool  PP;
-
-                PP.name = Endpoint.info.name;
-                PP.description = Endpoint.info.description;
-                PP.useByDefault = false;
-                PP.poolProxyIp = Endpoint.Index;
-                PP.radsecKeepAlive = 25;
-                PP.enabled = true;
-
-                if(Endpoint.Type=="orion" && !Endpoint.RadsecServers.empty()) {
-                    auto Svrs = OpenRoaming_Orion()->GetServers();
-                    PP.radsecPoolType="orion";
-                    ProvObjects::GooglOrionAccountInfo  OA;
-                    if(StorageService()->OrionAccountsDB().GetRecord("id", Endpoint.RadsecServers[0].UseOpenRoamingAccount, OA)) {
-                        for(auto *ServerType:{&PP.authConfig, &PP.acctConfig, &PP.coaConfig}) {
-                            ServerType->monitor = false;
-                            ServerType->strategy = Endpoint.PoolStrategy;
-                            ServerType->monitorMethod = "none";
-                            ServerType->strategy = "random";
-                            int i=1;
-                            for (const auto &Server: Svrs) {
-                                GWObjects::RadiusProxyServerEntry PE;
-                                PE.radsecCert = Utils::base64encode((const u_char *)OA.certificate.c_str(),OA.certificate.size());
-                                PE.radsecKey = Utils::base64encode((const u_char *)OA.privateKey.c_str(),OA.privateKey.size());
-                                for(const auto &cert:OA.cacerts) {
-                                    auto C = Utils::base64encode((const u_char *)cert.c_str(),cert.size());
-                                    PE.radsecCacerts.emplace_back(C);
-                                }
-                                PE.radsec = true;
-                                PE.name = fmt::format("Server {}",i++);
-                                PE.ignore = false;
-                                PE.ip = Server.Hostname;
-                                PE.port = PE.radsecPort = Server.Port;
-                                PE.allowSelfSigned = false;
-                                PE.weight = 10;
-                                PE.secret = PE.radsecSecret = "radsec";
-                                ServerType->servers.emplace_back(PE);
-                            }
-                        }
-                        Pools.pools.emplace_back(PP);
-                    }
-                } else if(Endpoint.Type=="globalreach" && !Endpoint.RadsecServers.empty()) {
-                    auto Svrs = OpenRoaming_GlobalReach()->GetServers();
-                    PP.radsecPoolType="globalreach";
-                    ProvObjects::GLBLRCertificateInfo   GRCertificate;
-                    ProvObjects::GLBLRAccountInfo       GRAccountInfo;
-                    if( StorageService()->GLBLRCertsDB().GetRecord("id",Endpoint.RadsecServers[0].UseOpenRoamingAccount,GRCertificate) &&
-                        StorageService()->GLBLRAccountInfoDB().GetRecord("id",GRCertificate.accountId,GRAccountInfo)) {
-                        for(auto *ServerType:{&PP.authConfig, &PP.acctConfig, &PP.coaConfig}) {
-                            ServerType->monitor = false;
-                            ServerType->monitorMethod = "none";
-                            ServerType->strategy = Endpoint.PoolStrategy;
-                            ServerType->strategy = "random";
-                            int i = 1;
-                            for (const auto &Server: Svrs) {
-                                GWObjects::RadiusProxyServerEntry PE;
-                                PE.radsecCert = Utils::base64encode((const u_char *)GRCertificate.certificate.c_str(),GRCertificate.certificate.size());
-                                PE.radsecKey = Utils::base64encode((const u_char *)GRAccountInfo.CSRPrivateKey.c_str(),GRAccountInfo.CSRPrivateKey.size());
-                                std::vector<std::string> Chain;
-                                ParseCertChain(GRCertificate.certificateChain,Chain);
-                                for(const auto &cert:Chain) {
-                                    PE.radsecCacerts.emplace_back( Utils::base64encode((const u_char *)cert.c_str(),cert.size()));
-                                }
-                                PE.radsec = true;
-                                PE.name = fmt::format("Server {}", i++);
-                                PE.ignore = false;
-                                PE.ip = Server.Hostname;
-                                PE.port = PE.radsecPort = Server.Port;
-                                PE.allowSelfSigned = false;
-                                PE.weight = 10;
-                                PE.secret = PE.radsecSecret = "radsec";
-                                ServerType->servers.emplace_back(PE);
-                            }
-                        }
-                        Pools.pools.emplace_back(PP);
-                    }
-                } else if(Endpoint.Type=="radsec"  && !Endpoint.RadsecServers.empty()) {
-                    PP.radsecPoolType="radsec";
-                    for(auto *ServerType:{&PP.authConfig, &PP.acctConfig, &PP.coaConfig}) {
-                        ServerType->monitor = false;
-                        ServerType->strategy = Endpoint.PoolStrategy;
-                        ServerType->monitorMethod = "none";
-                        ServerType->strategy = "random";
-                        for (const auto &Server: Endpoint.RadsecServers) {
-                            GWObjects::RadiusProxyServerEntry PE;
-                            PE.radsecCert = Utils::base64encode((const u_char *)Server.Certificate.c_str(), Server.Certificate.size());
-                            PE.radsecKey = Utils::base64encode((const u_char *)Server.PrivateKey.c_str(),Server.PrivateKey.size());
-                            for(const auto &C:Server.CaCerts) {
-                                PE.radsecCacerts.emplace_back(Utils::base64encode(
-                                        (const u_char *) C.c_str(),
-                                        C.size()));
-                            }
-                            PE.radsec = true;
-                            PE.name = Server.Hostname;
-                            PE.ignore = false;
-                            PE.ip = Server.IP;
-                            PE.port = PE.radsecPort = Server.Port;
-                            PE.allowSelfSigned = false;
-                            PE.weight = 10;
-                            PE.secret = PE.radsecSecret = "radsec";
-                            ServerType->servers.emplace_back(PE);
-                        }
-                    }
-                    Pools.pools.emplace_back(PP);
-                } else if(Endpoint.Type=="generic"  && !Endpoint.RadiusServers.empty()) {
-                    PP.radsecPoolType="generic";
-                    UpdateRadiusServerEntry(PP.authConfig, Endpoint, Endpoint.RadiusServers[0].Authentication);
-                    UpdateRadiusServerEntry(PP.acctConfig, Endpoint, Endpoint.RadiusServers[0].Accounting);
-                    UpdateRadiusServerEntry(PP.coaConfig, Endpoint, Endpoint.RadiusServers[0].CoA);
-                    Pools.pools.emplace_back(PP);
+                PoolSources Sources;
+                std::string Fingerprint;
+                if(!LoadSources(Endpoint, Sources, Fingerprint))
+                    continue;
+                auto Previous = S.Pools.find(Endpoint.info.id);
+                if(Previous!=S.Pools.end() && Previous->second.Fingerprint==Fingerprint) {
+                    Built[Endpoint.info.id] = std::move(Previous->second);
+                } else {
+                    S.Building.clear();
+                    auto Pool = BuildPool(Endpoint, Sources);
+                    Built[Endpoint.info.id] = CachedPool{ .Fingerprint = Fingerprint, .Pool = std::move(Pool), .Keys = S.Building };
                 }
+                const auto &Current = Built[Endpoint.info.id];
+                Pools.pools.emplace_back(Current.Pool);
+                S.Used.insert(Current.Keys.begin(), Current.Keys.end());
+            }
+            S.Pools = std::move(Built);
+            for(auto It = S.Encoded.begin(); It != S.Encoded.end(); ) {
+                It = S.Used.count(It->first) ? std::next(It) : S.Encoded.erase(It);
+            }
+            for(auto It = S.Chains.begin(); It != S.Chains.end(); ) {
+                It = S.Used.count(It->first) ? std::next(It) : S.Chains.erase(It);
             }
 
-/*
-            Poco::JSON::Object  oo;
-            Pools.to_json(oo);
-            oo.stringify(std::cout,2,2);
-*/
+            ProvObjects::RADIUSEndpointUpdateStatus Status;
+            Status.Read();
+
             GWObjects::RadiusProxyPoolList  NewPools;
             Poco::JSON::Object ErrorObj;
             if(SDK::GW::RADIUS::SetConfiguration(Client, Pools, NewPools, ErrorObj)) {
-                ProvObjects::RADIUSEndpointUpdateStatus Status;
-                Status.Read();
                 Status.lastConfigurationChange = Status.lastUpdate = Utils::Now();
                 return Status.Save();
             }
@@ -217,7 +143,179 @@ namespace OpenWifi {
         }
 
     private:
+        struct PoolSources {
+            std::vector<Utils::HostNameServerResult>    Servers;
+            ProvObjects::GooglOrionAccountInfo          OrionAccount;
+            ProvObjects::GLBLRCertificateInfo           GRCertificate;
+            ProvObjects::GLBLRAccountInfo               GRAccountInfo;
+        };
 
+        struct CachedPool {
+            std::string                 Fingerprint;
+            GWObjects::RadiusProxyPool  Pool;
+            std::set<std::string>       Keys;       //  the encoded material the pool holds
+        };
+
+        //  Shared by every updater: the pools last built, and the base64 forms of the
+        //  certificates and keys, keyed by the hash of their content. Encoded material that no
+        //  pool of the current run holds is dropped at the end of the run.
+        struct UpdaterState {
+            std::mutex                                          Mutex;
+            std::map<std::string, CachedPool>                   Pools;
+            std::map<std::string, std::string>                  Encoded;
+            std::map<std::string, std::vector<std::string>>     Chains;
+            std::set<std::string>                               Used;
+            std::set<std::string>                               Building;
+        };
+
+        static UpdaterState &State() {
+            static UpdaterState S;
+            return S;
+        }
+
+        static std::string ServersKey(const std::vector<Utils::HostNameServerResult> &Servers) {
+            std::string Key;
+            for(const auto &Server:Servers)
+                Key += fmt::format("{}:{};", Server.Hostname, Server.Port);
+            return Key;
+        }
+
+        //  Loads the records an endpoint's pool is made of and fingerprints their content.
+        //  Returns false when the endpoint does not produce a pool.
+        bool LoadSources(const ProvObjects::RADIUSEndPoint &Endpoint, PoolSources &Sources, std::string &Fingerprint) {
+            Poco::JSON::Object  EO;
+            Endpoint.to_json(EO);
+            std::ostringstream  OS;
+            EO.stringify(OS);
+
+            if(Endpoint.Type=="orion" && !Endpoint.RadsecServers.empty()) {
+                Sources.Servers = OpenRoaming_Orion()->GetServers();
+                if(!StorageService()->OrionAccountsDB().GetRecord("id", Endpoint.RadsecServers[0].UseOpenRoamingAccount, Sources.OrionAccount))
+                    return false;
+                const auto &OA = Sources.OrionAccount;
+                std::string CaCerts;
+                for(const auto &cert:OA.cacerts)
+                    CaCerts += cert;
+                Fingerprint = Utils::ComputeHash(OS.str(), ServersKey(Sources.Servers), OA.certificate, OA.privateKey, CaCerts);
+                return true;
+            } else if(Endpoint.Type=="globalreach" && !Endpoint.RadsecServers.empty()) {
+                Sources.Servers = OpenRoaming_GlobalReach()->GetServers();
+                if( !StorageService()->GLBLRCertsDB().GetRecord("id",Endpoint.RadsecServers[0].UseOpenRoamingAccount,Sources.GRCertificate) ||
+                    !StorageService()->GLBLRAccountInfoDB().GetRecord("id",Sources.GRCertificate.accountId,Sources.GRAccountInfo))
+                    return false;
+                Fingerprint = Utils::ComputeHash(OS.str(), ServersKey(Sources.Servers), Sources.GRCertificate.certificate,
+                                                 Sources.GRCertificate.certificateChain, Sources.GRAccountInfo.CSRPrivateKey);
+                return true;
+            } else if( (Endpoint.Type=="radsec" && !Endpoint.RadsecServers.empty()) ||
+                       (Endpoint.Type=="generic" && !Endpoint.RadiusServers.empty())) {
+                Fingerprint = Utils::ComputeHash(OS.str());
+                return true;
+            }
+            return false;
+        }
+
+        const std::string &Encoded(const std::string &Content) {
+            auto &S = State();
+            auto Key = Utils::ComputeHash(Content);
+            S.Building.insert(Key);
+            auto Hint = S.Encoded.find(Key);
+            if(Hint!=S.Encoded.end())
+                return Hint->second;
+            return S.Encoded[Key] = Utils::base64encode((const u_char *)Content.c_str(),Content.size());
+        }
+
+        const std::vector<std::string> &EncodedChain(const std::string &Chain) {
+            auto &S = State();
+            auto Key = Utils::ComputeHash("chain", Chain);
+            S.Building.insert(Key);
+            auto Hint = S.Chains.find(Key);
+            if(Hint!=S.Chains.end())
+                return Hint->second;
+            std::vector<std::string>    Certs;
+            ParseCertChain(Chain,Certs);
+            auto &Result = S.Chains[Key];
+            for(const auto &cert:Certs)
+                Result.emplace_back(Utils::base64encode((const u_char *)cert.c_str(),cert.size()));
+            return Result;
+        }
+
+        //  The auth, acct and coa configurations of a radsec pool are identical.
+        static void SetRadsecConfig(GWObjects::RadiusProxyPool &PP, const GWObjects::RadiusProxyServerConfig &Config) {
+            PP.authConfig = PP.acctConfig = PP.coaConfig = Config;
+        }
+
+        GWObjects::RadiusProxyPool BuildPool(const ProvObjects::RADIUSEndPoint &Endpoint, const PoolSources &Sources) {
+            GWObjects::RadiusProxyPool  PP;
+
+            PP.name = Endpoint.info.name;
+            PP.description = Endpoint.info.description;
+            PP.useByDefault = false;
+            PP.poolProxyIp = Endpoint.Index;
+            PP.radsecKeepAlive = 25;
+            PP.enabled = true;
+
+            GWObjects::RadiusProxyServerConfig  Config;
+            Config.monitor = false;
+            Config.monitorMethod = "none";
+            Config.strategy = "random";
+
+            if(Endpoint.Type=="orion" || Endpoint.Type=="globalreach") {
+                PP.radsecPoolType = Endpoint.Type;
+                GWObjects::RadiusProxyServerEntry Template;
+                if(Endpoint.Type=="orion") {
+                    const auto &OA = Sources.OrionAccount;
+                    Template.radsecCert = Encoded(OA.certificate);
+                    Template.radsecKey = Encoded(OA.privateKey);
+                    for(const auto &cert:OA.cacerts) {
+                        Template.radsecCacerts.emplace_back(Encoded(cert));
+                    }
+                } else {
+                    Template.radsecCert = Encoded(Sources.GRCertificate.certificate);
+                    Template.radsecKey = Encoded(Sources.GRAccountInfo.CSRPrivateKey);
+                    Template.radsecCacerts = EncodedChain(Sources.GRCertificate.certificateChain);
+                }
+                int i=1;
+                for (const auto &Server: Sources.Servers) {
+                    GWObjects::RadiusProxyServerEntry PE = Template;
+                    PE.radsec = true;
+                    PE.name = fmt::format("Server {}",i++);
+                    PE.ignore = false;
+                    PE.ip = Server.Hostname;
+                    PE.port = PE.radsecPort = Server.Port;
+                    PE.allowSelfSigned = false;
+                    PE.weight = 10;
+                    PE.secret = PE.radsecSecret = "radsec";
+                    Config.servers.emplace_back(PE);
+                }
+                SetRadsecConfig(PP, Config);
+            } else if(Endpoint.Type=="radsec") {
+                PP.radsecPoolType="radsec";
+                for (const auto &Server: Endpoint.RadsecServers) {
+                    GWObjects::RadiusProxyServerEntry PE;
+                    PE.radsecCert = Encoded(Server.Certificate);
+                    PE.radsecKey = Encoded(Server.PrivateKey);
+                    for(const auto &C:Server.CaCerts) {
+                        PE.radsecCacerts.emplace_back(Encoded(C));
+                    }
+                    PE.radsec = true;
+                    PE.name = Server.Hostname;
+                    PE.ignore = false;
+                    PE.ip = Server.IP;
+                    PE.port = PE.radsecPort = Server.Port;
+                    PE.allowSelfSigned = false;
+                    PE.weight = 10;
+                    PE.secret = PE.radsecSecret = "radsec";
+                    Config.servers.emplace_back(PE);
+                }
+                SetRadsecConfig(PP, Config);
+            } else {
+                PP.radsecPoolType="generic";
+                UpdateRadiusServerEntry(PP.authConfig, Endpoint, Endpoint.RadiusServers[0].Authentication);
+                UpdateRadiusServerEntry(PP.acctConfig, Endpoint, Endpoint.RadiusServers[0].Accounting);
+                UpdateRadiusServerEntry(PP.coaConfig, Endpoint, Endpoint.RadiusServers[0].CoA);
+            }
+            return PP;
+        }
     };
 
 
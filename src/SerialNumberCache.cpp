@@ -27,6 +27,25 @@ namespace OpenWifi {
 		}
 	}
 
+	//	Appends the batch, sorts it alone and merges it into the sorted cache: one insert at a
+	//	time is quadratic for a bulk import, and sorting the whole cache per batch is not needed.
+	void SerialNumberCache::AddSerialNumbers(const std::vector<std::string> &SerialNumbers) {
+		std::lock_guard G(Mutex_);
+
+		const auto Sorted = SNs_.size(), ReverseSorted = Reverse_SNs_.size();
+		for (const auto &S : SerialNumbers) {
+			SNs_.push_back(std::stoull(S, nullptr, 16));
+			Reverse_SNs_.push_back(std::stoull(ReverseSerialNumber(S), nullptr, 16));
+		}
+		for (auto [V, Old] : {std::make_pair(&SNs_, Sorted),
+							  std::make_pair(&Reverse_SNs_, ReverseSorted)}) {
+			auto Middle = V->begin() + Old;
+			std::sort(Middle, V->end());
+			std::inplace_merge(V->begin(), Middle, V->end());
+			V->erase(std::unique(V->begin(), V->end()), V->end());
+		}
+	}
+
 	void SerialNumberCache::DeleteSerialNumber(const std::string &S) {
 		std::lock_guard G(Mutex_);
 
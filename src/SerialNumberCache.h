@@ -19,6 +19,7 @@ namespace OpenWifi {
 		void Stop() override;
 		void AddSerialNumber(const std::string &SerialNumber,
 							 [[maybe_unused]] const std::string &DeviceType);
+		void AddSerialNumbers(const std::vector<std::string> &SerialNumbers);
 		void DeleteSerialNumber(const std::string &SerialNumber);
 		void FindNumbers(const std::string &SerialNumber, uint HowMany, std::vector<uint64_t> &A);
 		inline std::vector<uint64_t> GetCacheCopy() {
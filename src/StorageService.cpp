@@ -272,6 +272,7 @@ namespace OpenWifi {
 	void Storage::Stop() {
 		poco_information(Logger(), "Stopping...");
 		Timer_.stop();
+		StorageClass::Stop();
 		poco_information(Logger(), "Stopped...");
 	}
 
@@ -8,6 +8,7 @@
 #include "JobController.h"
 #include "StorageService.h"
 #include "UI_Prov_WebSocketNotifications.h"
+#include "VenueRenderPlanner.h"
 #include "framework/MicroServiceFuncs.h"
 #include "sdks/SDK_gw.h"
 
@@ -64,72 +65,6 @@ namespace OpenWifi {
 		}
 	}
 
-	class VenueDeviceConfigUpdater : public Poco::Runnable {
-	  public:
-		VenueDeviceConfigUpdater(const std::string &UUID, const std::string &venue, Poco::Logger &L)
-			: uuid_(UUID), venue_(venue), Logger_(L) {}
-
-		void run() final {
-			ProvObjects::InventoryTag Device;
-			started_ = true;
-			Utils::SetThreadName("venue-cfg");
-			if (StorageService()->InventoryDB().GetRecord("id", uuid_, Device)) {
-				SerialNumber = Device.serialNumber;
-				// std::cout << "Starting push for " << Device.serialNumber << std::endl;
-				Logger().debug(fmt::format("{}: Computing configuration.", Device.serialNumber));
-				auto DeviceConfig = std::make_shared<APConfig>(Device.serialNumber,
-															   Device.deviceType, Logger(), false);
-				auto Configuration = Poco::makeShared<Poco::JSON::Object>();
-				try {
-					if (DeviceConfig->Get(Configuration)) {
-						std::ostringstream OS;
-						Configuration->stringify(OS);
-						auto Response = Poco::makeShared<Poco::JSON::Object>();
-						poco_debug(Logger(),
-								   fmt::format("{}: Pushing configuration.", Device.serialNumber));
-						if (SDK::GW::Device::Configure(nullptr, Device.serialNumber, Configuration,
-													   Response)) {
-							Logger().debug(
-								fmt::format("{}: Configuration pushed.", Device.serialNumber));
-							poco_information(Logger(),
-											 fmt::format("{}: Updated.", Device.serialNumber));
-							// std::cout << Device.serialNumber << ": Updated" << std::endl;
-							updated_++;
-						} else {
-							poco_information(Logger(),
-											 fmt::format("{}: Not updated.", Device.serialNumber));
-							// std::cout << Device.serialNumber << ": Failed" << std::endl;
-							failed_++;
-						}
-					} else {
-						poco_debug(Logger(),
-								   fmt::format("{}: Configuration is bad.", Device.serialNumber));
-						bad_config_++;
-						// std::cout << Device.serialNumber << ": Bad config" << std::endl;
-					}
-				} catch (...) {
-					poco_debug(Logger(),
-							   fmt::format("{}: Configuration is bad (caused an exception).",
-										   Device.serialNumber));
-					bad_config_++;
-				}
-			}
-			done_ = true;
-			// std::cout << "Done push for " << Device.serialNumber << std::endl;
-			Utils::SetThreadName("free");
-		}
-
-		uint64_t updated_ = 0, failed_ = 0, bad_config_ = 0;
-		bool started_ = false, done_ = false;
-		std::string SerialNumber;
-
-	  private:
-		std::string uuid_;
-		std::string venue_;
-		Poco::Logger &Logger_;
-		inline Poco::Logger &Logger() { return Logger_; }
-	};
-
 	class VenueConfigUpdater : public Job {
 	  public:
 		VenueConfigUpdater(const std::string &JobID, const std::string &name,
@@ -152,68 +87,69 @@ namespace OpenWifi {
 				N.content.title = fmt::format("Updating {} configurations", Venue.info.name);
 				N.content.jobId = JobId();
 
-				Poco::ThreadPool Pool_;
-				std::list<VenueDeviceConfigUpdater *> JobList;
+				VenueRenderPlanner Planner(Logger());
                 std::vector<std::string> DeviceList;
                 StorageService()->InventoryDB().GetDevicesUUIDForVenue(Venue.info.id, DeviceList);
-				for (const auto &uuid : DeviceList) {
-					auto NewTask = new VenueDeviceConfigUpdater(uuid, Venue.info.name, Logger());
-					bool TaskAdded = false;
-					while (!TaskAdded) {
-						if (Pool_.available()) {
-							JobList.push_back(NewTask);
-							Pool_.start(*NewTask);
-							TaskAdded = true;
-							continue;
-						}
+				ProvObjects::InventoryTagVec Devices;
+				StorageService()->InventoryDB().GetRecordsIn("id", DeviceList, Devices);
+
+				//	Each configuration is sent as soon as it is rendered, and the answers are
+				//	awaited once all of them are out.
+				std::vector<std::pair<std::string, std::future<SDK::GW::Device::Async::CommandResult>>>
+					Calls;
+				for (const auto &Device : Devices) {
+					Logger().debug(fmt::format("{}: Computing configuration.", Device.serialNumber));
+					auto Configuration = Poco::makeShared<Poco::JSON::Object>();
+					bool Rendered = false;
+					try {
+						Rendered = Planner.Render(Device, Configuration);
+					} catch (...) {
+						poco_debug(Logger(),
+								   fmt::format("{}: Configuration is bad (caused an exception).",
+											   Device.serialNumber));
+						N.content.error.push_back(Device.serialNumber);
+						BadConfigs++;
+						continue;
 					}
-
-					for (auto job_it = JobList.begin(); job_it != JobList.end();) {
-						VenueDeviceConfigUpdater *current_job = *job_it;
-						if (current_job != nullptr && current_job->done_) {
-							Updated += current_job->updated_;
-							Failed += current_job->failed_;
-							BadConfigs += current_job->bad_config_;
-							if (current_job->updated_) {
-								N.content.success.push_back(current_job->SerialNumber);
-							} else if (current_job->failed_) {
-								N.content.warning.push_back(current_job->SerialNumber);
-							} else {
-								N.content.error.push_back(current_job->SerialNumber);
-							}
-							job_it = JobList.erase(job_it);
-							delete current_job;
-						} else {
-							++job_it;
-						}
+					if (!Rendered) {
+						poco_debug(Logger(),
+								   fmt::format("{}: Configuration is bad.", Device.serialNumber));
+						N.content.error.push_back(Device.serialNumber);
+						BadConfigs++;
+						continue;
 					}
+					poco_debug(Logger(),
+							   fmt::format("{}: Pushing configuration.", Device.serialNumber));
+					Calls.emplace_back(Device.serialNumber,
+									   SDK::GW::Device::Async::Configure(Device.serialNumber,
+																		 Configuration));
 				}
 
-				poco_debug(Logger(), "Waiting for outstanding update threads to finish.");
-				Pool_.joinAll();
-				for (auto job_it = JobList.begin(); job_it != JobList.end();) {
-					VenueDeviceConfigUpdater *current_job = *job_it;
-					if (current_job != nullptr && current_job->done_) {
-						Updated += current_job->updated_;
-						Failed += current_job->failed_;
-						BadConfigs += current_job->bad_config_;
-						if (current_job->updated_) {
-							N.content.success.push_back(current_job->SerialNumber);
-						} else if (current_job->failed_) {
-							N.content.warning.push_back(current_job->SerialNumber);
-						} else {
-							N.content.error.push_back(current_job->SerialNumber);
-						}
-						job_it = JobList.erase(job_it);
-						delete current_job;
+				for (auto &[SerialNumber, Call] : Calls) {
+					SDK::GW::Device::Async::CommandResult R;
+					try {
+						R = Call.get();
+					} catch (const Poco::Exception &E) {
+						Logger().log(E);
+					} catch (const std::exception &E) {
+						poco_warning(Logger(), fmt::format("{}: {}", SerialNumber, E.what()));
+					}
+					if (R.Success) {
+						poco_information(Logger(), fmt::format("{}: Updated.", SerialNumber));
+						N.content.success.push_back(SerialNumber);
+						Updated++;
 					} else {
-						++job_it;
+						poco_information(Logger(), fmt::format("{}: Not updated.", SerialNumber));
+						N.content.warning.push_back(SerialNumber);
+						Failed++;
 					}
 				}
 
 				N.content.details = fmt::format(
 					"Job {} Completed: {} updated, {} failed to update, {} bad configurations. ",
 					JobId(), Updated, Failed, BadConfigs);
+				poco_debug(Logger(), fmt::format("Job {}: {} devices rendered from {} groups.",
+												 JobId(), DeviceList.size(), Planner.Groups()));
 
 			} else {
 				N.content.details = fmt::format("Venue {} no longer exists.", VenueUUID_);
@@ -11,40 +11,6 @@
 
 namespace OpenWifi {
 
-	class VenueDeviceRebooter : public Poco::Runnable {
-	  public:
-		VenueDeviceRebooter(const std::string &UUID, const std::string &venue, Poco::Logger &L)
-			: uuid_(UUID), venue_(venue), Logger_(L) {}
-
-		void run() final {
-			ProvObjects::InventoryTag Device;
-			started_ = true;
-			if (StorageService()->InventoryDB().GetRecord("id", uuid_, Device)) {
-				SerialNumber = Device.serialNumber;
-				if (SDK::GW::Device::Reboot(Device.serialNumber, 0)) {
-					Logger().debug(fmt::format("{}: Rebooted.", Device.serialNumber));
-					rebooted_++;
-				} else {
-					poco_information(Logger(),
-									 fmt::format("{}: Not rebooted.", Device.serialNumber));
-					failed_++;
-				}
-			}
-			done_ = true;
-			// std::cout << "Done push for " << Device.serialNumber << std::endl;
-		}
-
-		uint64_t rebooted_ = 0, failed_ = 0;
-		bool started_ = false, done_ = false;
-		std::string SerialNumber;
-
-	  private:
-		std::string uuid_;
-		std::string venue_;
-		Poco::Logger &Logger_;
-		inline Poco::Logger &Logger() { return Logger_; }
-	};
-
 	class VenueRebooter : public Job {
 	  public:
 		VenueRebooter(const std::string &JobID, const std::string &name,
@@ -66,55 +32,35 @@ namespace OpenWifi {
 				N.content.title = fmt::format("Rebooting {} devices.", Venue.info.name);
 				N.content.jobId = JobId();
 
-				Poco::ThreadPool Pool_;
-				std::list<VenueDeviceRebooter *> JobList;
                 std::vector<std::string> DeviceList;
                 StorageService()->InventoryDB().GetDevicesUUIDForVenue(Venue.info.id, DeviceList);
-
-				for (const auto &uuid : DeviceList) {
-					auto NewTask = new VenueDeviceRebooter(uuid, Venue.info.name, Logger());
-					bool TaskAdded = false;
-					while (!TaskAdded) {
-						if (Pool_.available()) {
-							JobList.push_back(NewTask);
-							Pool_.start(*NewTask);
-							TaskAdded = true;
-							continue;
-						}
+				ProvObjects::InventoryTagVec Devices;
+				StorageService()->InventoryDB().GetRecordsIn("id", DeviceList, Devices);
+
+				//	All the reboots are sent before the first answer is awaited.
+				std::vector<std::pair<std::string, std::future<bool>>> Calls;
+				Calls.reserve(Devices.size());
+				for (const auto &Device : Devices)
+					Calls.emplace_back(Device.serialNumber,
+									   SDK::GW::Device::Async::Reboot(Device.serialNumber, 0));
+
+				for (auto &[SerialNumber, Call] : Calls) {
+					bool Rebooted = false;
+					try {
+						Rebooted = Call.get();
+					} catch (const Poco::Exception &E) {
+						Logger().log(E);
+					} catch (const std::exception &E) {
+						poco_warning(Logger(), fmt::format("{}: {}", SerialNumber, E.what()));
 					}
-
-					for (auto job_it = JobList.begin(); job_it != JobList.end();) {
-						VenueDeviceRebooter *current_job = *job_it;
-						if (current_job != nullptr && current_job->done_) {
-							if (current_job->rebooted_)
-								N.content.success.push_back(current_job->SerialNumber);
-							else
-								N.content.warning.push_back(current_job->SerialNumber);
-							rebooted_ += current_job->rebooted_;
-							failed_ += current_job->failed_;
-							job_it = JobList.erase(job_it);
-							delete current_job;
-						} else {
-							++job_it;
-						}
-					}
-				}
-
-				Logger().debug("Waiting for outstanding update threads to finish.");
-				Pool_.joinAll();
-				for (auto job_it = JobList.begin(); job_it != JobList.end();) {
-					VenueDeviceRebooter *current_job = *job_it;
-					if (current_job != nullptr && current_job->done_) {
-						if (current_job->rebooted_)
-							N.content.success.push_back(current_job->SerialNumber);
-						else
-							N.content.warning.push_back(current_job->SerialNumber);
-						rebooted_ += current_job->rebooted_;
-						failed_ += current_job->failed_;
-						job_it = JobList.erase(job_it);
-						delete current_job;
+					if (Rebooted) {
+						Logger().debug(fmt::format("{}: Rebooted.", SerialNumber));
+						N.content.success.push_back(SerialNumber);
+						rebooted_++;
 					} else {
-						++job_it;
+						poco_information(Logger(), fmt::format("{}: Not rebooted.", SerialNumber));
+						N.content.warning.push_back(SerialNumber);
+						failed_++;
 					}
 				}
 				N.content.details =
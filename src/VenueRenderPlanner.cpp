@@ -0,0 +1,86 @@
+//
+// Created by stephane bourque on 2023-12-02.
+//
+
+#include <sstream>
+
+#include "APConfig.h"
+#include "VenueRenderPlanner.h"
+
+#include "Poco/JSON/Parser.h"
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	//	Rendered in place of the serial number, which only RADIUS nas-identifiers use.
+	static const std::string SerialNumberPlaceholder{"__deviceSerialNumber__"};
+
+	bool VenueRenderPlanner::Render(const ProvObjects::InventoryTag &Device,
+									Poco::JSON::Object::Ptr &Configuration) {
+		auto &G = GroupOf(Device);
+		std::string Text;
+		{
+			std::lock_guard Lock(G.Mutex);
+			if (!G.Rendered)
+				RenderShared(Device, G);
+			if (!G.Valid)
+				return false;
+			Text = G.Shared;
+		}
+
+		const auto Quoted = "\"" + SerialNumberPlaceholder + "\"";
+		const auto Serial = "\"" + Device.serialNumber + "\"";
+		for (auto Pos = Text.find(Quoted); Pos != std::string::npos;
+			 Pos = Text.find(Quoted, Pos + Serial.size()))
+			Text.replace(Pos, Quoted.size(), Serial);
+
+		//	A fresh parse per device: overrides change the radios in place.
+		Poco::JSON::Parser P;
+		Configuration = P.parse(Text).extract<Poco::JSON::Object::Ptr>();
+		APConfig Config(Device.serialNumber, Device.deviceType, Logger_, false);
+		try {
+			Config.ApplyOverrides(Configuration);
+		} catch (...) {
+		}
+		return true;
+	}
+
+	std::size_t VenueRenderPlanner::Groups() {
+		std::lock_guard Lock(Mutex_);
+		return Groups_.size();
+	}
+
+	VenueRenderPlanner::Group &VenueRenderPlanner::GroupOf(const ProvObjects::InventoryTag &Device) {
+		std::lock_guard Lock(Mutex_);
+		//	The entity chain wins over the venue chain, as in APConfig::AddDeviceConfig.
+		return Groups_[Key{Device.deviceConfiguration,
+						   Device.entity.empty() ? "venue:" + Device.venue
+												 : "entity:" + Device.entity,
+						   Device.deviceType}];
+	}
+
+	void VenueRenderPlanner::RenderShared(const ProvObjects::InventoryTag &Device, Group &G) {
+		G.Rendered = true;
+		APConfig Config(SerialNumberPlaceholder, Device.deviceType, Logger_, false);
+		auto Configuration = Poco::makeShared<Poco::JSON::Object>();
+		bool Merged = false;
+		try {
+			Config.AddDeviceConfig(Device);
+			Config.Merge(Configuration);
+			Merged = true;
+		} catch (const Poco::Exception &E) {
+			Logger_.log(E);
+		} catch (...) {
+		}
+		//	As APConfig::Get, which fails when merging does.
+		G.Valid = Merged && !Config.Empty();
+		if (G.Valid) {
+			std::ostringstream OS;
+			Configuration->stringify(OS);
+			G.Shared = OS.str();
+		}
+		poco_debug(Logger_, fmt::format("{}: Rendered the configuration shared with its group.",
+										Device.serialNumber));
+	}
+
+} // namespace OpenWifi
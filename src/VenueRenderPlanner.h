@@ -0,0 +1,53 @@
+//
+// Created by stephane bourque on 2023-12-02.
+//
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Logger.h"
+#include "RESTObjects/RESTAPI_ProvObjects.h"
+
+namespace OpenWifi {
+
+	//	Renders the configurations of the devices of a venue. Devices with the same device
+	//	configuration, entity or venue and device type inherit the same configurations, so the
+	//	chain lookups, variable blocks and RADIUS endpoints are resolved once per group, by the
+	//	first device of the group to get here. Each device then only parses that result with its
+	//	serial number filled in, and applies its own overrides. Render may be called from
+	//	several threads at once.
+	class VenueRenderPlanner {
+	  public:
+		explicit VenueRenderPlanner(Poco::Logger &L) : Logger_(L) {}
+
+		//	Same result as APConfig::Get for this device.
+		[[nodiscard]] bool Render(const ProvObjects::InventoryTag &Device,
+								  Poco::JSON::Object::Ptr &Configuration);
+
+		[[nodiscard]] std::size_t Groups();
+
+	  private:
+		//	Device configuration, entity or venue, device type.
+		using Key = std::tuple<std::string, std::string, std::string>;
+
+		struct Group {
+			std::mutex Mutex;
+			bool Rendered = false;
+			bool Valid = false;
+			std::string Shared; //	stringified, with the placeholder for the serial number
+		};
+
+		Poco::Logger &Logger_;
+		std::mutex Mutex_;
+		std::map<Key, Group> Groups_;
+
+		Group &GroupOf(const ProvObjects::InventoryTag &Device);
+		void RenderShared(const ProvObjects::InventoryTag &Device, Group &G);
+	};
+
+} // namespace OpenWifi
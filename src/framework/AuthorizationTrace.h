@@ -0,0 +1,177 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Logger.h"
+
+#include "RESTObjects/RESTAPI_SecurityObjects.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/SubSystemServer.h"
+#include "framework/utils.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	//	Tracing of RoleIsAuthorized decisions. Nothing is formatted unless the AUTH-TRACE logger
+	//	is at debug level and the request is selected, either because its user or resource is
+	//	listed in the configuration or because it falls in the sample.
+	class AuthorizationTrace : public SubSystemServer {
+	  public:
+		class Session {
+		  public:
+			Session(AuthorizationTrace &T, const std::string &User, SecurityObjects::USER_ROLE Role,
+					const std::string &Method, const std::string &Path)
+				: T_(T), Active_(T.Selected(User, "")), User_(User), Role_(Role),
+				  Method_(Method), Path_(Path), Start_(std::chrono::steady_clock::now()) {}
+
+			~Session() {
+				if (Active_ && Decided_)
+					T_.Emit(*this);
+			}
+			Session(const Session &) = delete;
+			Session &operator=(const Session &) = delete;
+
+			//	Called once the resource is known, so route filters and sampling can apply.
+			inline void Resource(const std::string &Resource) {
+				Resource_ = Resource;
+				if (!Active_)
+					Active_ = T_.Selected(User_, Resource);
+			}
+
+			template <typename... Args> inline void Step(const char *Format, const Args &...args) {
+				if (Active_)
+					Steps_.emplace_back(fmt::vformat(Format, fmt::make_format_args(args...)));
+			}
+
+			//	The reason is only formatted when the session is traced.
+			template <typename... Args>
+			inline bool Result(bool Granted, const char *Format, const Args &...args) {
+				Decided_ = true;
+				Granted_ = Granted;
+				if (Active_)
+					Reason_ = fmt::vformat(Format, fmt::make_format_args(args...));
+				return Granted;
+			}
+
+			inline bool Result(bool Granted, const std::string &Reason) {
+				Decided_ = true;
+				Granted_ = Granted;
+				if (Active_)
+					Reason_ = Reason;
+				return Granted;
+			}
+
+			[[nodiscard]] inline bool Active() const { return Active_; }
+
+		  private:
+			friend class AuthorizationTrace;
+			AuthorizationTrace &T_;
+			bool Active_ = false;
+			bool Decided_ = false;
+			bool Granted_ = false;
+			const std::string &User_;
+			SecurityObjects::USER_ROLE Role_;
+			const std::string &Method_;
+			const std::string &Path_;
+			std::string Resource_;
+			std::string Reason_;
+			std::vector<std::string> Steps_;
+			std::chrono::steady_clock::time_point Start_;
+		};
+
+		static auto instance() {
+			static auto instance_ = new AuthorizationTrace;
+			return instance_;
+		}
+
+		inline int Start() final {
+			std::set<std::string> Users, Resources;
+			for (const auto &u : Utils::Split(MicroServiceConfigGetString("authtrace.users", "")))
+				Users.insert(u);
+			for (const auto &r :
+				 Utils::Split(MicroServiceConfigGetString("authtrace.resources", "")))
+				Resources.insert(r);
+			std::unique_lock G(Lock_);
+			Users_ = std::move(Users);
+			Resources_ = std::move(Resources);
+			SampleEvery_ = MicroServiceConfigGetInt("authtrace.sample", 0);
+			Structured_ = MicroServiceConfigGetBool("authtrace.structured", false);
+			return 0;
+		}
+		inline void Stop() final {}
+
+		inline void reinitialize([[maybe_unused]] Poco::Util::Application &self) override {
+			MicroServiceLoadConfigurationFile();
+			Start();
+			poco_information(Logger(), "Reinitialized trace selection.");
+		}
+
+	  private:
+		std::shared_mutex Lock_;
+		std::set<std::string> Users_, Resources_;
+		uint64_t SampleEvery_ = 0;
+		bool Structured_ = false;
+		std::atomic_uint64_t Counter_ = 0;
+
+		inline bool Selected(const std::string &User, const std::string &Resource) {
+			if (!Logger().debug())
+				return false;
+			std::shared_lock G(Lock_);
+			if (Users_.count(User) || (!Resource.empty() && Resources_.count(Resource)))
+				return true;
+			if (Resource.empty() || SampleEvery_ == 0)
+				return false;
+			return (Counter_++ % SampleEvery_) == 0;
+		}
+
+		inline void Emit(const Session &S) {
+			auto Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+							   std::chrono::steady_clock::now() - S.Start_)
+							   .count();
+			if (Structured_) {
+				Poco::JSON::Object Record;
+				Record.set("user", S.User_);
+				Record.set("role", SecurityObjects::UserTypeToString(S.Role_));
+				Record.set("method", S.Method_);
+				Record.set("path", S.Path_);
+				Record.set("resource", S.Resource_);
+				Record.set("granted", S.Granted_);
+				Record.set("reason", S.Reason_);
+				Record.set("elapsedUs", Elapsed);
+				Poco::JSON::Array Steps;
+				for (const auto &i : S.Steps_)
+					Steps.add(i);
+				Record.set("steps", Steps);
+				std::ostringstream OS;
+				Record.stringify(OS);
+				Logger().debug(OS.str());
+				return;
+			}
+			for (const auto &i : S.Steps_)
+				Logger().debug(fmt::format("AUTH_TRACE: User='{}' {}", S.User_, i));
+			Logger().debug(fmt::format(
+				"AUTH_TRACE: User='{}' Role='{}' Method='{}' Path='{}' Resource='{}' -> {} ({}us){}",
+				S.User_, SecurityObjects::UserTypeToString(S.Role_), S.Method_, S.Path_, S.Resource_,
+				S.Granted_ ? "granted" : "denied", Elapsed,
+				S.Reason_.empty() ? "" : " Reason='" + S.Reason_ + "'"));
+		}
+
+		AuthorizationTrace() noexcept
+			: SubSystemServer("AuthorizationTrace", "AUTH-TRACE", "authtrace") {}
+	};
+
+	inline auto AuthorizationTrace() { return AuthorizationTrace::instance(); }
+
+} // namespace OpenWifi
@@ -5,6 +5,7 @@
 #include "KafkaManager.h"
 
 #include "fmt/format.h"
+#include "framework/MetricsRegistry.h"
 #include "framework/MicroServiceFuncs.h"
 #include "cppkafka/utils/consumer_dispatcher.h"
 
@@ -193,20 +194,7 @@ namespace OpenWifi {
 			// Callback executed whenever a new message is consumed
 			[&](cppkafka::Message msg) {
 				// Print the key (if any)
-				std::lock_guard G(ConsumerMutex_);
-				auto It = Notifiers_.find(msg.get_topic());
-				if (It != Notifiers_.end()) {
-					const auto &FL = It->second;
-					for (const auto &[CallbackFunc, _] : FL) {
-						try {
-							CallbackFunc(msg.get_key(), msg.get_payload());
-						} catch(const Poco::Exception &E) {
-
-						} catch(...) {
-
-						}
-					}
-				}
+				Deliver(msg.get_topic(), msg.get_key(), msg.get_payload());
 				Consumer.commit(msg);
 			},
 			// Whenever there's an error (other than the EOF soft error)
@@ -225,6 +213,9 @@ namespace OpenWifi {
 
 	void KafkaProducer::Start() {
 		if (!Running_) {
+			MetricsRegistry()->GaugeFunction("owprov_queue_depth", "Messages waiting in internal queues.",
+											 [this] { return (double)Queue_.size(); },
+											 {{"queue", "kafka_producer"}});
 			Running_ = true;
 			Worker_.start(*this);
 		}
@@ -275,6 +266,24 @@ namespace OpenWifi {
 		return FunctionId_++;
 	}
 
+	void KafkaConsumer::Deliver(const std::string &Topic, const std::string &Key,
+								const std::string &Payload) {
+		std::lock_guard G(ConsumerMutex_);
+		auto It = Notifiers_.find(Topic);
+		if (It != Notifiers_.end()) {
+			const auto &FL = It->second;
+			for (const auto &[CallbackFunc, _] : FL) {
+				try {
+					CallbackFunc(Key, Payload);
+				} catch(const Poco::Exception &E) {
+
+				} catch(...) {
+
+				}
+			}
+		}
+	}
+
 	void KafkaConsumer::UnregisterTopicWatcher(const std::string &Topic, int Id) {
 		std::lock_guard G(ConsumerMutex_);
 		auto It = Notifiers_.find(Topic);
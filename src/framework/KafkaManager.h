@@ -63,6 +63,7 @@ namespace OpenWifi {
 		friend class KafkaManager;
 		std::uint64_t RegisterTopicWatcher(const std::string &Topic, Types::TopicNotifyFunction &F);
 		void UnregisterTopicWatcher(const std::string &Topic, int Id);
+		void Deliver(const std::string &Topic, const std::string &Key, const std::string &Payload);
 	};
 
 	class KafkaManager : public SubSystemServer {
@@ -93,6 +94,12 @@ namespace OpenWifi {
 		inline void UnregisterTopicWatcher(const std::string &Topic, uint64_t Id) {
 			return ConsumerThr_.UnregisterTopicWatcher(Topic,Id);
 		}
+		//	Hands a message to the topic watchers as if it had been consumed from the broker.
+		//	Works with Kafka disabled: the load generator uses it in place of a broker.
+		inline void Deliver(const std::string &Topic, const std::string &Key,
+							const std::string &Payload) {
+			ConsumerThr_.Deliver(Topic, Key, Payload);
+		}
 
 		std::uint64_t KafkaManagerMaximumPayloadSize() const { return MaxPayloadSize_; }
 
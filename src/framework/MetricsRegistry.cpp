@@ -0,0 +1,135 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include "framework/MetricsRegistry.h"
+
+#include <sstream>
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	//	Bucket bounds published for histograms, in seconds. The recorded buckets are finer, so
+	//	each published bucket is the sum of the recorded ones that end at or below its bound.
+	static const std::vector<double> PublishedBounds{0.0005, 0.001, 0.0025, 0.005, 0.01,
+													  0.025,  0.05,  0.1,	  0.25,	 0.5,
+													  1.0,	  2.5,	 5.0,	  10.0,	 30.0};
+
+	std::string MetricsRegistry::FormatLabels(const Labels &L) {
+		if (L.empty())
+			return "";
+		std::string Result{"{"};
+		for (const auto &[Key, Value] : L) {
+			if (Result.size() > 1)
+				Result += ',';
+			Result += Key;
+			Result += "=\"";
+			for (auto c : Value) {
+				if (c == '\\' || c == '"')
+					Result += '\\';
+				if (c == '\n') {
+					Result += "\\n";
+					continue;
+				}
+				Result += c;
+			}
+			Result += '"';
+		}
+		Result += '}';
+		return Result;
+	}
+
+	template <typename T>
+	T &MetricsRegistry::Find(const std::string &Name, const std::string &Help, Type Ty,
+							 const Labels &L, std::map<std::string, std::unique_ptr<T>> Family::*Member) {
+		auto Key = FormatLabels(L);
+		{
+			std::shared_lock G(Mutex_);
+			auto F = Families_.find(Name);
+			if (F != Families_.end()) {
+				auto &Metrics = F->second.*Member;
+				auto M = Metrics.find(Key);
+				if (M != Metrics.end())
+					return *M->second;
+			}
+		}
+		std::unique_lock G(Mutex_);
+		auto &F = Families_[Name];
+		if (F.Help.empty()) {
+			F.Kind = Ty;
+			F.Help = Help;
+		}
+		auto &M = (F.*Member)[Key];
+		if (!M)
+			M = std::make_unique<T>();
+		return *M;
+	}
+
+	MetricsCounter &MetricsRegistry::Counter(const std::string &Name, const std::string &Help,
+											 const Labels &L) {
+		return Find(Name, Help, Type::counter, L, &Family::Counters);
+	}
+
+	MetricsGauge &MetricsRegistry::Gauge(const std::string &Name, const std::string &Help,
+										 const Labels &L) {
+		return Find(Name, Help, Type::gauge, L, &Family::Gauges);
+	}
+
+	MetricsHistogram &MetricsRegistry::Histogram(const std::string &Name, const std::string &Help,
+												 const Labels &L) {
+		return Find(Name, Help, Type::histogram, L, &Family::Histograms);
+	}
+
+	void MetricsRegistry::GaugeFunction(const std::string &Name, const std::string &Help,
+										std::function<double()> F, const Labels &L) {
+		std::unique_lock G(Mutex_);
+		auto &Fam = Families_[Name];
+		Fam.Kind = Type::gauge;
+		Fam.Help = Help;
+		Fam.Functions[FormatLabels(L)] = std::move(F);
+	}
+
+	//	Adds a label to an already formatted label set.
+	static std::string WithLabel(const std::string &Labels, const std::string &Extra) {
+		if (Labels.empty())
+			return "{" + Extra + "}";
+		return Labels.substr(0, Labels.size() - 1) + "," + Extra + "}";
+	}
+
+	std::string MetricsRegistry::Prometheus() {
+		std::ostringstream OS;
+		std::shared_lock G(Mutex_);
+		for (const auto &[Name, F] : Families_) {
+			OS << "# HELP " << Name << " " << F.Help << "\n";
+			OS << "# TYPE " << Name << " "
+			   << (F.Kind == Type::counter ? "counter" : F.Kind == Type::gauge ? "gauge" : "histogram")
+			   << "\n";
+			for (const auto &[Labels, C] : F.Counters)
+				OS << Name << Labels << " " << C->Value() << "\n";
+			for (const auto &[Labels, Gauge] : F.Gauges)
+				OS << Name << Labels << " " << Gauge->Value() << "\n";
+			for (const auto &[Labels, Fn] : F.Functions)
+				OS << Name << Labels << " " << Fn() << "\n";
+			for (const auto &[Labels, H] : F.Histograms) {
+				std::uint64_t Cumulative = 0;
+				std::size_t Bucket = 0;
+				for (auto Bound : PublishedBounds) {
+					auto Limit = (std::uint64_t)(Bound * 1000000.0);
+					while (Bucket < MetricsHistogram::Buckets &&
+						   MetricsHistogram::UpperBound(Bucket) <= Limit)
+						Cumulative += H->BucketCount(Bucket++);
+					OS << Name << "_bucket" << WithLabel(Labels, fmt::format("le=\"{}\"", Bound))
+					   << " " << Cumulative << "\n";
+				}
+				OS << Name << "_bucket" << WithLabel(Labels, "le=\"+Inf\"") << " " << H->Count()
+				   << "\n";
+				OS << Name << "_sum" << Labels << " " << fmt::format("{:.6f}", H->Sum() / 1000000.0)
+				   << "\n";
+				OS << Name << "_count" << Labels << " " << H->Count() << "\n";
+			}
+		}
+		return OS.str();
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,173 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenWifi {
+
+	class MetricsCounter {
+	  public:
+		inline void Inc(std::uint64_t V = 1) { Value_.fetch_add(V, std::memory_order_relaxed); }
+		[[nodiscard]] inline std::uint64_t Value() const {
+			return Value_.load(std::memory_order_relaxed);
+		}
+
+	  private:
+		std::atomic_uint64_t Value_{0};
+	};
+
+	class MetricsGauge {
+	  public:
+		inline void Set(std::int64_t V) { Value_.store(V, std::memory_order_relaxed); }
+		inline void Add(std::int64_t V) { Value_.fetch_add(V, std::memory_order_relaxed); }
+		[[nodiscard]] inline std::int64_t Value() const {
+			return Value_.load(std::memory_order_relaxed);
+		}
+
+	  private:
+		std::atomic_int64_t Value_{0};
+	};
+
+	//	Log-linear histogram of microsecond values, in the manner of HDR histograms: every
+	//	power of two is split in 8 buckets, so any value is recorded within 12.5% of its
+	//	magnitude. Recording is two relaxed atomic adds and a bucket increment.
+	class MetricsHistogram {
+	  public:
+		static constexpr std::size_t SubBuckets = 8;
+		static constexpr std::size_t MaxExponent = 40; //	about 12 days
+		static constexpr std::size_t Buckets = SubBuckets + (MaxExponent - 3) * SubBuckets;
+
+		inline void Observe(std::uint64_t Microseconds) {
+			Counts_[Index(Microseconds)].fetch_add(1, std::memory_order_relaxed);
+			Sum_.fetch_add(Microseconds, std::memory_order_relaxed);
+			Count_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		template <typename Duration> inline void Observe(Duration D) {
+			Observe((std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(D).count());
+		}
+
+		static inline std::size_t Index(std::uint64_t V) {
+			if (V < SubBuckets)
+				return V;
+			std::size_t Exponent = 63 - __builtin_clzll(V);
+			if (Exponent >= MaxExponent)
+				return Buckets - 1;
+			return SubBuckets + (Exponent - 3) * SubBuckets + ((V >> (Exponent - 3)) & (SubBuckets - 1));
+		}
+
+		//	Smallest value that no longer falls in the bucket.
+		static inline std::uint64_t UpperBound(std::size_t I) {
+			if (I < SubBuckets)
+				return I + 1;
+			auto Exponent = (I - SubBuckets) / SubBuckets + 3;
+			auto Sub = (I - SubBuckets) % SubBuckets;
+			return (SubBuckets + Sub + 1) << (Exponent - 3);
+		}
+
+		[[nodiscard]] inline std::uint64_t Count() const { return Count_.load(std::memory_order_relaxed); }
+		[[nodiscard]] inline std::uint64_t Sum() const { return Sum_.load(std::memory_order_relaxed); }
+		[[nodiscard]] inline std::uint64_t BucketCount(std::size_t I) const {
+			return Counts_[I].load(std::memory_order_relaxed);
+		}
+
+	  private:
+		std::array<std::atomic_uint64_t, Buckets> Counts_{};
+		std::atomic_uint64_t Sum_{0};
+		std::atomic_uint64_t Count_{0};
+	};
+
+	//	Records the time spent in a scope.
+	class MetricsTimer {
+	  public:
+		explicit MetricsTimer(MetricsHistogram &H)
+			: H_(H), Start_(std::chrono::steady_clock::now()) {}
+		~MetricsTimer() { H_.Observe(std::chrono::steady_clock::now() - Start_); }
+		MetricsTimer(const MetricsTimer &) = delete;
+		MetricsTimer &operator=(const MetricsTimer &) = delete;
+
+	  private:
+		MetricsHistogram &H_;
+		std::chrono::steady_clock::time_point Start_;
+	};
+
+	//	Process-wide metrics, exposed in the Prometheus text format by RESTAPI_metrics_handler.
+	//	Metrics are created on first use and live as long as the process, so callers keep the
+	//	returned reference instead of looking it up on every event.
+	class MetricsRegistry {
+	  public:
+		using Labels = std::vector<std::pair<std::string, std::string>>;
+
+		static auto instance() {
+			static auto instance_ = new MetricsRegistry;
+			return instance_;
+		}
+
+		MetricsCounter &Counter(const std::string &Name, const std::string &Help,
+								const Labels &L = {});
+		MetricsGauge &Gauge(const std::string &Name, const std::string &Help,
+							const Labels &L = {});
+		MetricsHistogram &Histogram(const std::string &Name, const std::string &Help,
+									const Labels &L = {});
+		//	A gauge read when metrics are collected, e.g. the depth of a queue.
+		void GaugeFunction(const std::string &Name, const std::string &Help,
+						   std::function<double()> F, const Labels &L = {});
+
+		[[nodiscard]] std::string Prometheus();
+
+	  private:
+		enum class Type { counter, gauge, histogram };
+
+		struct Family {
+			Type Kind = Type::counter;
+			std::string Help;
+			std::map<std::string, std::unique_ptr<MetricsCounter>> Counters;
+			std::map<std::string, std::unique_ptr<MetricsGauge>> Gauges;
+			std::map<std::string, std::unique_ptr<MetricsHistogram>> Histograms;
+			std::map<std::string, std::function<double()>> Functions;
+		};
+
+		std::shared_mutex Mutex_;
+		std::map<std::string, Family> Families_;
+
+		static std::string FormatLabels(const Labels &L);
+		template <typename T>
+		T &Find(const std::string &Name, const std::string &Help, Type Ty, const Labels &L,
+				std::map<std::string, std::unique_ptr<T>> Family::*Member);
+
+		MetricsRegistry() noexcept = default;
+	};
+
+	inline auto MetricsRegistry() { return MetricsRegistry::instance(); }
+
+	//	Hit and miss counts of a cache, as owprov_cache_requests_total{cache,result}.
+	class MetricsCacheStats {
+	  public:
+		explicit MetricsCacheStats(const std::string &Cache)
+			: Hits_(MetricsRegistry()->Counter("owprov_cache_requests_total", "Cache lookups.",
+											   {{"cache", Cache}, {"result", "hit"}})),
+			  Misses_(MetricsRegistry()->Counter("owprov_cache_requests_total", "Cache lookups.",
+												 {{"cache", Cache}, {"result", "miss"}})) {}
+
+		inline void Hit() { Hits_.Inc(); }
+		inline void Miss() { Misses_.Inc(); }
+
+	  private:
+		MetricsCounter &Hits_;
+		MetricsCounter &Misses_;
+	};
+
+} // namespace OpenWifi
@@ -19,6 +19,7 @@
 
 #include "framework/ALBserver.h"
 #include "framework/AuthClient.h"
+#include "framework/AuthorizationTrace.h"
 #include "framework/KafkaManager.h"
 #include "framework/MicroService.h"
 #include "framework/MicroServiceErrorHandler.h"
@@ -26,6 +27,7 @@
 #include "framework/RESTAPI_ExtServer.h"
 #include "framework/RESTAPI_GenericServerAccounting.h"
 #include "framework/RESTAPI_IntServer.h"
+#include "framework/RESTAPI_RateLimiter.h"
 #include "framework/UI_WebSocketClientServer.h"
 #include "framework/WebSocketLogger.h"
 #include "framework/utils.h"
@@ -443,6 +445,8 @@ namespace OpenWifi {
             SubSystems_.push_back(ALBHealthCheckServer());
             SubSystems_.push_back(RESTAPI_ExtServer());
             SubSystems_.push_back(RESTAPI_IntServer());
+            SubSystems_.push_back(RESTAPI_RateLimiter());
+            SubSystems_.push_back(AuthorizationTrace());
 #ifndef TIP_SECURITY_SERVICE
             SubSystems_.push_back(AuthClient());
 #endif
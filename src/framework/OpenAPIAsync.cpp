@@ -0,0 +1,117 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include "OpenAPIAsync.h"
+
+#include <algorithm>
+
+#include "Poco/Logger.h"
+#include "fmt/format.h"
+
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	//	The engine whose worker runs on this thread, if any.
+	static thread_local const OpenAPIAsyncEngine *CurrentEngine = nullptr;
+
+	OpenAPIAsyncEngine *OpenAPIAsyncEngine::instance() {
+		static auto instance_ =
+			new OpenAPIAsyncEngine("OpenAPIAsync", "REST-CALLER-ASYNC", "api-async",
+								   "openwifi.openapi.async.threads",
+								   "openwifi.openapi.async.maxinflight");
+		return instance_;
+	}
+
+	OpenAPIAsyncEngine *OpenAPIAsyncEngine::Hedges() {
+		static auto instance_ =
+			new OpenAPIAsyncEngine("OpenAPIHedges", "REST-CALLER-HEDGE", "api-hedge",
+								   "openwifi.openapi.hedge.max", "openwifi.openapi.hedge.max");
+		return instance_;
+	}
+
+	int OpenAPIAsyncEngine::Start() {
+		poco_information(Logger(), "Starting...");
+		std::lock_guard G(QueueMutex_);
+		if (Running_)
+			return 0;
+		Threads_ = std::max<std::uint64_t>(1, MicroServiceConfigGetInt(ThreadsKey_, 8));
+		MaxInFlight_ = std::max<std::uint64_t>(1, MicroServiceConfigGetInt(MaxInFlightKey_, 256));
+		Running_ = true;
+		for (std::uint64_t i = 0; i < Threads_; ++i)
+			Workers_.emplace_back([this]() { Worker(); });
+		return 0;
+	}
+
+	//	Calls already queued still run before the threads exit.
+	void OpenAPIAsyncEngine::Stop() {
+		poco_information(Logger(), "Stopping...");
+		{
+			std::lock_guard G(QueueMutex_);
+			Running_ = false;
+		}
+		Work_.notify_all();
+		for (auto &Worker : Workers_)
+			if (Worker.joinable())
+				Worker.join();
+		Workers_.clear();
+		poco_information(Logger(), "Stopped...");
+	}
+
+	void OpenAPIAsyncEngine::Run(std::function<void()> Job) {
+		if (!TryEnqueue(Job))
+			Execute(Job);
+	}
+
+	//	Job is only moved from when it was queued.
+	bool OpenAPIAsyncEngine::TryEnqueue(std::function<void()> &Job) {
+		if (CurrentEngine == this)
+			return false;
+		std::lock_guard G(QueueMutex_);
+		if (!Running_ || InFlight_ >= MaxInFlight_)
+			return false;
+		InFlight_++;
+		Queue_.emplace_back(std::move(Job));
+		Work_.notify_one();
+		return true;
+	}
+
+	void OpenAPIAsyncEngine::Execute(std::function<void()> &Job) {
+		try {
+			Job();
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		} catch (const std::exception &E) {
+			poco_error(Logger(), fmt::format("Unexpected exception in call: {}", E.what()));
+		} catch (...) {
+			poco_error(Logger(), "Unexpected exception in call.");
+		}
+	}
+
+	std::uint64_t OpenAPIAsyncEngine::InFlight() {
+		std::lock_guard G(QueueMutex_);
+		return InFlight_;
+	}
+
+	void OpenAPIAsyncEngine::Worker() {
+		Utils::SetThreadName(ThreadName_.c_str());
+		CurrentEngine = this;
+		while (true) {
+			std::function<void()> Job;
+			{
+				std::unique_lock L(QueueMutex_);
+				Work_.wait(L, [this] { return !Queue_.empty() || !Running_; });
+				if (Queue_.empty())
+					return;
+				Job = std::move(Queue_.front());
+				Queue_.pop_front();
+			}
+			Execute(Job);
+			std::lock_guard G(QueueMutex_);
+			InFlight_--;
+		}
+	}
+
+} // namespace OpenWifi
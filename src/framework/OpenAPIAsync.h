@@ -0,0 +1,97 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	struct OpenAPICallResult {
+		Poco::Net::HTTPServerResponse::HTTPStatus Status =
+			Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
+		Poco::JSON::Object::Ptr Response;
+	};
+
+	//	Runs SDK calls on a small set of client threads and hands back futures. The number of
+	//	calls queued or running is capped. A call submitted past the cap, from one of the
+	//	engine's own threads, or while the engine is stopped runs on the caller's thread, so
+	//	Submit never blocks and nested calls cannot deadlock.
+	class OpenAPIAsyncEngine : public SubSystemServer {
+	  public:
+		static OpenAPIAsyncEngine *instance();
+
+		//	Runs the hedged GET calls: as many threads as hedges allowed at once, and no queue.
+		static OpenAPIAsyncEngine *Hedges();
+
+		int Start() override;
+		void Stop() override;
+
+		template <typename Fn> auto Submit(Fn &&F) -> std::future<decltype(F())> {
+			using Result = decltype(F());
+			auto Task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(F));
+			auto Future = Task->get_future();
+			Run([Task]() { (*Task)(); });
+			return Future;
+		}
+
+		//	OnComplete is always called, with a ready future: get() returns the result of F, or
+		//	rethrows what F threw.
+		template <typename Fn, typename Callback> void Submit(Fn &&F, Callback &&OnComplete) {
+			using Result = decltype(F());
+			Run([F = std::forward<Fn>(F),
+				 OnComplete = std::forward<Callback>(OnComplete)]() mutable {
+				std::packaged_task<Result()> Task(std::move(F));
+				Task();
+				OnComplete(Task.get_future());
+			});
+		}
+
+		//	Starts F right away if a slot is free, without waiting. Returns false otherwise, and
+		//	when called from one of the engine's own threads or while it is stopped.
+		template <typename Fn> bool TryRun(Fn &&F) {
+			std::function<void()> Job(std::forward<Fn>(F));
+			return TryEnqueue(Job);
+		}
+
+		[[nodiscard]] std::uint64_t InFlight();
+
+	  private:
+		std::mutex QueueMutex_;
+		std::condition_variable Work_;
+		std::deque<std::function<void()>> Queue_;
+		std::vector<std::thread> Workers_;
+		std::uint64_t InFlight_ = 0;
+		std::uint64_t MaxInFlight_ = 256;
+		std::uint64_t Threads_ = 8;
+		bool Running_ = false;
+		std::string ThreadName_, ThreadsKey_, MaxInFlightKey_;
+
+		OpenAPIAsyncEngine(const std::string &Name, const std::string &LoggingPrefix,
+						   const std::string &ThreadName, const std::string &ThreadsKey,
+						   const std::string &MaxInFlightKey)
+			: SubSystemServer(Name, LoggingPrefix, "openwifi.openapi"), ThreadName_(ThreadName),
+			  ThreadsKey_(ThreadsKey), MaxInFlightKey_(MaxInFlightKey) {}
+		void Run(std::function<void()> Job);
+		bool TryEnqueue(std::function<void()> &Job);
+		void Execute(std::function<void()> &Job);
+		void Worker();
+	};
+
+	inline auto OpenAPIAsync() { return OpenAPIAsyncEngine::instance(); }
+
+} // namespace OpenWifi
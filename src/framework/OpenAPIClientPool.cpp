@@ -0,0 +1,117 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include "OpenAPIClientPool.h"
+
+#include "Poco/Logger.h"
+#include "Poco/Net/HTTPSClientSession.h"
+#include "Poco/Net/SSLManager.h"
+#include "Poco/NullStream.h"
+#include "Poco/StreamCopier.h"
+
+#include "framework/MicroServiceFuncs.h"
+
+namespace OpenWifi {
+
+	OpenAPIClientPool::OpenAPIClientPool() {
+		MaxIdle_ = MicroServiceConfigGetInt("openwifi.openapi.pool.maxidle", 8);
+		MaxTotal_ = MicroServiceConfigGetInt("openwifi.openapi.pool.maxtotal", 128);
+		IdleTimeout_ = MicroServiceConfigGetInt("openwifi.openapi.pool.idletimeout", 30);
+		try {
+			Poco::Net::SSLManager::instance().defaultClientContext()->enableSessionCache(true);
+		} catch (const Poco::Exception &E) {
+			Poco::Logger::get("REST-CALLER-POOL").log(E);
+		}
+	}
+
+	void OpenAPIClientPool::Lease::Done(const Poco::Net::HTTPResponse &Response,
+										std::istream &is) {
+		Poco::NullOutputStream Discard;
+		Poco::StreamCopier::copyStream(is, Discard);
+		Reusable_ = Response.getKeepAlive() && is.eof() && !is.bad();
+	}
+
+	OpenAPIClientPool::SessionPtr
+	OpenAPIClientPool::NewSession(const Poco::URI &URI, Poco::Net::Session::Ptr TLSSession) {
+		SessionPtr Session;
+		if (URI.getScheme() == "https") {
+			Session = std::make_unique<Poco::Net::HTTPSClientSession>(
+				URI.getHost(), URI.getPort(),
+				Poco::Net::SSLManager::instance().defaultClientContext(), TLSSession);
+		} else {
+			Session = std::make_unique<Poco::Net::HTTPClientSession>(URI.getHost(), URI.getPort());
+		}
+		Session->setKeepAlive(true);
+		Session->setKeepAliveTimeout(Poco::Timespan(IdleTimeout_, 0));
+		return Session;
+	}
+
+	bool OpenAPIClientPool::Healthy(IdleSession &S) const {
+		auto Age = std::chrono::steady_clock::now() - S.Since;
+		if (Age > std::chrono::seconds(IdleTimeout_) || !S.Session->connected())
+			return false;
+		try {
+			//	An idle keep-alive connection has nothing to read: readable means the peer
+			//	closed it or sent garbage.
+			return !S.Session->socket().poll(Poco::Timespan(0),
+											  Poco::Net::Socket::SELECT_READ |
+												  Poco::Net::Socket::SELECT_ERROR);
+		} catch (...) {
+			return false;
+		}
+	}
+
+	OpenAPIClientPool::Lease OpenAPIClientPool::Acquire(const Poco::URI &URI,
+													   std::uint64_t msTimeout) {
+		auto Key = URI.getScheme() + "://" + URI.getHost() + ":" + std::to_string(URI.getPort());
+		auto Timeout = Poco::Timespan(msTimeout / 1000, (msTimeout % 1000) * 1000);
+
+		std::vector<SessionPtr> Stale;
+		std::lock_guard G(Mutex_);
+		auto &EP = EndPoints_[Key];
+		while (!EP.Idle.empty()) {
+			auto S = std::move(EP.Idle.back());
+			EP.Idle.pop_back();
+			if (Healthy(S)) {
+				S.Session->setTimeout(Timeout);
+				return Lease(*this, Key, std::move(S.Session), true);
+			}
+			Total_--;
+			Stale.emplace_back(std::move(S.Session));
+		}
+
+		//	Past the total bound we still serve the call, but the session is not kept.
+		bool Pooled = Total_ < MaxTotal_;
+		if (Pooled)
+			Total_++;
+		auto Session = NewSession(URI, EP.TLSSession);
+		Session->setTimeout(Timeout);
+		return Lease(*this, Key, std::move(Session), Pooled);
+	}
+
+	void OpenAPIClientPool::Release(const std::string &Key, SessionPtr Session, bool Reusable) {
+		std::lock_guard G(Mutex_);
+		auto &EP = EndPoints_[Key];
+		auto Secure = dynamic_cast<Poco::Net::HTTPSClientSession *>(Session.get());
+		if (Secure != nullptr && Reusable) {
+			auto TLSSession = Secure->sslSession();
+			if (!TLSSession.isNull())
+				EP.TLSSession = TLSSession;
+		}
+		if (Reusable && EP.Idle.size() < MaxIdle_) {
+			EP.Idle.push_back(IdleSession{std::move(Session), std::chrono::steady_clock::now()});
+			return;
+		}
+		Total_--;
+	}
+
+	void OpenAPIClientPool::Flush() {
+		std::lock_guard G(Mutex_);
+		for (auto &[_, EP] : EndPoints_) {
+			Total_ -= EP.Idle.size();
+			EP.Idle.clear();
+		}
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,94 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Poco/Net/HTTPClientSession.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/Session.h"
+#include "Poco/URI.h"
+
+namespace OpenWifi {
+
+	//	Keeps HTTP/HTTPS sessions to other micro services alive between OpenAPIRequest calls.
+	//	Sessions are pooled per scheme/host/port and TLS sessions are resumed when new
+	//	connections must be opened to an endpoint we already talked to.
+	class OpenAPIClientPool {
+	  public:
+		using SessionPtr = std::unique_ptr<Poco::Net::HTTPClientSession>;
+
+		class Lease {
+		  public:
+			Lease(OpenAPIClientPool &Pool, std::string Key, SessionPtr Session, bool Pooled)
+				: Pool_(&Pool), Key_(std::move(Key)), Session_(std::move(Session)),
+				  Pooled_(Pooled) {}
+			Lease(Lease &&L) noexcept
+				: Pool_(L.Pool_), Key_(std::move(L.Key_)), Session_(std::move(L.Session_)),
+				  Pooled_(L.Pooled_), Reusable_(L.Reusable_) {
+				L.Pool_ = nullptr;
+			}
+			Lease(const Lease &) = delete;
+			Lease &operator=(const Lease &) = delete;
+			Lease &operator=(Lease &&) = delete;
+
+			~Lease() {
+				if (Pool_ != nullptr && Pooled_)
+					Pool_->Release(Key_, std::move(Session_), Reusable_);
+			}
+
+			inline Poco::Net::HTTPClientSession *operator->() { return Session_.get(); }
+			inline Poco::Net::HTTPClientSession &operator*() { return *Session_; }
+
+			//	Must be called once the response has been read: the rest of the body is drained
+			//	so the connection can carry the next request.
+			void Done(const Poco::Net::HTTPResponse &Response, std::istream &is);
+
+		  private:
+			OpenAPIClientPool *Pool_;
+			std::string Key_;
+			SessionPtr Session_;
+			bool Pooled_ = false;
+			bool Reusable_ = false;
+		};
+
+		static OpenAPIClientPool &instance() {
+			static auto instance_ = new OpenAPIClientPool;
+			return *instance_;
+		}
+
+		Lease Acquire(const Poco::URI &URI, std::uint64_t msTimeout);
+		void Flush();
+
+	  private:
+		struct IdleSession {
+			SessionPtr Session;
+			std::chrono::steady_clock::time_point Since;
+		};
+
+		struct EndPoint {
+			std::vector<IdleSession> Idle;
+			Poco::Net::Session::Ptr TLSSession;
+		};
+
+		std::mutex Mutex_;
+		std::map<std::string, EndPoint> EndPoints_;
+		std::uint64_t Total_ = 0;
+		std::uint64_t MaxIdle_ = 8;
+		std::uint64_t MaxTotal_ = 128;
+		std::uint64_t IdleTimeout_ = 30;
+
+		OpenAPIClientPool();
+		SessionPtr NewSession(const Poco::URI &URI, Poco::Net::Session::Ptr TLSSession);
+		bool Healthy(IdleSession &S) const;
+		void Release(const std::string &Key, SessionPtr Session, bool Reusable);
+	};
+
+} // namespace OpenWifi
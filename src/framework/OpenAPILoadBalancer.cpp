@@ -0,0 +1,184 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include "OpenAPILoadBalancer.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Poco/Logger.h"
+
+#include "fmt/format.h"
+#include "framework/MicroServiceFuncs.h"
+
+namespace OpenWifi {
+
+	static constexpr double EWMA_Alpha = 0.3;
+
+	OpenAPILoadBalancer::OpenAPILoadBalancer() {
+		FailureRate_ = MicroServiceConfigGetInt("openwifi.openapi.breaker.failurerate", 50);
+		MinCalls_ = MicroServiceConfigGetInt("openwifi.openapi.breaker.mincalls", 10);
+		Window_ =
+			std::chrono::seconds(MicroServiceConfigGetInt("openwifi.openapi.breaker.window", 30));
+		OpenTime_ =
+			std::chrono::seconds(MicroServiceConfigGetInt("openwifi.openapi.breaker.opentime", 15));
+		Hedging_ = MicroServiceConfigGetBool("openwifi.openapi.hedge.enable", false);
+		HedgeDelay_ = std::chrono::milliseconds(
+			MicroServiceConfigGetInt("openwifi.openapi.hedge.delay", 0));
+	}
+
+	const OpenAPILoadBalancer::CallMetrics &
+	OpenAPILoadBalancer::Metrics(const std::string &Service, const std::string &Method) {
+		auto Key = std::make_pair(Service, Method);
+		{
+			std::shared_lock L(MetricsMutex_);
+			auto hint = Metrics_.find(Key);
+			if (hint != Metrics_.end())
+				return hint->second;
+		}
+
+		static const std::array<const char *, (std::size_t)Outcome::count> Outcomes{
+			"exception", "5xx", "4xx", "2xx"};
+		CallMetrics M;
+		M.Duration = &MetricsRegistry()->Histogram("owprov_sdk_call_duration_seconds",
+												   "Time spent in calls to other micro services.",
+												   {{"service", Service}, {"method", Method}});
+		for (std::size_t i = 0; i < Outcomes.size(); ++i)
+			M.Calls[i] = &MetricsRegistry()->Counter(
+				"owprov_sdk_calls_total", "Calls to other micro services.",
+				{{"service", Service}, {"method", Method}, {"outcome", Outcomes[i]}});
+		std::unique_lock L(MetricsMutex_);
+		return Metrics_.emplace(std::move(Key), M).first->second;
+	}
+
+	Types::MicroServiceMetaVec
+	OpenAPILoadBalancer::Select(const Types::MicroServiceMetaVec &Services) {
+		static thread_local std::mt19937 Random{std::random_device{}()};
+		Types::MicroServiceMetaVec Shuffled(Services);
+		std::shuffle(Shuffled.begin(), Shuffled.end(), Random);
+
+		auto Now = std::chrono::steady_clock::now();
+		std::vector<std::pair<double, Types::MicroServiceMeta>> Ranked;
+		//	Of the instances left out, the one whose open period ends first.
+		const Types::MicroServiceMeta *LeastBad = nullptr;
+		auto LeastBadUntil = std::chrono::steady_clock::time_point::max();
+		auto LeaveOut = [&](const Instance &I, const Types::MicroServiceMeta &Svc) {
+			if (I.OpenUntil < LeastBadUntil) {
+				LeastBadUntil = I.OpenUntil;
+				LeastBad = &Svc;
+			}
+		};
+		std::lock_guard G(Mutex_);
+		for (const auto &Svc : Shuffled) {
+			auto &I = Instances_[Svc.PrivateEndPoint];
+			if (I.State == BreakerState::open) {
+				if (Now < I.OpenUntil) {
+					LeaveOut(I, Svc);
+					continue;
+				}
+				I.State = BreakerState::half_open;
+				I.ProbeInFlight = false;
+			}
+			if (I.State == BreakerState::half_open) {
+				//	Only the caller that claims the probe gets the instance. A claim that never
+				//	reports (the caller used another instance) lapses after the open time.
+				if (Now >= I.OpenUntil)
+					I.ProbeInFlight = false;
+				if (I.ProbeInFlight) {
+					LeaveOut(I, Svc);
+					continue;
+				}
+				I.ProbeInFlight = true;
+				I.OpenUntil = Now + OpenTime_;
+			}
+			Ranked.emplace_back((I.LatencyEWMA + 1.0) * (double)(I.Outstanding + 1), Svc);
+		}
+
+		if (!Services.empty()) {
+			const auto &Type = Services.front().Type;
+			if (Ranked.empty()) {
+				if (AllOpen_.insert(Type).second)
+					poco_warning(Poco::Logger::get("REST-CALLER-LB"),
+								 fmt::format("{}: every instance has an open circuit, calls go "
+											 "to the one closest to recovery.",
+											 Type));
+				if (LeastBad)
+					Ranked.emplace_back(0.0, *LeastBad);
+			} else if (AllOpen_.erase(Type)) {
+				poco_information(Poco::Logger::get("REST-CALLER-LB"),
+								 fmt::format("{}: an instance is available again.", Type));
+			}
+		}
+		std::stable_sort(Ranked.begin(), Ranked.end(),
+						 [](const auto &A, const auto &B) { return A.first < B.first; });
+
+		Types::MicroServiceMetaVec Res;
+		for (auto &[_, Svc] : Ranked)
+			Res.emplace_back(std::move(Svc));
+		return Res;
+	}
+
+	std::chrono::milliseconds OpenAPILoadBalancer::HedgeDelay(const std::string &EndPoint) {
+		if (HedgeDelay_.count() > 0)
+			return HedgeDelay_;
+		std::lock_guard G(Mutex_);
+		auto &I = Instances_[EndPoint];
+		return std::chrono::milliseconds(std::max<std::uint64_t>(50, 2 * (std::uint64_t)I.LatencyEWMA));
+	}
+
+	void OpenAPILoadBalancer::Begin(const std::string &EndPoint) {
+		std::lock_guard G(Mutex_);
+		auto &I = Instances_[EndPoint];
+		I.Outstanding++;
+	}
+
+	void OpenAPILoadBalancer::Trip(Instance &I, std::chrono::steady_clock::time_point Now) {
+		I.State = BreakerState::open;
+		I.OpenUntil = Now + OpenTime_;
+		I.ProbeInFlight = false;
+		I.Successes = I.Failures = 0;
+		I.WindowStart = Now;
+	}
+
+	void OpenAPILoadBalancer::End(const std::string &EndPoint, bool Success,
+								  std::chrono::steady_clock::duration Elapsed) {
+		auto Now = std::chrono::steady_clock::now();
+		std::lock_guard G(Mutex_);
+		auto &I = Instances_[EndPoint];
+		if (I.Outstanding)
+			I.Outstanding--;
+
+		auto ms = std::chrono::duration<double, std::milli>(Elapsed).count();
+		I.LatencyEWMA = I.LatencyEWMA == 0.0 ? ms : (EWMA_Alpha * ms) + ((1.0 - EWMA_Alpha) * I.LatencyEWMA);
+
+		//	A probe, or a call made while every instance of the service had an open circuit.
+		if (I.State != BreakerState::closed) {
+			if (Success) {
+				I.State = BreakerState::closed;
+				I.ProbeInFlight = false;
+				I.Successes = I.Failures = 0;
+				I.WindowStart = Now;
+				poco_information(Poco::Logger::get("REST-CALLER-LB"),
+								 fmt::format("{}: circuit closed.", EndPoint));
+			} else if (I.State == BreakerState::half_open) {
+				Trip(I, Now);
+			}
+			return;
+		}
+
+		if (Now - I.WindowStart > Window_) {
+			I.Successes = I.Failures = 0;
+			I.WindowStart = Now;
+		}
+		Success ? I.Successes++ : I.Failures++;
+		auto Total = I.Successes + I.Failures;
+		if (Total >= MinCalls_ && (I.Failures * 100) >= (FailureRate_ * Total)) {
+			poco_warning(Poco::Logger::get("REST-CALLER-LB"),
+						 fmt::format("{}: circuit opened after {} failures in {} calls.", EndPoint,
+									 I.Failures, Total));
+			Trip(I, Now);
+		}
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,130 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+
+#include "Poco/Net/HTTPResponse.h"
+
+#include "framework/MetricsRegistry.h"
+#include "framework/OpenWifiTypes.h"
+
+namespace OpenWifi {
+
+	//	Spreads OpenAPIRequest calls across every registered instance of a micro service.
+	//	Instances are ranked by latency (EWMA) weighted by outstanding calls, and each one has a
+	//	circuit breaker that opens on a high failure rate and probes with a single call once
+	//	the open period expires.
+	class OpenAPILoadBalancer {
+	  public:
+		enum class Outcome { exception, server_error, client_error, success, count };
+
+		//	The SDK metrics of one service and method, looked up in the registry once.
+		struct CallMetrics {
+			MetricsHistogram *Duration = nullptr;
+			std::array<MetricsCounter *, (std::size_t)Outcome::count> Calls{};
+		};
+
+		class Call {
+		  public:
+			//	Service and Method label the call in the SDK metrics.
+			Call(OpenAPILoadBalancer &LB, const std::string &EndPoint,
+				 const std::string &Service = "", const std::string &Method = "")
+				: LB_(LB), EndPoint_(EndPoint), Metrics_(LB.Metrics(Service, Method)),
+				  Start_(std::chrono::steady_clock::now()) {
+				LB_.Begin(EndPoint_);
+			}
+			~Call() {
+				if (!Reported_) {
+					auto Elapsed = std::chrono::steady_clock::now() - Start_;
+					LB_.End(EndPoint_, false, Elapsed);
+					Record(Outcome::exception, Elapsed);
+				}
+			}
+			Call(const Call &) = delete;
+			Call &operator=(const Call &) = delete;
+
+			inline void Result(Poco::Net::HTTPResponse::HTTPStatus Status) {
+				Reported_ = true;
+				auto Elapsed = std::chrono::steady_clock::now() - Start_;
+				LB_.End(EndPoint_, !ServerError(Status), Elapsed);
+				Record((int)Status >= 500	? Outcome::server_error
+					   : (int)Status >= 400 ? Outcome::client_error
+											: Outcome::success,
+					   Elapsed);
+			}
+
+		  private:
+			OpenAPILoadBalancer &LB_;
+			std::string EndPoint_;
+			const CallMetrics &Metrics_;
+			std::chrono::steady_clock::time_point Start_;
+			bool Reported_ = false;
+
+			inline void Record(Outcome O, std::chrono::steady_clock::duration Elapsed) {
+				Metrics_.Duration->Observe(Elapsed);
+				Metrics_.Calls[(std::size_t)O]->Inc();
+			}
+		};
+
+		static OpenAPILoadBalancer &instance() {
+			static auto instance_ = new OpenAPILoadBalancer;
+			return *instance_;
+		}
+
+		//	Returns the usable instances, best candidate first. Instances with an open breaker
+		//	are left out, unless every one is: then the one closest to recovery is returned.
+		Types::MicroServiceMetaVec Select(const Types::MicroServiceMetaVec &Services);
+
+		[[nodiscard]] inline bool Hedging() const { return Hedging_; }
+		[[nodiscard]] std::chrono::milliseconds HedgeDelay(const std::string &EndPoint);
+
+		static inline bool ServerError(Poco::Net::HTTPResponse::HTTPStatus Status) {
+			return Status == Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR ||
+				   Status == Poco::Net::HTTPResponse::HTTP_BAD_GATEWAY ||
+				   Status == Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE ||
+				   Status == Poco::Net::HTTPResponse::HTTP_GATEWAY_TIMEOUT;
+		}
+
+	  private:
+		enum class BreakerState { closed, open, half_open };
+
+		struct Instance {
+			std::uint64_t Outstanding = 0;
+			double LatencyEWMA = 0.0;
+			BreakerState State = BreakerState::closed;
+			std::uint64_t Successes = 0, Failures = 0;
+			std::chrono::steady_clock::time_point WindowStart{}, OpenUntil{};
+			bool ProbeInFlight = false;
+		};
+
+		std::mutex Mutex_;
+		std::map<std::string, Instance> Instances_;
+		std::set<std::string> AllOpen_; //	service types with no instance to call
+		std::uint64_t FailureRate_ = 50;
+		std::uint64_t MinCalls_ = 10;
+		std::chrono::seconds Window_{30};
+		std::chrono::seconds OpenTime_{15};
+		bool Hedging_ = false;
+		std::chrono::milliseconds HedgeDelay_{0};
+		std::shared_mutex MetricsMutex_;
+		std::map<std::pair<std::string, std::string>, CallMetrics> Metrics_;
+
+		OpenAPILoadBalancer();
+		const CallMetrics &Metrics(const std::string &Service, const std::string &Method);
+		void Begin(const std::string &EndPoint);
+		void End(const std::string &EndPoint, bool Success,
+				 std::chrono::steady_clock::duration Elapsed);
+		void Trip(Instance &I, std::chrono::steady_clock::time_point Now);
+	};
+
+} // namespace OpenWifi
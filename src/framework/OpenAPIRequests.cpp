@@ -4,74 +4,161 @@
 
 #include "OpenAPIRequests.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 #include "Poco/JSON/Parser.h"
 #include "Poco/Logger.h"
 #include "Poco/Net/HTTPRequest.h"
-#include "Poco/Net/HTTPSClientSession.h"
 #include "Poco/URI.h"
 
 #include "fmt/format.h"
 #include "framework/MicroServiceFuncs.h"
+#include "framework/OpenAPIAsync.h"
+#include "framework/OpenAPIClientPool.h"
+#include "framework/OpenAPILoadBalancer.h"
 
 namespace OpenWifi {
 
 	Poco::Net::HTTPServerResponse::HTTPStatus
-	OpenAPIRequestGet::Do(Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) {
-		try {
-
-			auto Services = MicroServiceGetServices(Type_);
-			for (auto const &Svc : Services) {
-				Poco::URI URI(Svc.PrivateEndPoint);
-
-				auto Secure = (URI.getScheme() == "https");
+	OpenAPIRequestGet::DoOne(const Types::MicroServiceMeta &Svc,
+							 Poco::JSON::Object::Ptr &ResponseObject,
+							 const std::string &BearerToken) const {
+		Poco::URI URI(Svc.PrivateEndPoint);
+
+		URI.setPath(EndPoint_);
+		for (const auto &qp : QueryData_)
+			URI.addQueryParameter(qp.first, qp.second);
+
+		std::string Path(URI.getPathAndQuery());
+		Poco::Net::HTTPRequest Request(Poco::Net::HTTPRequest::HTTP_GET, Path,
+									   Poco::Net::HTTPMessage::HTTP_1_1);
+
+		poco_debug(Poco::Logger::get("REST-CALLER-GET"),
+				   fmt::format(" {}", LoggingStr_.empty() ? URI.toString() : LoggingStr_));
+
+		if (BearerToken.empty()) {
+			Request.add("X-API-KEY", Svc.AccessKey);
+			Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
+		} else {
+			// Authorization: Bearer ${token}
+			Request.add("Authorization", "Bearer " + BearerToken);
+		}
 
-				URI.setPath(EndPoint_);
-				for (const auto &qp : QueryData_)
-					URI.addQueryParameter(qp.first, qp.second);
+		OpenAPILoadBalancer::Call Call(OpenAPILoadBalancer::instance(), Svc.PrivateEndPoint, Type_,
+									   Request.getMethod());
+		auto Session = OpenAPIClientPool::instance().Acquire(URI, msTimeout_);
+		Session->sendRequest(Request);
 
-				std::string Path(URI.getPathAndQuery());
-				Poco::Net::HTTPRequest Request(Poco::Net::HTTPRequest::HTTP_GET, Path,
-											   Poco::Net::HTTPMessage::HTTP_1_1);
+		Poco::Net::HTTPResponse Response;
+		std::istream &is = Session->receiveResponse(Response);
+		if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
+			Poco::JSON::Parser P;
+			ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
+		}
+		Session.Done(Response, is);
+		Call.Result(Response.getStatus());
+		return Response.getStatus();
+	}
 
-				poco_debug(Poco::Logger::get("REST-CALLER-GET"),
-						   fmt::format(" {}", LoggingStr_.empty() ? URI.toString() : LoggingStr_));
+	//	GET is idempotent: on a transport failure, try the next instance.
+	Poco::Net::HTTPServerResponse::HTTPStatus
+	OpenAPIRequestGet::DoInOrder(const Types::MicroServiceMetaVec &Services,
+								 Poco::JSON::Object::Ptr &ResponseObject,
+								 const std::string &BearerToken) const {
+		for (auto const &Svc : Services) {
+			try {
+				return DoOne(Svc, ResponseObject, BearerToken);
+			} catch (const Poco::Exception &E) {
+				Poco::Logger::get("REST-CALLER-GET").log(E);
+			}
+		}
+		return Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
+	}
 
-				if (BearerToken.empty()) {
-					Request.add("X-API-KEY", Svc.AccessKey);
-					Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
-				} else {
-					// Authorization: Bearer ${token}
-					Request.add("Authorization", "Bearer " + BearerToken);
+	//	Sends the request to the best instance and, if it has not answered within the hedge
+	//	delay (or failed), to the best of the others at that time. The first good answer wins. Both calls run on the
+	//	hedge threads; when none is free, the calls are made in order on this thread, and a
+	//	second call that cannot start is simply not sent.
+	Poco::Net::HTTPServerResponse::HTTPStatus
+	OpenAPIRequestGet::DoHedged(const Types::MicroServiceMetaVec &Services,
+								Poco::JSON::Object::Ptr &ResponseObject,
+								const std::string &BearerToken) const {
+		struct HedgeState {
+			std::mutex Mutex;
+			std::condition_variable Cond;
+			std::uint64_t Pending = 0;
+			bool AllLaunched = false, Done = false;
+			Poco::Net::HTTPServerResponse::HTTPStatus Status =
+				Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
+			Poco::JSON::Object::Ptr Response;
+		};
+		auto State = std::make_shared<HedgeState>();
+
+		//	Called with State->Mutex held.
+		auto Launch = [&](const Types::MicroServiceMeta &Svc) {
+			bool Started = OpenAPIAsyncEngine::Hedges()->TryRun([State, Req = *this, Svc,
+																BearerToken]() {
+				Poco::JSON::Object::Ptr Response;
+				auto Status = Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
+				try {
+					Status = Req.DoOne(Svc, Response, BearerToken);
+				} catch (const Poco::Exception &E) {
+					Poco::Logger::get("REST-CALLER-GET").log(E);
 				}
-
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					Session.sendRequest(Request);
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					Session.sendRequest(Request);
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
+				std::lock_guard G(State->Mutex);
+				State->Pending--;
+				if (!State->Done && (!OpenAPILoadBalancer::ServerError(Status) ||
+									 (State->AllLaunched && State->Pending == 0))) {
+					State->Done = true;
+					State->Status = Status;
+					State->Response = Response;
 				}
-			}
+				State->Cond.notify_all();
+			});
+			if (Started)
+				State->Pending++;
+			return Started;
+		};
+
+		std::unique_lock L(State->Mutex);
+		if (!Launch(Services[0])) {
+			L.unlock();
+			return DoInOrder(Services, ResponseObject, BearerToken);
+		}
+		State->Cond.wait_for(L, OpenAPILoadBalancer::instance().HedgeDelay(Services[0].PrivateEndPoint),
+							 [&] { return State->Done || State->Pending == 0; });
+		//	The other instances, ranked as they are now that the first call is outstanding.
+		Types::MicroServiceMetaVec Others;
+		if (!State->Done) {
+			Others = OpenAPILoadBalancer::instance().Select(
+				Types::MicroServiceMetaVec(Services.begin() + 1, Services.end()));
+			if (!Others.empty())
+				Launch(Others.front());
+		}
+		State->AllLaunched = true;
+		//	The last call to finish reports even a failure, once every call is launched.
+		if (!State->Done && State->Pending == 0) {
+			L.unlock();
+			return DoInOrder(Others, ResponseObject, BearerToken);
+		}
+		State->Cond.wait_for(L, std::chrono::milliseconds(msTimeout_),
+							 [&] { return State->Done; });
+		if (State->Done) {
+			ResponseObject = State->Response;
+			return State->Status;
+		}
+		return Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
+	}
+
+	Poco::Net::HTTPServerResponse::HTTPStatus
+	OpenAPIRequestGet::Do(Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) {
+		try {
+			auto Services = OpenAPILoadBalancer::instance().Select(MicroServiceGetServices(Type_));
+			if (Services.size() > 1 && OpenAPILoadBalancer::instance().Hedging())
+				return DoHedged(Services, ResponseObject, BearerToken);
+			return DoInOrder(Services, ResponseObject, BearerToken);
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-GET").log(E);
 		}
@@ -81,12 +168,10 @@ namespace OpenWifi {
 	Poco::Net::HTTPServerResponse::HTTPStatus
 	OpenAPIRequestPut::Do(Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) {
 		try {
-			auto Services = MicroServiceGetServices(Type_);
+			auto Services = OpenAPILoadBalancer::instance().Select(MicroServiceGetServices(Type_));
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -112,41 +197,19 @@ namespace OpenWifi {
 					Request.add("Authorization", "Bearer " + BearerToken);
 				}
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				}
+				OpenAPILoadBalancer::Call Call(OpenAPILoadBalancer::instance(),
+											   Svc.PrivateEndPoint, Type_, Request.getMethod());
+				auto Session = OpenAPIClientPool::instance().Acquire(URI, msTimeout_);
+				std::ostream &os = Session->sendRequest(Request);
+				os << obody.str();
+
+				Poco::Net::HTTPResponse Response;
+				std::istream &is = Session->receiveResponse(Response);
+				Poco::JSON::Parser P;
+				ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
+				Session.Done(Response, is);
+				Call.Result(Response.getStatus());
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-PUT").log(E);
@@ -158,13 +221,11 @@ namespace OpenWifi {
 	OpenAPIRequestPost::Do(Poco::JSON::Object::Ptr &ResponseObject,
 						   const std::string &BearerToken) {
 		try {
-			auto Services = MicroServiceGetServices(Type_);
+			auto Services = OpenAPILoadBalancer::instance().Select(MicroServiceGetServices(Type_));
 
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -190,39 +251,19 @@ namespace OpenWifi {
 					Request.add("Authorization", "Bearer " + BearerToken);
 				}
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				}
+				OpenAPILoadBalancer::Call Call(OpenAPILoadBalancer::instance(),
+											   Svc.PrivateEndPoint, Type_, Request.getMethod());
+				auto Session = OpenAPIClientPool::instance().Acquire(URI, msTimeout_);
+				std::ostream &os = Session->sendRequest(Request);
+				os << obody.str();
+
+				Poco::Net::HTTPResponse Response;
+				std::istream &is = Session->receiveResponse(Response);
+				Poco::JSON::Parser P;
+				ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
+				Session.Done(Response, is);
+				Call.Result(Response.getStatus());
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-POST").log(E);
@@ -232,14 +273,13 @@ namespace OpenWifi {
 
 	Poco::Net::HTTPServerResponse::HTTPStatus
 	OpenAPIRequestDelete::Do(const std::string &BearerToken) {
-		try {
-			auto Services = MicroServiceGetServices(Type_);
+		auto Services = OpenAPILoadBalancer::instance().Select(MicroServiceGetServices(Type_));
 
-			for (auto const &Svc : Services) {
+		//	DELETE is idempotent: on a transport failure, try the next instance.
+		for (auto const &Svc : Services) {
+			try {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -259,26 +299,20 @@ namespace OpenWifi {
 					Request.add("Authorization", "Bearer " + BearerToken);
 				}
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					Session.sendRequest(Request);
-					Poco::Net::HTTPResponse Response;
-					Session.receiveResponse(Response);
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					Session.sendRequest(Request);
-					Poco::Net::HTTPResponse Response;
-					Session.receiveResponse(Response);
-					return Response.getStatus();
-				}
+				OpenAPILoadBalancer::Call Call(OpenAPILoadBalancer::instance(),
+											   Svc.PrivateEndPoint, Type_, Request.getMethod());
+				auto Session = OpenAPIClientPool::instance().Acquire(URI, msTimeout_);
+				Session->sendRequest(Request);
+				Poco::Net::HTTPResponse Response;
+				std::istream &is = Session->receiveResponse(Response);
+				Session.Done(Response, is);
+				Call.Result(Response.getStatus());
+				return Response.getStatus();
+			} catch (const Poco::Exception &E) {
+				Poco::Logger::get("REST-CALLER-DELETE").log(E);
 			}
-		} catch (const Poco::Exception &E) {
-			Poco::Logger::get("REST-CALLER-DELETE").log(E);
 		}
 		return Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
 	}
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -29,6 +29,16 @@ namespace OpenWifi {
 		Types::StringPairVec QueryData_;
 		uint64_t msTimeout_;
 		std::string LoggingStr_;
+
+		Poco::Net::HTTPServerResponse::HTTPStatus DoOne(const Types::MicroServiceMeta &Svc,
+														Poco::JSON::Object::Ptr &ResponseObject,
+														const std::string &BearerToken) const;
+		Poco::Net::HTTPServerResponse::HTTPStatus
+		DoInOrder(const Types::MicroServiceMetaVec &Services,
+				  Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) const;
+		Poco::Net::HTTPServerResponse::HTTPStatus
+		DoHedged(const Types::MicroServiceMetaVec &Services,
+				 Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) const;
 	};
 
 	class OpenAPIRequestPut {
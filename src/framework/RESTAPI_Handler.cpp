@@ -6,6 +6,7 @@
 #include "RESTAPI/RESTAPI_db_helpers.h"
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "StorageService.h"
+#include "framework/AuthorizationTrace.h"
 #include "framework/MicroServiceFuncs.h"
 
 namespace OpenWifi {
@@ -17,20 +18,18 @@ namespace OpenWifi {
 			return true;
 		}
 
+		AuthorizationTrace::Session Trace(*AuthorizationTrace(), UserInfo_.userinfo.id,
+										  UserInfo_.userinfo.userRole, Method, Path);
+
 		// 2. Map path to resource
-		std::string Resource = GetResourceName(Path);
+		std::string Resource =
+			RouteResource_ != nullptr ? *RouteResource_ : GetResourceName(Path);
+		Trace.Resource(Resource);
 		if (Resource.empty()) {
 			Reason = "Unknown or prohibited resource path.";
-			Logger_.information(fmt::format("AUTH_DEBUG: Denied - Unknown resource path '{}'", Path));
-			return false;
+			return Trace.Result(false, Reason);
 		}
 
-		Logger_.information(fmt::format(
-			"AUTH_DEBUG: User='{}' UserRole='{}' Path='{}' Method='{}' Resource='{}'",
-			UserInfo_.userinfo.id,
-			SecurityObjects::UserTypeToString(UserInfo_.userinfo.userRole), Path, Method,
-			Resource));
-
 		if (Resource == "user" &&
 			(Method == Poco::Net::HTTPRequest::HTTP_POST ||
 			 Method == Poco::Net::HTTPRequest::HTTP_PUT) &&
@@ -39,58 +38,55 @@ namespace OpenWifi {
 			if (Poco::icompare(RequestedUserRole, "root") == 0 &&
 				UserInfo_.userinfo.userRole != SecurityObjects::ROOT) {
 				Reason = "Only root may assign the root user role.";
-				Logger_.information(fmt::format("AUTH_DEBUG: Denied - Non-root trying to assign root role"));
-				return false;
+				return Trace.Result(false, Reason);
 			}
 		}
 
 		if ((Resource == "managementPolicy" || Resource == "systemConfiguration" ||
 			 Resource == "radiusEndpoint" || Resource == "openroaming" ||
 			 Resource == "iptocountry") && Method == Poco::Net::HTTPRequest::HTTP_GET) {
-			return true;
+			return Trace.Result(true, "Read access to shared resource.");
 		}
 
 		std::string UserId = UserInfo_.userinfo.id;
 		std::vector<ProvObjects::ManagementRole> Roles;
 		FindAllUserRoles(UserId, Roles);
 
-		Logger_.information(fmt::format("AUTH_DEBUG: User '{}' has {} management roles", UserId, Roles.size()));
+		Trace.Step("{} management roles", Roles.size());
 
 		auto CheckRolePolicy = [&](const ProvObjects::ManagementRole &role) -> bool {
 			ProvObjects::ManagementPolicy Policy;
 			if (!AuthCache::GetInstance()->GetPolicy(role.managementPolicy, Policy)) {
 				if (!StorageService()->PolicyDB().GetRecord("id", role.managementPolicy, Policy)) {
-					Logger_.information(fmt::format("AUTH_DEBUG: Policy ID '{}' not found in DB", role.managementPolicy));
+					Trace.Step("Policy '{}' of role '{}' not found", role.managementPolicy,
+							   role.info.id);
 					return false;
 				}
 				AuthCache::GetInstance()->SetPolicy(role.managementPolicy, Policy);
 			}
 			bool res = PolicyAllows(Policy, Resource, Method);
-			Logger_.information(fmt::format("AUTH_DEBUG: PolicyAllows(policy='{}', resource='{}', method='{}') -> {}", Policy.info.id, Resource, Method, res));
+			Trace.Step("Role '{}' policy '{}' -> {}", role.info.id, Policy.info.id, res);
 			return res;
 		};
 
 		// 3. Resolve target Entity and Venue
 		std::string TargetEntity, TargetVenue;
 		if (!ResolveTargetContext(Path, Method, TargetEntity, TargetVenue)) {
-			Logger_.information(fmt::format("AUTH_DEBUG: ResolveTargetContext returned false for Path='{}'", Path));
+			Trace.Step("No target context");
 			if (HasScopeConstraint(Resource, Method)) {
 				Reason = "Scope resolution failed for constrained operation; access denied.";
-				Logger_.information(fmt::format("AUTH_DEBUG: Denied - HasScopeConstraint is true but ResolveTargetContext failed"));
-				return false;
+				return Trace.Result(false, Reason);
 			}
 			for (const auto &role : Roles) {
 				if (CheckRolePolicy(role)) {
-					Logger_.information(fmt::format("AUTH_DEBUG: Granted global operation via role '{}'", role.info.id));
-					return true;
+					return Trace.Result(true, "Global operation granted by role {}", role.info.id);
 				}
 			}
 			Reason = "No authorized role found for this target resource and operation.";
-			Logger_.information(fmt::format("AUTH_DEBUG: Denied - No role permits global operation for resource '{}'", Resource));
-			return false;
+			return Trace.Result(false, Reason);
 		}
 
-		Logger_.information(fmt::format("AUTH_DEBUG: Resolved TargetEntity='{}' TargetVenue='{}'", TargetEntity, TargetVenue));
+		Trace.Step("Target entity='{}' venue='{}'", TargetEntity, TargetVenue);
 
 		if (!TargetVenue.empty()) {
 			bool foundSpecificVenueRole = false;
@@ -98,14 +94,13 @@ namespace OpenWifi {
 				if (role.venue == TargetVenue) {
 					foundSpecificVenueRole = true;
 					if (CheckRolePolicy(role)) {
-						return true;
+						return Trace.Result(true, "Venue role {}", role.info.id);
 					}
 				}
 			}
 			if (foundSpecificVenueRole) {
 				Reason = "Specific venue role policy denied access.";
-				Logger_.information(fmt::format("AUTH_DEBUG: Denied by specific venue role policy"));
-				return false;
+				return Trace.Result(false, Reason);
 			}
 
 			for (const auto &role : Roles) {
@@ -119,26 +114,24 @@ namespace OpenWifi {
 					}
 					if (AllowedVenues.find(TargetVenue) != AllowedVenues.end()) {
 						if (CheckRolePolicy(role)) {
-							return true;
+							return Trace.Result(true, "Entity role {}", role.info.id);
 						}
 					}
 				}
 			}
 		} else {
 			for (const auto &role : Roles) {
-				Logger_.information(fmt::format("AUTH_DEBUG: Comparing role.entity='{}' with TargetEntity='{}'", role.entity, TargetEntity));
+				Trace.Step("Role '{}' entity='{}'", role.info.id, role.entity);
 				if (role.entity == TargetEntity && (role.venue.empty() || role.venue == "")) {
 					if (CheckRolePolicy(role)) {
-						Logger_.information(fmt::format("AUTH_DEBUG: Granted access via matching role.entity='{}' with policy='{}'", role.entity, role.managementPolicy));
-						return true;
+						return Trace.Result(true, "Entity role {}", role.info.id);
 					}
 				}
 			}
 		}
 
 		Reason = "No authorized role matches the required scope and permission.";
-		Logger_.information(fmt::format("AUTH_DEBUG: Denied for Path='{}'. Reason='{}'", Path, Reason));
-		return false;
+		return Trace.Result(false, Reason);
 	}
 
 	bool RESTAPIHandler::ResolveTargetContext(const std::string &Path, const std::string &Method,
@@ -174,9 +167,9 @@ namespace OpenWifi {
 			!Id.empty() && Id != "0" &&
 			!(Method == Poco::Net::HTTPRequest::HTTP_POST && Poco::icompare(Id, "new") == 0);
 
-		Logger_.information(fmt::format("RESOLVE_DEBUG: Path='{}' Method='{}' Id='{}' HasBoundObjectId={}", Path, Method, Id, HasBoundObjectId));
+		poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Path='{}' Method='{}' Id='{}' HasBoundObjectId={}", Path, Method, Id, HasBoundObjectId));
 		for (const auto &[bKey, bVal] : Bindings_) {
-			Logger_.information(fmt::format("RESOLVE_DEBUG: Binding key='{}' val='{}'", bKey, bVal));
+			poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Binding key='{}' val='{}'", bKey, bVal));
 		}
 
 		if (HasBoundObjectId) {
@@ -246,11 +239,11 @@ namespace OpenWifi {
 				ProvObjects::InventoryTag T;
 				bool foundTag = StorageService()->InventoryDB().GetRecord("id", Id, T) ||
 								StorageService()->InventoryDB().GetRecord(RESTAPI::Protocol::SERIALNUMBER, Id, T);
-				Logger_.information(fmt::format("RESOLVE_DEBUG: configurationOverrides lookup Id='{}' foundTag={}", Id, foundTag));
+				poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: configurationOverrides lookup Id='{}' foundTag={}", Id, foundTag));
 				if (foundTag) {
 					TargetEntity = T.entity;
 					TargetVenue = T.venue;
-					Logger_.information(fmt::format("RESOLVE_DEBUG: Tag T.entity='{}' T.venue='{}'", T.entity, T.venue));
+					poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Tag T.entity='{}' T.venue='{}'", T.entity, T.venue));
 					if (TargetEntity.empty() && !TargetVenue.empty()) {
 						ProvObjects::Venue V;
 						if (StorageService()->VenueDB().GetRecord("id", TargetVenue, V)) {
@@ -471,37 +464,37 @@ namespace OpenWifi {
 		}
 
 		if (!CandidateOperator.empty()) {
-			Logger_.information(fmt::format("RESOLVE_DEBUG: Resolving CandidateOperator='{}'", CandidateOperator));
+			poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Resolving CandidateOperator='{}'", CandidateOperator));
 			ProvObjects::Entity E;
 			if (StorageService()->EntityDB().GetRecord("operatorId", CandidateOperator, E)) {
 				TargetEntity = E.info.id;
-				Logger_.information(fmt::format("RESOLVE_DEBUG: Found Entity by operatorId, TargetEntity='{}'", TargetEntity));
+				poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Found Entity by operatorId, TargetEntity='{}'", TargetEntity));
 				return true;
 			}
 			if (StorageService()->EntityDB().GetRecord("id", CandidateOperator, E)) {
 				TargetEntity = E.info.id;
-				Logger_.information(fmt::format("RESOLVE_DEBUG: Found Entity by id, TargetEntity='{}'", TargetEntity));
+				poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Found Entity by id, TargetEntity='{}'", TargetEntity));
 				return true;
 			}
 			ProvObjects::Operator O;
 			if (StorageService()->OperatorDB().GetRecord("id", CandidateOperator, O) ||
 				StorageService()->OperatorDB().GetRecord("registrationId", CandidateOperator, O)) {
-				Logger_.information(fmt::format("RESOLVE_DEBUG: Found Operator id='{}' registrationId='{}' entityId='{}'", O.info.id, O.registrationId, O.entityId));
+				poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Found Operator id='{}' registrationId='{}' entityId='{}'", O.info.id, O.registrationId, O.entityId));
 				if (!O.entityId.empty() && StorageService()->EntityDB().Exists("id", O.entityId)) {
 					TargetEntity = O.entityId;
-					Logger_.information(fmt::format("RESOLVE_DEBUG: Resolved TargetEntity='{}' from O.entityId", TargetEntity));
+					poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Resolved TargetEntity='{}' from O.entityId", TargetEntity));
 					return true;
 				}
 				if (StorageService()->EntityDB().GetRecord("operatorId", O.info.id, E)) {
 					TargetEntity = E.info.id;
-					Logger_.information(fmt::format("RESOLVE_DEBUG: Resolved TargetEntity='{}' from EntityDB.operatorId", TargetEntity));
+					poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Resolved TargetEntity='{}' from EntityDB.operatorId", TargetEntity));
 					return true;
 				}
 				TargetEntity = O.entityId.empty() ? O.info.id : O.entityId;
-				Logger_.information(fmt::format("RESOLVE_DEBUG: Fallback TargetEntity='{}'", TargetEntity));
+				poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: Fallback TargetEntity='{}'", TargetEntity));
 				return true;
 			}
-			Logger_.information(fmt::format("RESOLVE_DEBUG: CandidateOperator='{}' not found in OperatorDB or EntityDB", CandidateOperator));
+			poco_debug(Logger_, fmt::format("RESOLVE_DEBUG: CandidateOperator='{}' not found in OperatorDB or EntityDB", CandidateOperator));
 			return false; // Operator ID provided but not found in DB.
 		}
 
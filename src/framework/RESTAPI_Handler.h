@@ -4,13 +4,20 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <set>
 #include <shared_mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/DateTimeParser.h"
 #include "Poco/DeflatingStream.h"
 #include "Poco/JSON/Object.h"
 #include "Poco/JSON/Parser.h"
@@ -19,13 +26,19 @@
 #include "Poco/Net/HTTPResponse.h"
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/OAuth20Credentials.h"
+#include "Poco/SHA2Engine.h"
+#include "Poco/String.h"
 #include "Poco/TemporaryFile.h"
 
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "framework/AuthClient.h"
+#include "framework/MetricsRegistry.h"
 #include "framework/RESTAPI_GenericServerAccounting.h"
+#include "framework/RESTAPI_JSONStreamWriter.h"
+#include "framework/orm.h"
 #include "framework/RESTAPI_RateLimiter.h"
+#include "framework/ReadRouting.h"
 #include "framework/RESTAPI_utils.h"
 #include "framework/ow_constants.h"
 #include "framework/utils.h"
@@ -38,6 +51,79 @@ using namespace std::chrono_literals;
 
 namespace OpenWifi {
 
+	//	The REST request metrics of one route, labelled with its endpoint template. Each method
+	//	and status code is looked up in the registry once, then counted through the pointer.
+	class RESTAPI_RouteMetrics {
+	  public:
+		explicit RESTAPI_RouteMetrics(std::string Route) : Route_(std::move(Route)) {}
+
+		[[nodiscard]] inline const std::string &Route() const { return Route_; }
+
+		inline void Record(const std::string &Method, int Code,
+						   std::chrono::steady_clock::duration Elapsed) {
+			auto Index = MethodIndex(Method);
+			if (Index == Methods.size()) {
+				Duration(Method).Observe(Elapsed);
+				Requests(Method, Code).Inc();
+				return;
+			}
+
+			auto &M = Methods_[Index];
+			auto H = M.Duration.load(std::memory_order_acquire);
+			if (H == nullptr) {
+				H = &Duration(Method);
+				M.Duration.store(H, std::memory_order_release);
+			}
+			H->Observe(Elapsed);
+
+			MetricsCounter *C = nullptr;
+			{
+				std::shared_lock L(M.Mutex);
+				auto hint = M.Requests.find(Code);
+				if (hint != M.Requests.end())
+					C = hint->second;
+			}
+			if (C == nullptr) {
+				C = &Requests(Method, Code);
+				std::unique_lock L(M.Mutex);
+				M.Requests.emplace(Code, C);
+			}
+			C->Inc();
+		}
+
+	  private:
+		static constexpr std::array<const char *, 7> Methods{"GET",	   "POST", "PUT", "DELETE",
+															  "OPTIONS", "HEAD", "PATCH"};
+
+		struct PerMethod {
+			std::atomic<MetricsHistogram *> Duration{nullptr};
+			std::shared_mutex Mutex;
+			std::map<int, MetricsCounter *> Requests; //	by status code
+		};
+
+		std::string Route_;
+		std::array<PerMethod, Methods.size()> Methods_;
+
+		static inline std::size_t MethodIndex(const std::string &Method) {
+			std::size_t i = 0;
+			while (i < Methods.size() && Method != Methods[i])
+				++i;
+			return i;
+		}
+
+		inline MetricsHistogram &Duration(const std::string &Method) {
+			return MetricsRegistry()->Histogram("owprov_http_request_duration_seconds",
+												"Time spent handling REST requests.",
+												{{"route", Route_}, {"method", Method}});
+		}
+
+		inline MetricsCounter &Requests(const std::string &Method, int Code) {
+			return MetricsRegistry()->Counter(
+				"owprov_http_requests_total", "REST requests handled.",
+				{{"route", Route_}, {"method", Method}, {"code", std::to_string(Code)}});
+		}
+	};
+
 	class AuthCache {
 	  public:
 		static AuthCache *GetInstance() {
@@ -74,10 +160,10 @@ namespace OpenWifi {
 	  public:
 		struct QueryBlock {
 			uint64_t StartDate = 0, EndDate = 0, Offset = 0, Limit = 0, LogType = 0;
-			std::string SerialNumber, Filter;
+			std::string SerialNumber, Filter, Cursor;
 			std::vector<std::string> Select;
 			bool Lifetime = false, LastOnly = false, Newest = false, CountOnly = false,
-				 AdditionalInfo = false;
+				 AdditionalInfo = false, UseCursor = false;
 		};
 		typedef std::map<std::string, std::string> BindingMap;
 
@@ -101,6 +187,7 @@ namespace OpenWifi {
 
 		inline void handleRequest(Poco::Net::HTTPServerRequest &RequestIn,
 								  Poco::Net::HTTPServerResponse &ResponseIn) final {
+			RequestMetrics Metrics(*this, RequestIn, ResponseIn);
 			try {
 				Request = &RequestIn;
 				Response = &ResponseIn;
@@ -115,8 +202,11 @@ namespace OpenWifi {
 					}
 				}
 
-				if (RateLimited_ && RESTAPI_RateLimiter()->IsRateLimited(
-										RequestIn, MyRates_.Interval, MyRates_.MaxCalls)) {
+				if (RateLimited_ &&
+					RESTAPI_RateLimiter()->IsRateLimited(
+						RequestIn,
+						RouteMetrics_ != nullptr ? RouteMetrics_->Route() : RequestIn.getURI(),
+						MyRates_.Interval, MyRates_.MaxCalls)) {
 					return UnAuthorized(RESTAPI::Errors::RATE_LIMIT_EXCEEDED);
 				}
 
@@ -140,6 +230,15 @@ namespace OpenWifi {
 					return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
 				}
 
+				//	With a read replica: requests that write, sessions that wrote recently and
+				//	requests sent with "X-Read-Consistency: primary" read from the primary.
+				bool Writes = Request->getMethod() != Poco::Net::HTTPRequest::HTTP_GET;
+				if (Writes)
+					ReadRouting::Wrote(SessionToken_);
+				ReadRouting::Replica Reads(
+					!Writes && !ReadRouting::RecentlyWrote(SessionToken_) &&
+					Poco::icompare(Request->get("X-Read-Consistency", ""), "primary") != 0);
+
 				if (Request->getMethod() == Poco::Net::HTTPRequest::HTTP_GET)
 					return DoGet();
 				else if (Request->getMethod() == Poco::Net::HTTPRequest::HTTP_POST)
@@ -151,6 +250,9 @@ namespace OpenWifi {
 				return BadRequest(RESTAPI::Errors::UnsupportedHTTPMethod);
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
+				//	A streamed list that failed part way has already been cut short.
+				if (Response->sent())
+					return;
 				return BadRequest(RESTAPI::Errors::InternalError);
 			}
 		}
@@ -397,6 +499,92 @@ namespace OpenWifi {
 			bool CloseConnection = false) {
 			Response->setStatus(Status);
 			SetCommonHeaders(CloseConnection);
+			if (Status == Poco::Net::HTTPResponse::HTTP_OK)
+				SetValidators();
+		}
+
+		//	Conditional GET. The ETag covers the record and the request URI, since query
+		//	parameters change the body. Returns true after sending a 304 when the client copy is
+		//	current, otherwise remembers the validators for the 200 response.
+		inline bool NotModified(const std::string &ETag, uint64_t LastModified = 0) {
+			ETag_ = ETag;
+			LastModified_ = LastModified;
+			if (Request == nullptr ||
+				Request->getMethod() != Poco::Net::HTTPRequest::HTTP_GET)
+				return false;
+
+			bool Match = false;
+			auto IfNoneMatch = Request->find("If-None-Match");
+			if (IfNoneMatch != Request->end()) {
+				for (auto Tag : Utils::Split(IfNoneMatch->second)) {
+					Poco::trimInPlace(Tag);
+					if (Tag.rfind("W/", 0) == 0)
+						Tag.erase(0, 2);
+					if (Tag == "*" || Tag == ETag) {
+						Match = true;
+						break;
+					}
+				}
+			} else if (LastModified != 0) {
+				auto IfModifiedSince = Request->find("If-Modified-Since");
+				if (IfModifiedSince != Request->end()) {
+					Poco::DateTime Since;
+					int tzd;
+					if (Poco::DateTimeParser::tryParse(Poco::DateTimeFormat::HTTP_FORMAT,
+													   IfModifiedSince->second, Since, tzd))
+						Match = LastModified <= (uint64_t)Since.timestamp().epochTime();
+				}
+			}
+
+			if (!Match)
+				return false;
+			Response->setStatus(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+			SetCommonHeaders();
+			SetValidators();
+			Response->setChunkedTransferEncoding(false);
+			Response->setContentLength(0);
+			Response->send();
+			return true;
+		}
+
+		//	The ETag hashes the record as it is sent: "modified" only has a one second
+		//	resolution, so two updates within the same second would otherwise share an ETag.
+		template <typename T> bool NotModified(const T &Record) {
+			Poco::SHA2Engine E;
+			HashRecord(E, Record);
+			E.update(Request->getURI());
+			return NotModified(MakeETag(Poco::SHA2Engine::digestToHex(E.digest())),
+							   Record.info.modified);
+		}
+
+		template <typename T> bool NotModified(const std::vector<T> &Records) {
+			if constexpr (HasObjectInfo<T>::value) {
+				//	No Last-Modified here: a deleted record does not move the newest timestamp.
+				//	Hashing ids and "modified" keeps to_json out of it; the table write count
+				//	covers updates within one second and changes to child lists.
+				Poco::SHA2Engine E;
+				E.update(std::to_string(ORM::TableVersion<T>::Value.load()));
+				for (const auto &i : Records) {
+					E.update(i.info.id);
+					E.update(std::to_string(i.info.modified));
+				}
+				E.update(Request->getURI());
+				return NotModified(MakeETag(Poco::SHA2Engine::digestToHex(E.digest())));
+			} else {
+				return false;
+			}
+		}
+
+		template <typename T> static void HashRecord(Poco::SHA2Engine &E, const T &Record) {
+			Poco::JSON::Object O;
+			Record.to_json(O);
+			std::ostringstream OS;
+			O.stringify(OS);
+			E.update(OS.str());
+		}
+
+		static inline std::string MakeETag(const std::string &Hash) {
+			return "\"" + Hash.substr(0, 32) + "\"";
 		}
 
 		inline void BadRequest(const OpenWifi::RESTAPI::Errors::msg &E,
@@ -661,6 +849,25 @@ namespace OpenWifi {
 			Answer << json_doc;
 		}
 
+		//	For large lists: records are serialized one by one into the response.
+		inline RESTAPI_JSONStreamWriter StreamArray(const char *ArrayName) {
+			PrepareResponse();
+			return RESTAPI_JSONStreamWriter(*Request, *Response, ArrayName);
+		}
+
+		inline void SetValidators() {
+			if (ETag_.empty())
+				return;
+			Response->set("ETag", ETag_);
+			if (!Response->has("Cache-Control"))
+				Response->set("Cache-Control", "no-cache");
+			if (LastModified_ != 0)
+				Response->set("Last-Modified",
+							  Poco::DateTimeFormatter::format(
+								  Poco::Timestamp::fromEpochTime(LastModified_),
+								  Poco::DateTimeFormat::HTTP_FORMAT));
+		}
+
 		inline void ReturnCountOnly(uint64_t Count) {
 			Poco::JSON::Object Answer;
 			Answer.set("count", Count);
@@ -676,6 +883,7 @@ namespace OpenWifi {
 			QB_.EndDate = GetParameter(RESTAPI::Protocol::ENDDATE, 0);
 			QB_.Offset = GetParameter(RESTAPI::Protocol::OFFSET, 0);
 			QB_.Limit = GetParameter(RESTAPI::Protocol::LIMIT, 100);
+			QB_.UseCursor = HasParameter(RESTAPI::Protocol::CURSOR, QB_.Cursor);
 			QB_.Filter = GetParameter(RESTAPI::Protocol::FILTER, "");
 			QB_.Lifetime = GetBoolParameter(RESTAPI::Protocol::LIFETIME, false);
 			QB_.LogType = GetParameter(RESTAPI::Protocol::LOGTYPE, 0);
@@ -721,10 +929,14 @@ namespace OpenWifi {
 			return RESTAPIHandler::Get(RESTAPI::Protocol::WHEN, Obj);
 		}
 
-		template <typename T> void ReturnObject(const char *Name, const std::vector<T> &Objects) {
-			Poco::JSON::Object Answer;
-			RESTAPI_utils::field_to_json(Answer, Name, Objects);
-			ReturnObject(Answer);
+		template <typename T>
+		void ReturnObject(const char *Name, const std::vector<T> &Objects,
+						  const std::string &NextCursor = "") {
+			auto Writer = StreamArray(Name);
+			if (!NextCursor.empty())
+				Writer.Trailer("nextCursor", NextCursor);
+			for (const auto &Object : Objects)
+				Writer.Add(Object);
 		}
 
 		template <typename T> void Object(const char *Name, const std::vector<T> &Objects) {
@@ -754,21 +966,26 @@ namespace OpenWifi {
 		bool ResolveTargetContext(const std::string &Path, const std::string &Method,
 								  std::string &TargetEntity, std::string &TargetVenue);
 		bool HasScopeConstraint(const std::string &Resource, const std::string &Method);
-		bool PolicyAllows(const ProvObjects::ManagementPolicy &Policy, const std::string &Resource,
-						  const std::string &Method);
+		static bool PolicyAllows(const ProvObjects::ManagementPolicy &Policy,
+								 const std::string &Resource, const std::string &Method);
 		bool FindExistingRole(const std::string &userId, const std::string &entityId,
 							  const std::string &venueId,
 							  ProvObjects::ManagementRole &ExistingRole);
 		bool FindAnyRole(const std::string &userId, ProvObjects::ManagementRole &AnyRole);
-		bool FindAllUserRoles(const std::string &userId,
-							  std::vector<ProvObjects::ManagementRole> &Roles);
+		static bool FindAllUserRoles(const std::string &userId,
+									 std::vector<ProvObjects::ManagementRole> &Roles);
 		bool AutoCreateCreatorRole(const std::string &CreatedEntityId,
 								   const std::string &CreatedVenueId,
 								   const std::string &ParentEntityId,
 								   const std::string &ParentVenueId);
 		static void GetDescendantEntities(const std::string &id, std::set<std::string> &descendants);
 		static void GetDescendantVenues(const std::string &id, std::set<std::string> &venues);
-		std::string GetResourceName(const std::string &Path);
+		static std::string GetResourceName(const std::string &Path);
+
+		//	Set by RESTAPI_RouteTrie: the resource of the matched endpoint, computed once.
+		inline void SetRouteResource(const std::string *Resource) { RouteResource_ = Resource; }
+		//	Set by RESTAPI_RouteTrie: the metrics of the matched endpoint.
+		inline void SetRouteMetrics(RESTAPI_RouteMetrics *Metrics) { RouteMetrics_ = Metrics; }
 
 	  protected:
 		BindingMap Bindings_;
@@ -787,6 +1004,41 @@ namespace OpenWifi {
 		uint64_t TransactionId_;
 		Poco::JSON::Object::Ptr ParsedBody_;
 		std::string REST_Requester_;
+		std::string ETag_;
+		uint64_t LastModified_ = 0;
+		const std::string *RouteResource_ = nullptr;
+		RESTAPI_RouteMetrics *RouteMetrics_ = nullptr;
+
+		//	Records the duration and outcome of handleRequest, whichever way it returns.
+		class RequestMetrics {
+		  public:
+			RequestMetrics(const RESTAPIHandler &Handler, const Poco::Net::HTTPServerRequest &Request,
+						   const Poco::Net::HTTPServerResponse &Response)
+				: Handler_(Handler), Request_(Request), Response_(Response),
+				  Start_(std::chrono::steady_clock::now()) {}
+			~RequestMetrics() {
+				auto &Metrics =
+					Handler_.RouteMetrics_ == nullptr ? Unknown() : *Handler_.RouteMetrics_;
+				Metrics.Record(Request_.getMethod(), (int)Response_.getStatus(),
+							   std::chrono::steady_clock::now() - Start_);
+			}
+
+		  private:
+			const RESTAPIHandler &Handler_;
+			const Poco::Net::HTTPServerRequest &Request_;
+			const Poco::Net::HTTPServerResponse &Response_;
+			std::chrono::steady_clock::time_point Start_;
+
+			static RESTAPI_RouteMetrics &Unknown() {
+				static RESTAPI_RouteMetrics U{"unknown"};
+				return U;
+			}
+		};
+
+		template <typename T, typename = void> struct HasObjectInfo : std::false_type {};
+		template <typename T>
+		struct HasObjectInfo<T, std::void_t<decltype(std::declval<const T &>().info.modified)>>
+			: std::true_type {};
 	};
 
 #ifdef TIP_SECURITY_SERVICE
@@ -0,0 +1,134 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+
+#include "Poco/DeflatingStream.h"
+#include "Poco/Dynamic/Var.h"
+#include "Poco/JSON/Object.h"
+#include "Poco/JSON/Stringifier.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerRequestImpl.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+namespace OpenWifi {
+
+	//	Writes {"<ArrayName>":[ ... ]} straight to a chunked response, one record at a time,
+	//	compressing on the fly when the client accepts it. Headers must be set before the
+	//	writer is created. The 200 status is sent by then: when an exception leaves the
+	//	writer's scope, the connection is reset without the last chunk, so the client sees a
+	//	truncated response rather than a short but well formed list.
+	class RESTAPI_JSONStreamWriter {
+	  public:
+		RESTAPI_JSONStreamWriter(Poco::Net::HTTPServerRequest &Request,
+								 Poco::Net::HTTPServerResponse &Response, const char *ArrayName)
+			: Request_(Request), Exceptions_(std::uncaught_exceptions()) {
+			if (AcceptsGzip(Request)) {
+				Response.set("Content-Encoding", "gzip");
+				std::ostream &Raw = Response.send();
+				Deflater_ = std::make_unique<Poco::DeflatingOutputStream>(
+					Raw, Poco::DeflatingStreamBuf::STREAM_GZIP);
+				Out_ = Deflater_.get();
+			} else {
+				Out_ = &Response.send();
+			}
+			*Out_ << "{\"" << ArrayName << "\":[";
+		}
+
+		RESTAPI_JSONStreamWriter(const RESTAPI_JSONStreamWriter &) = delete;
+		RESTAPI_JSONStreamWriter &operator=(const RESTAPI_JSONStreamWriter &) = delete;
+
+		~RESTAPI_JSONStreamWriter() {
+			try {
+				if (std::uncaught_exceptions() > Exceptions_)
+					Abort();
+				else
+					Close();
+			} catch (...) {
+			}
+		}
+
+		inline void Add(const Poco::JSON::Object &O) {
+			Separator();
+			O.stringify(*Out_);
+		}
+
+		template <typename T> void Add(const T &Record) {
+			if constexpr (HasToJSON<T>::value) {
+				Poco::JSON::Object O;
+				Record.to_json(O);
+				Add(O);
+			} else {
+				Separator();
+				Poco::JSON::Stringifier::stringify(Poco::Dynamic::Var(Record), *Out_);
+			}
+		}
+
+		//	Adds a member after the array, such as the cursor of the next page.
+		inline void Trailer(const std::string &Name, const Poco::Dynamic::Var &Value) {
+			Trailer_.set(Name, Value);
+		}
+
+		inline void Close() {
+			if (Closed_)
+				return;
+			Closed_ = true;
+			*Out_ << ']';
+			for (const auto &[Name, Value] : Trailer_) {
+				*Out_ << ",\"" << Name << "\":";
+				Poco::JSON::Stringifier::stringify(Value, *Out_);
+			}
+			*Out_ << '}';
+			if (Deflater_)
+				Deflater_->close();
+		}
+
+		//	Ends the response without closing the array or the chunked encoding.
+		inline void Abort() {
+			if (Closed_)
+				return;
+			Closed_ = true;
+			auto Impl = dynamic_cast<Poco::Net::HTTPServerRequestImpl *>(&Request_);
+			if (Impl == nullptr)
+				return;
+			auto &Socket = Impl->socket();
+			Socket.setLinger(true, 0);
+			Socket.shutdown();
+		}
+
+		static inline bool AcceptsGzip(const Poco::Net::HTTPServerRequest &Request) {
+			auto AcceptedEncoding = Request.find("Accept-Encoding");
+			return AcceptedEncoding != Request.end() &&
+				   (AcceptedEncoding->second.find("gzip") != std::string::npos ||
+					AcceptedEncoding->second.find("compress") != std::string::npos);
+		}
+
+	  private:
+		template <typename T, typename = void> struct HasToJSON : std::false_type {};
+		template <typename T>
+		struct HasToJSON<T, std::void_t<decltype(std::declval<const T &>().to_json(
+								std::declval<Poco::JSON::Object &>()))>> : std::true_type {};
+
+		Poco::Net::HTTPServerRequest &Request_;
+		int Exceptions_ = 0;
+		std::unique_ptr<Poco::DeflatingOutputStream> Deflater_;
+		std::ostream *Out_ = nullptr;
+		Poco::JSON::Object Trailer_;
+		bool First_ = true;
+		bool Closed_ = false;
+
+		inline void Separator() {
+			if (First_)
+				First_ = false;
+			else
+				*Out_ << ',';
+		}
+	};
+
+} // namespace OpenWifi
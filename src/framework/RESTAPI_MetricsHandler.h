@@ -0,0 +1,41 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include "framework/MetricsRegistry.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/RESTAPI_Handler.h"
+
+namespace OpenWifi {
+
+	//	Prometheus scrape endpoint on the internal REST server. Scrapers authenticate with the
+	//	service API key unless metrics.authorize is false.
+	class RESTAPI_metrics_handler : public RESTAPIHandler {
+	  public:
+		RESTAPI_metrics_handler(const RESTAPIHandler::BindingMap &bindings, Poco::Logger &L,
+								RESTAPI_GenericServerAccounting &Server, uint64_t TransactionId,
+								bool Internal)
+			: RESTAPIHandler(bindings, L,
+							 std::vector<std::string>{Poco::Net::HTTPRequest::HTTP_GET,
+													  Poco::Net::HTTPRequest::HTTP_OPTIONS},
+							 Server, TransactionId, Internal,
+							 MicroServiceConfigGetBool("metrics.authorize", true)) {}
+
+		static auto PathName() { return std::list<std::string>{"/api/v1/metrics"}; }
+
+		inline void DoGet() final {
+			auto Body = MetricsRegistry()->Prometheus();
+			PrepareResponse();
+			Response->set("Cache-Control", "no-store");
+			Response->setContentType("text/plain; version=0.0.4; charset=utf-8");
+			Response->setContentLength(Body.size());
+			Response->send().write(Body.data(), (std::streamsize)Body.size());
+		}
+		inline void DoPost() final {}
+		inline void DoPut() final {}
+		inline void DoDelete() final {}
+	};
+
+} // namespace OpenWifi
@@ -4,64 +4,233 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
 
-#include "Poco/ExpireLRUCache.h"
 #include "Poco/Net/HTTPServerRequest.h"
-#include "Poco/URI.h"
 
 #include "fmt/format.h"
 
 namespace OpenWifi {
 
+	//	Token buckets per (client address, route class), where the route class is the first path
+	//	segment after the API version, e.g. "subscriber" for /api/v1/subscriber/{id}. Buckets are
+	//	GCRA cells: a single atomic "theoretical arrival time" gives lock-free refill and an exact
+	//	burst bound with no window edges. Buckets live in shards so clients do not share a lock.
 	class RESTAPI_RateLimiter : public SubSystemServer {
 	  public:
-		struct ClientCacheEntry {
-			int64_t Start = 0;
-			int Count = 0;
-		};
-
 		static auto instance() {
 			static auto instance_ = new RESTAPI_RateLimiter;
 			return instance_;
 		}
 
-		inline int Start() final { return 0; };
+		inline int Start() final {
+			MaxBucketsPerShard_ = std::max<std::size_t>(
+				1, MicroServiceConfigGetInt("ratelimit.maxclients", 16384) / Shards);
+			return 0;
+		};
 		inline void Stop() final{};
 
-		inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, int64_t Period,
-								  int64_t MaxCalls) {
-			Poco::URI uri(R.getURI());
-			auto H = str_hash(uri.getPath() + R.clientAddress().host().toString());
-			auto E = Cache_.get(H);
-			auto Now = std::chrono::duration_cast<std::chrono::milliseconds>(
-						   std::chrono::system_clock::now().time_since_epoch())
-						   .count();
-			if (E.isNull()) {
-				Cache_.add(H, ClientCacheEntry{.Start = Now, .Count = 1});
+		//	Path is the endpoint the router matched, or the request URI.
+		//	Interval/MaxCalls is the handler's default rate; ratelimit.<route>.interval and
+		//	ratelimit.<route>.maxcalls override it, ratelimit.<route>.burst sets the bucket depth.
+		inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, std::string_view Path,
+								  int64_t Interval, int64_t MaxCalls) {
+			const auto &Host = R.clientAddress().host();
+			if (!IsRateLimited(std::string((const char *)Host.addr(), Host.length()), Path,
+							   Interval, MaxCalls, NowMicros()))
 				return false;
-			}
-			if ((Now - E->Start) < Period) {
-				E->Count++;
-				Cache_.update(H, E);
-				if (E->Count > MaxCalls) {
-					poco_warning(Logger(), fmt::format("RATE-LIMIT-EXCEEDED: from '{}'",
-													   R.clientAddress().toString()));
-					return true;
-				}
+			poco_warning(Logger(), fmt::format("RATE-LIMIT-EXCEEDED: from '{}' on '{}'",
+											   R.clientAddress().toString(), RouteClass(Path)));
+			return true;
+		}
+
+		//	The same decision for any string identifying the client, at Now microseconds.
+		inline bool IsRateLimited(const std::string &Client, std::string_view URI,
+								  int64_t Interval, int64_t MaxCalls, int64_t Now) {
+			auto Route = RouteClass(URI);
+			auto Rate = RateFor(Route, Interval, MaxCalls);
+			if (Rate.Emission == 0)
 				return false;
+
+			auto Bucket = Find(BucketKey{Client, std::string(Route)});
+			auto TAT = Bucket->TAT.load(std::memory_order_relaxed);
+			while (true) {
+				auto Start = std::max(TAT, Now);
+				if (Start - Now > Rate.Tolerance)
+					return true;
+				if (Bucket->TAT.compare_exchange_weak(TAT, Start + Rate.Emission,
+													 std::memory_order_relaxed))
+					return false;
+			}
+		}
+
+		[[nodiscard]] inline std::size_t Clients() {
+			std::size_t Count = 0;
+			for (auto &S : Shards_) {
+				std::shared_lock L(S.Mutex);
+				Count += S.Slots.size();
 			}
-			E->Start = Now;
-			E->Count = 1;
-			Cache_.update(H, E);
-			return false;
+			return Count;
 		}
 
-		inline void Clear() { Cache_.clear(); }
+		inline void Clear() {
+			for (auto &S : Shards_) {
+				std::unique_lock L(S.Mutex);
+				S.Slots.clear();
+				S.Index.clear();
+				S.Hand = 0;
+			}
+			std::unique_lock L(RatesMutex_);
+			Rates_.clear();
+		}
 
 	  private:
-		Poco::ExpireLRUCache<uint64_t, ClientCacheEntry> Cache_{2048};
-		std::hash<std::string> str_hash;
+		static constexpr std::size_t Shards = 16;
+
+		struct Bucket {
+			std::atomic<int64_t> TAT{0};
+			std::atomic_bool Referenced{true}; //	used since the clock hand last passed
+		};
+
+		//	Client address bytes and route class. Keyed on the pair itself, so two clients never
+		//	share a bucket through a hash collision.
+		using BucketKey = std::pair<std::string, std::string>;
+		struct BucketKeyHash {
+			inline std::size_t operator()(const BucketKey &K) const {
+				auto H = std::hash<std::string>{}(K.first);
+				return H ^ (std::hash<std::string>{}(K.second) + 0x9e3779b97f4a7c15ULL + (H << 6) +
+							(H >> 2));
+			}
+		};
+
+		struct Slot {
+			BucketKey Key;
+			std::shared_ptr<Bucket> B;
+		};
+
+		//	At most MaxBucketsPerShard_ slots. Once full, a new client takes the slot a clock
+		//	hand picks.
+		struct Shard {
+			std::shared_mutex Mutex;
+			std::vector<Slot> Slots;
+			std::unordered_map<BucketKey, std::size_t, BucketKeyHash> Index;
+			std::size_t Hand = 0;
+		};
+
+		//	Route class and the handler's own Interval and MaxCalls: handlers sharing a route
+		//	class keep their own default rates.
+		using RateKey = std::tuple<std::string, int64_t, int64_t>;
+		struct RateKeyHash {
+			inline std::size_t operator()(const RateKey &K) const {
+				return std::hash<std::string>{}(std::get<0>(K)) ^
+					   (std::hash<int64_t>{}(std::get<1>(K)) * 31) ^
+					   (std::hash<int64_t>{}(std::get<2>(K)) * 131);
+			}
+		};
+
+		struct RouteRate {
+			int64_t Emission = 0;  //	microseconds per call
+			int64_t Tolerance = 0; //	how far ahead of now the bucket may run: (burst-1) calls
+		};
+
+		std::array<Shard, Shards> Shards_;
+		std::size_t MaxBucketsPerShard_ = 1024;
+		std::shared_mutex RatesMutex_;
+		std::unordered_map<RateKey, RouteRate, RateKeyHash> Rates_;
+
+		static inline int64_t NowMicros() {
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+					   std::chrono::steady_clock::now().time_since_epoch())
+				.count();
+		}
+
+		static inline std::string_view RouteClass(std::string_view Path) {
+			Path = Path.substr(0, Path.find('?'));
+			if (Path.substr(0, 5) == "/api/") {
+				auto Version = Path.find('/', 5);
+				if (Version != std::string_view::npos)
+					Path.remove_prefix(Version + 1);
+			} else if (!Path.empty() && Path[0] == '/') {
+				Path.remove_prefix(1);
+			}
+			return Path.substr(0, Path.find('/'));
+		}
+
+		inline RouteRate RateFor(std::string_view Route, int64_t Interval, int64_t MaxCalls) {
+			RateKey Key{std::string(Route), Interval, MaxCalls};
+			{
+				std::shared_lock L(RatesMutex_);
+				auto hint = Rates_.find(Key);
+				if (hint != Rates_.end())
+					return hint->second;
+			}
+			auto Prefix = "ratelimit." + std::get<0>(Key);
+			Interval = MicroServiceConfigGetInt(Prefix + ".interval", Interval);
+			MaxCalls = MicroServiceConfigGetInt(Prefix + ".maxcalls", MaxCalls);
+			auto Burst =
+				std::max<int64_t>(1, MicroServiceConfigGetInt(Prefix + ".burst", MaxCalls));
+			RouteRate Rate;
+			if (Interval > 0 && MaxCalls > 0) {
+				Rate.Emission = std::max<int64_t>(1, Interval * 1000 / MaxCalls);
+				Rate.Tolerance = Rate.Emission * (Burst - 1);
+			}
+			std::unique_lock L(RatesMutex_);
+			return Rates_.emplace(std::move(Key), Rate).first->second;
+		}
+
+		inline std::shared_ptr<Bucket> Find(const BucketKey &Key) {
+			auto &S = Shards_[BucketKeyHash{}(Key) % Shards];
+			{
+				std::shared_lock L(S.Mutex);
+				auto hint = S.Index.find(Key);
+				if (hint != S.Index.end()) {
+					auto &B = S.Slots[hint->second].B;
+					B->Referenced.store(true, std::memory_order_relaxed);
+					return B;
+				}
+			}
+			std::unique_lock L(S.Mutex);
+			auto hint = S.Index.find(Key);
+			if (hint != S.Index.end())
+				return S.Slots[hint->second].B;
+
+			auto B = std::make_shared<Bucket>();
+			if (S.Slots.size() < MaxBucketsPerShard_) {
+				S.Index.emplace(Key, S.Slots.size());
+				S.Slots.push_back(Slot{Key, B});
+				return B;
+			}
+			//	A bucket whose arrival time has passed is full again: forgetting it is exact.
+			//	Otherwise the first bucket not used since the hand last passed is forgotten. The
+			//	hand clears the marks it passes, so it stops within one turn.
+			auto Now = NowMicros();
+			while (true) {
+				auto Victim = S.Hand;
+				S.Hand = (S.Hand + 1) % S.Slots.size();
+				auto &V = S.Slots[Victim];
+				if (V.B->TAT.load(std::memory_order_relaxed) <= Now ||
+					!V.B->Referenced.exchange(false, std::memory_order_relaxed)) {
+					S.Index.erase(V.Key);
+					S.Index.emplace(Key, Victim);
+					V = Slot{Key, B};
+					return B;
+				}
+			}
+		}
 
 		RESTAPI_RateLimiter() noexcept
 			: SubSystemServer("RateLimiter", "RATE-LIMITER", "rate.limiter") {}
@@ -69,4 +238,4 @@ namespace OpenWifi {
 
 	inline auto RESTAPI_RateLimiter() { return RESTAPI_RateLimiter::instance(); }
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
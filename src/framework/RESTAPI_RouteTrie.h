@@ -0,0 +1,162 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Poco/String.h"
+
+#include "framework/RESTAPI_Handler.h"
+
+namespace OpenWifi {
+
+	//	Routing table built once from the PathName() lists of a set of handlers. Paths are
+	//	matched one segment at a time against a trie of literal and {parameter} segments, which
+	//	yields the handler factory, the bindings and the authorization resource in one pass.
+	//	When several endpoints match, the one registered first wins, as with RESTAPI_Router.
+	class RESTAPI_RouteTrie {
+	  public:
+		using Factory = RESTAPIHandler *(*)(RESTAPIHandler::BindingMap &Bindings,
+											 Poco::Logger &Logger,
+											 RESTAPI_GenericServerAccounting &Server,
+											 uint64_t TransactionId, bool Internal);
+
+		struct Route {
+			std::string EndPoint;
+			std::string Resource;
+			std::vector<std::pair<std::size_t, std::string>> Parameters; //	segment, binding
+			Factory Create = nullptr;
+			std::size_t Order = 0;
+			std::unique_ptr<RESTAPI_RouteMetrics> Metrics;
+		};
+
+		template <typename... Handlers> static RESTAPI_RouteTrie Build() {
+			RESTAPI_RouteTrie Trie;
+			(Trie.AddHandler<Handlers>(), ...);
+			return Trie;
+		}
+
+		[[nodiscard]] const Route *Find(std::string_view Path,
+										RESTAPIHandler::BindingMap &Bindings) const {
+			Bindings.clear();
+			Segments_.clear();
+			std::size_t Start = 0;
+			while (true) {
+				auto Next = Path.find('/', Start);
+				Segments_.emplace_back(Path.substr(Start, Next == std::string_view::npos
+															  ? std::string_view::npos
+															  : Next - Start));
+				if (Next == std::string_view::npos)
+					break;
+				Start = Next + 1;
+			}
+
+			const Route *Best = nullptr;
+			Search(Root_, 0, Best);
+			if (Best != nullptr) {
+				for (const auto &[segment, name] : Best->Parameters)
+					Bindings[name] = std::string(Segments_[segment]);
+			}
+			return Best;
+		}
+
+		RESTAPIHandler *Dispatch(const std::string &Path, RESTAPIHandler::BindingMap &Bindings,
+								 Poco::Logger &Logger, RESTAPI_GenericServerAccounting &Server,
+								 uint64_t TransactionId, bool Internal) const {
+			auto R = Find(Path, Bindings);
+			if (R == nullptr)
+				return new RESTAPI_UnknownRequestHandler(Bindings, Logger, Server, TransactionId,
+														 Internal);
+			auto Handler = R->Create(Bindings, Logger, Server, TransactionId, Internal);
+			Handler->SetRouteResource(&R->Resource);
+			Handler->SetRouteMetrics(R->Metrics.get());
+			return Handler;
+		}
+
+		[[nodiscard]] const std::deque<Route> &Routes() const { return Routes_; }
+
+	  private:
+		struct Node {
+			std::map<std::string, std::unique_ptr<Node>, std::less<>> Literals;
+			std::unique_ptr<Node> Parameter;
+			const Route *Leaf = nullptr;
+		};
+
+		Node Root_;
+		std::deque<Route> Routes_;
+		//	Scratch space for Find: handler factories run on the server's threads.
+		static inline thread_local std::vector<std::string_view> Segments_;
+
+		template <typename T>
+		static RESTAPIHandler *Create(RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
+									  RESTAPI_GenericServerAccounting &Server,
+									  uint64_t TransactionId, bool Internal) {
+			return new T(Bindings, Logger, Server, TransactionId, Internal);
+		}
+
+		template <typename T> void AddHandler() {
+			static_assert(test_has_PathName_method((T *)nullptr),
+						  "Class must have a static PathName() method.");
+			for (const auto &EndPoint : T::PathName())
+				Add(EndPoint, &Create<T>);
+		}
+
+		void Add(const std::string &EndPoint, Factory Create) {
+			auto &R = Routes_.emplace_back();
+			R.EndPoint = EndPoint;
+			R.Resource = RESTAPIHandler::GetResourceName(EndPoint);
+			R.Create = Create;
+			R.Order = Routes_.size() - 1;
+			R.Metrics = std::make_unique<RESTAPI_RouteMetrics>(EndPoint);
+
+			Node *Current = &Root_;
+			std::size_t Segment = 0, Start = 0;
+			while (true) {
+				auto Next = EndPoint.find('/', Start);
+				auto Item = EndPoint.substr(Start, Next == std::string::npos ? std::string::npos
+																			 : Next - Start);
+				if (!Item.empty() && Item.front() == '{') {
+					R.Parameters.emplace_back(Segment,
+											  Poco::toLower(Item.substr(1, Item.size() - 2)));
+					if (!Current->Parameter)
+						Current->Parameter = std::make_unique<Node>();
+					Current = Current->Parameter.get();
+				} else {
+					auto &Child = Current->Literals[Item];
+					if (!Child)
+						Child = std::make_unique<Node>();
+					Current = Child.get();
+				}
+				++Segment;
+				if (Next == std::string::npos)
+					break;
+				Start = Next + 1;
+			}
+			if (Current->Leaf == nullptr)
+				Current->Leaf = &R;
+		}
+
+		static void Search(const Node &N, std::size_t Depth, const Route *&Best) {
+			if (Depth == Segments_.size()) {
+				if (N.Leaf != nullptr && (Best == nullptr || N.Leaf->Order < Best->Order))
+					Best = N.Leaf;
+				return;
+			}
+			if (!N.Literals.empty()) {
+				auto hint = N.Literals.find(Segments_[Depth]);
+				if (hint != N.Literals.end())
+					Search(*hint->second, Depth + 1, Best);
+			}
+			if (N.Parameter)
+				Search(*N.Parameter, Depth + 1, Best);
+		}
+	};
+
+} // namespace OpenWifi
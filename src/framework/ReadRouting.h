@@ -0,0 +1,110 @@
+//
+// Created by stephane bourque on 2023-11-29.
+//
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "Poco/Data/SessionPool.h"
+
+namespace OpenWifi {
+
+	//	Decides whether ORM reads go to the read replica of a database, when it has one. Reads
+	//	use the primary unless the current thread is inside a Replica scope: REST requests that
+	//	do not write, did not ask for the primary and come from a session that did not write
+	//	recently. Background tasks, which read records to write them back, never see a lagging
+	//	replica. Primary scopes inside a Replica scope, e.g. read-modify-write helpers, win.
+	class ReadRouting {
+	  public:
+		//	Reads on this thread may go to the replica while this is alive, unless Enable is
+		//	false or an enclosing Primary scope is alive.
+		class Replica {
+		  public:
+			explicit Replica(bool Enable = true) : Previous_(PrimaryReads_) {
+				PrimaryReads_ = PrimaryReads_ && !Enable;
+			}
+			~Replica() { PrimaryReads_ = Previous_; }
+			Replica(const Replica &) = delete;
+			Replica &operator=(const Replica &) = delete;
+
+		  private:
+			bool Previous_;
+		};
+
+		//	Reads on this thread go to the primary while this is alive. Scopes nest.
+		class Primary {
+		  public:
+			explicit Primary(bool Enable = true) : Previous_(PrimaryReads_) {
+				PrimaryReads_ = PrimaryReads_ || Enable;
+			}
+			~Primary() { PrimaryReads_ = Previous_; }
+			Primary(const Primary &) = delete;
+			Primary &operator=(const Primary &) = delete;
+
+		  private:
+			bool Previous_;
+		};
+
+		//	The ORM tables only see the primary pool: they find the replica for it here.
+		static inline void SetReplica(const void *Pool, Poco::Data::SessionPool *Replica) {
+			std::lock_guard G(Mutex_);
+			if (Replica)
+				Replicas_[Pool] = Replica;
+			else
+				Replicas_.erase(Pool);
+		}
+
+		static inline Poco::Data::SessionPool *ReplicaOf(const void *Pool) {
+			std::lock_guard G(Mutex_);
+			auto It = Replicas_.find(Pool);
+			return It == Replicas_.end() ? nullptr : It->second;
+		}
+
+		[[nodiscard]] static inline bool PrimaryReads() { return PrimaryReads_; }
+
+		//	Read-your-writes for sessions: reads stay on the primary for Stickiness_ after the
+		//	session last wrote, long enough for the replica to catch up.
+		static inline void SetStickiness(std::chrono::seconds Stickiness) {
+			std::lock_guard G(Mutex_);
+			Stickiness_ = Stickiness;
+		}
+
+		static inline void Wrote(const std::string &Session) {
+			if (Session.empty())
+				return;
+			std::lock_guard G(Mutex_);
+			auto Now = std::chrono::steady_clock::now();
+			LastWrite_[Session] = Now;
+			//	Forget sessions that are past the window, so the map stays small.
+			if (LastWrite_.size() > 1024) {
+				for (auto It = LastWrite_.begin(); It != LastWrite_.end();) {
+					if (Now - It->second > Stickiness_)
+						It = LastWrite_.erase(It);
+					else
+						++It;
+				}
+			}
+		}
+
+		[[nodiscard]] static inline bool RecentlyWrote(const std::string &Session) {
+			if (Session.empty())
+				return false;
+			std::lock_guard G(Mutex_);
+			auto It = LastWrite_.find(Session);
+			return It != LastWrite_.end() &&
+				   std::chrono::steady_clock::now() - It->second <= Stickiness_;
+		}
+
+	  private:
+		static inline std::mutex Mutex_;
+		static inline std::map<const void *, Poco::Data::SessionPool *> Replicas_;
+		static inline std::map<std::string, std::chrono::steady_clock::time_point> LastWrite_;
+		static inline std::chrono::steady_clock::duration Stickiness_ = std::chrono::seconds(5);
+		static inline thread_local bool PrimaryReads_ = true;
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,179 @@
+//
+// Created by stephane bourque on 2023-11-28.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Poco/Data/Session.h"
+#include "Poco/Data/Statement.h"
+#include "Poco/Exception.h"
+#include "Poco/Logger.h"
+
+namespace OpenWifi {
+
+	//	Runs every write against an SQLite database on one connection and one thread. Writes
+	//	queued while a commit is in progress are committed together in the next transaction, so
+	//	the journal sync is paid once per batch instead of once per statement. Each write runs
+	//	under its own savepoint: a failing write is rolled back alone and its exception is
+	//	rethrown to its caller.
+	class SQLiteWriter {
+	  public:
+		using Operation = std::function<void(Poco::Data::Session &)>;
+
+		SQLiteWriter(Poco::Data::Session Session, Poco::Logger &L, std::size_t MaxBatch,
+					 std::chrono::microseconds CommitDelay)
+			: Session_(std::move(Session)), Logger_(L),
+			  MaxBatch_(std::max<std::size_t>(1, MaxBatch)), CommitDelay_(CommitDelay) {}
+
+		~SQLiteWriter() { Stop(); }
+
+		inline void Start() {
+			std::lock_guard G(Mutex_);
+			if (Running_)
+				return;
+			Running_ = true;
+			Worker_ = std::thread([this] { run(); });
+		}
+
+		//	Commits whatever is queued, then stops. Later writes throw.
+		inline void Stop() {
+			{
+				std::lock_guard G(Mutex_);
+				if (!Running_)
+					return;
+				Running_ = false;
+			}
+			Wake_.notify_all();
+			if (Worker_.joinable())
+				Worker_.join();
+		}
+
+		//	Blocks until the batch holding Op is committed. Throws what Op threw, or what the
+		//	commit threw.
+		inline void Write(Operation Op) {
+			std::promise<void> Done;
+			auto Result = Done.get_future();
+			{
+				std::lock_guard G(Mutex_);
+				if (!Running_)
+					throw Poco::IllegalStateException("SQLite writer is stopped.");
+				Queue_.push_back(QueuedWrite{std::move(Op), std::move(Done)});
+			}
+			Wake_.notify_one();
+			Result.get();
+		}
+
+		[[nodiscard]] inline std::size_t Pending() {
+			std::lock_guard G(Mutex_);
+			return Queue_.size();
+		}
+
+		//	The ORM tables only see the session pool: they find the writer for it here.
+		static inline void Register(const void *Pool, SQLiteWriter *Writer) {
+			std::lock_guard G(RegistryMutex_);
+			if (Writer)
+				Registry_[Pool] = Writer;
+			else
+				Registry_.erase(Pool);
+		}
+
+		static inline SQLiteWriter *For(const void *Pool) {
+			std::lock_guard G(RegistryMutex_);
+			auto It = Registry_.find(Pool);
+			return It == Registry_.end() ? nullptr : It->second;
+		}
+
+	  private:
+		struct QueuedWrite {
+			Operation Op;
+			std::promise<void> Done;
+			std::exception_ptr Error;
+		};
+
+		Poco::Data::Session Session_;
+		Poco::Logger &Logger_;
+		std::size_t MaxBatch_;
+		std::chrono::microseconds CommitDelay_;
+		std::mutex Mutex_;
+		std::condition_variable Wake_;
+		std::deque<QueuedWrite> Queue_;
+		std::thread Worker_;
+		bool Running_ = false;
+
+		static inline std::mutex RegistryMutex_;
+		static inline std::map<const void *, SQLiteWriter *> Registry_;
+
+		inline void run() {
+			while (true) {
+				std::vector<QueuedWrite> Batch;
+				{
+					std::unique_lock Lock(Mutex_);
+					Wake_.wait(Lock, [this] { return !Queue_.empty() || !Running_; });
+					if (Queue_.empty())
+						break;
+					if (CommitDelay_.count() > 0 && Running_ && Queue_.size() < MaxBatch_)
+						Wake_.wait_for(Lock, CommitDelay_,
+									   [this] { return Queue_.size() >= MaxBatch_ || !Running_; });
+					while (!Queue_.empty() && Batch.size() < MaxBatch_) {
+						Batch.push_back(std::move(Queue_.front()));
+						Queue_.pop_front();
+					}
+				}
+				Commit(Batch);
+			}
+		}
+
+		inline void Commit(std::vector<QueuedWrite> &Batch) {
+			using Poco::Data::Keywords::now;
+			try {
+				Session_.begin();
+				for (auto &P : Batch) {
+					try {
+						Session_ << "SAVEPOINT write", now;
+						P.Op(Session_);
+						Session_ << "RELEASE write", now;
+					} catch (...) {
+						P.Error = std::current_exception();
+						try {
+							Session_ << "ROLLBACK TO write", now;
+							Session_ << "RELEASE write", now;
+						} catch (const Poco::Exception &E) {
+							Logger_.log(E);
+						}
+					}
+				}
+				Session_.commit();
+			} catch (...) {
+				auto Error = std::current_exception();
+				try {
+					if (Session_.isTransaction())
+						Session_.rollback();
+				} catch (const Poco::Exception &E) {
+					Logger_.log(E);
+				}
+				for (auto &P : Batch)
+					if (!P.Error)
+						P.Error = Error;
+			}
+			for (auto &P : Batch) {
+				if (P.Error)
+					P.Done.set_exception(P.Error);
+				else
+					P.Done.set_value();
+			}
+		}
+	};
+
+} // namespace OpenWifi
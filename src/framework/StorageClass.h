@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "Poco/Data/SQLite/Connector.h"
 #include "Poco/Data/Session.h"
 #include "Poco/Data/SessionPool.h"
@@ -15,8 +17,12 @@
 #endif
 
 #include "framework/MicroServiceFuncs.h"
+#include "framework/ReadRouting.h"
+#include "framework/SQLiteWriter.h"
 #include "framework/SubSystemServer.h"
 
+#include "fmt/format.h"
+
 namespace OpenWifi {
 	enum DBType { sqlite, pgsql, mysql };
 
@@ -39,7 +45,17 @@ namespace OpenWifi {
 			return 0;
 		}
 
-		inline void Stop() override { Pool_->shutdown(); }
+		inline void Stop() override {
+			if (Writer_) {
+				Writer_->Stop();
+				SQLiteWriter::Register(Pool_.get(), nullptr);
+			}
+			if (ReadPool_) {
+				ReadRouting::SetReplica(Pool_.get(), nullptr);
+				ReadPool_->shutdown();
+			}
+			Pool_->shutdown();
+		}
 
 		DBType Type() const { return dbType_; };
 
@@ -48,18 +64,27 @@ namespace OpenWifi {
         }
 
 		Poco::Data::SessionPool &Pool() { return *Pool_; }
+		//	The read replica pool when one is configured, the primary pool otherwise.
+		Poco::Data::SessionPool &ReadPool() { return ReadPool_ ? *ReadPool_ : *Pool_; }
 
 	  private:
 		inline int Setup_SQLite();
+		inline void Setup_SQLiteWAL(const std::string &DBName, int NumSessions);
+		inline void SQLitePragmas(Poco::Data::Session &Session);
 		inline int Setup_MySQL();
 		inline int Setup_PostgreSQL();
+		inline std::string ReplicaSetting(const std::string &DB, const std::string &Name);
+		inline void Setup_Replica(const std::string &Connector, const std::string &DB,
+								  const std::string &ConnectionStr);
 
 
     protected:
 		std::shared_ptr<Poco::Data::SessionPool> Pool_;
+		std::shared_ptr<Poco::Data::SessionPool> ReadPool_;
 		Poco::Data::SQLite::Connector SQLiteConn_;
 		Poco::Data::PostgreSQL::Connector PostgresConn_;
 		Poco::Data::MySQL::Connector MySQLConn_;
+		std::unique_ptr<SQLiteWriter> Writer_;
 		DBType dbType_ = sqlite;
 	};
 
@@ -77,12 +102,18 @@ namespace OpenWifi {
 	inline int StorageClass::Setup_SQLite() {
 		Logger().notice("SQLite StorageClass enabled.");
 		dbType_ = sqlite;
-		auto DBName = MicroServiceDataDirectory() + "/" +
-					  MicroServiceConfigGetString("storage.type.sqlite.db", "");
+		//	An SQLite URI such as "file:name?mode=memory&cache=shared" is used as is.
+		auto DBFile = MicroServiceConfigGetString("storage.type.sqlite.db", "");
+		auto DBName =
+			DBFile.rfind("file:", 0) == 0 ? DBFile : MicroServiceDataDirectory() + "/" + DBFile;
 		int NumSessions = (int)MicroServiceConfigGetInt("storage.type.sqlite.maxsessions", 64);
 		int IdleTime = (int)MicroServiceConfigGetInt("storage.type.sqlite.idletime", 60);
 
 		Poco::Data::SQLite::Connector::registerConnector();
+		if (MicroServiceConfigGetBool("storage.type.sqlite.wal", false)) {
+			Setup_SQLiteWAL(DBName, NumSessions);
+			return 0;
+		}
 		//        Pool_ = std::make_unique<Poco::Data::SessionPool>(new
 		//        Poco::Data::SessionPool(SQLiteConn_.name(), DBName, 8,
 		//                                                                                     (int)NumSessions,
@@ -92,6 +123,54 @@ namespace OpenWifi {
 		return 0;
 	}
 
+	//	WAL mode: readers never wait for the writer, and all writes go through one connection
+	//	and thread (SQLiteWriter) with group commit, so they never compete for the database lock.
+	//	The first Readers sessions of the pool are opened up front, so they get the pragmas. The
+	//	pool still grows to NumSessions: SessionPool::get() throws rather than waits when it is
+	//	exhausted.
+	inline void StorageClass::Setup_SQLiteWAL(const std::string &DBName, int NumSessions) {
+		int Readers = std::min(
+			(int)MicroServiceConfigGetInt("storage.type.sqlite.readers", 8), NumSessions);
+		int IdleTime = (int)MicroServiceConfigGetInt("storage.type.sqlite.idletime", 60);
+		auto MaxBatch = MicroServiceConfigGetInt("storage.type.sqlite.writebatch", 256);
+		auto CommitDelay = MicroServiceConfigGetInt("storage.type.sqlite.commitdelay", 0);
+
+		Poco::Data::Session WriterSession(SQLiteConn_.name(), DBName);
+		std::string JournalMode;
+		WriterSession << "PRAGMA journal_mode=WAL", Poco::Data::Keywords::into(JournalMode),
+			Poco::Data::Keywords::now;
+		SQLitePragmas(WriterSession);
+		Logger().notice(fmt::format("SQLite journal mode: {}, {} to {} readers, single writer.",
+									JournalMode, Readers, NumSessions));
+
+		Pool_ = std::make_shared<Poco::Data::SessionPool>(SQLiteConn_.name(), DBName, Readers,
+														  NumSessions, IdleTime);
+		std::vector<Poco::Data::Session> Sessions;
+		for (int i = 0; i < Readers; ++i) {
+			Sessions.push_back(Pool_->get());
+			SQLitePragmas(Sessions.back());
+		}
+		Sessions.clear();
+
+		Writer_ = std::make_unique<SQLiteWriter>(std::move(WriterSession), Logger(), MaxBatch,
+												 std::chrono::microseconds(CommitDelay));
+		Writer_->Start();
+		SQLiteWriter::Register(Pool_.get(), Writer_.get());
+	}
+
+	inline void StorageClass::SQLitePragmas(Poco::Data::Session &Session) {
+		using Poco::Data::Keywords::now;
+		auto Synchronous = MicroServiceConfigGetString("storage.type.sqlite.synchronous", "NORMAL");
+		auto CacheSize = MicroServiceConfigGetInt("storage.type.sqlite.cachesize", 65536);
+		auto MmapSize = MicroServiceConfigGetInt("storage.type.sqlite.mmapsize", 268435456);
+		auto BusyTimeout = MicroServiceConfigGetInt("storage.type.sqlite.busytimeout", 5000);
+		Session << "PRAGMA synchronous=" + Synchronous, now;
+		//	A negative cache_size is in KiB rather than pages.
+		Session << "PRAGMA cache_size=-" + std::to_string(CacheSize), now;
+		Session << "PRAGMA mmap_size=" + std::to_string(MmapSize), now;
+		Session << "PRAGMA busy_timeout=" + std::to_string(BusyTimeout), now;
+	}
+
 	inline int StorageClass::Setup_MySQL() {
 		Logger().notice("MySQL StorageClass enabled.");
 		dbType_ = mysql;
@@ -111,6 +190,13 @@ namespace OpenWifi {
 		Pool_ = std::make_shared<Poco::Data::SessionPool>(MySQLConn_.name(), ConnectionStr, 8,
 														  NumSessions, IdleTime);
 
+		if (!MicroServiceConfigGetString("storage.type.mysql.replica.host", "").empty()) {
+			auto R = [this](const char *Name) { return ReplicaSetting("mysql", Name); };
+			Setup_Replica(MySQLConn_.name(), "mysql",
+						  "host=" + R("host") + ";user=" + R("username") +
+							  ";password=" + R("password") + ";db=" + R("database") +
+							  ";port=" + R("port") + ";compress=true;auto-reconnect=true");
+		}
 		return 0;
 	}
 
@@ -135,8 +221,36 @@ namespace OpenWifi {
 		Pool_ = std::make_shared<Poco::Data::SessionPool>(PostgresConn_.name(), ConnectionStr, 8,
 														  NumSessions, IdleTime);
 
+		if (!MicroServiceConfigGetString("storage.type.postgresql.replica.host", "").empty()) {
+			auto R = [this](const char *Name) { return ReplicaSetting("postgresql", Name); };
+			Setup_Replica(PostgresConn_.name(), "postgresql",
+						  "host=" + R("host") + " user=" + R("username") +
+							  " password=" + R("password") + " dbname=" + R("database") +
+							  " port=" + R("port") + " connect_timeout=" + R("connectiontimeout"));
+		}
 		return 0;
 	}
+
+	//	A replica setting that is not given is the primary's.
+	inline std::string StorageClass::ReplicaSetting(const std::string &DB, const std::string &Name) {
+		return MicroServiceConfigGetString(
+			"storage.type." + DB + ".replica." + Name,
+			MicroServiceConfigGetString("storage.type." + DB + "." + Name, ""));
+	}
+
+	inline void StorageClass::Setup_Replica(const std::string &Connector, const std::string &DB,
+											const std::string &ConnectionStr) {
+		int NumSessions = (int)std::strtol(ReplicaSetting(DB, "maxsessions").c_str(), nullptr, 10);
+		int IdleTime = (int)std::strtol(ReplicaSetting(DB, "idletime").c_str(), nullptr, 10);
+		ReadPool_ = std::make_shared<Poco::Data::SessionPool>(
+			Connector, ConnectionStr, 8, NumSessions > 0 ? NumSessions : 64,
+			IdleTime > 0 ? IdleTime : 60);
+		ReadRouting::SetStickiness(
+			std::chrono::seconds(MicroServiceConfigGetInt("storage.replica.stickiness", 5)));
+		ReadRouting::SetReplica(Pool_.get(), ReadPool_.get());
+		Logger().notice(fmt::format("Reads go to the {} replica at {}.", DB,
+									ReplicaSetting(DB, "host")));
+	}
 #endif
 
 } // namespace OpenWifi
@@ -2,6 +2,7 @@
 // Created by stephane bourque on 2022-10-25.
 //
 
+#include <algorithm>
 #include <mutex>
 
 #include "Poco/JSON/JSONException.h"
@@ -27,8 +28,8 @@ namespace OpenWifi {
 	void UI_WebSocketClientServer::NewClient(Poco::Net::WebSocket &WS, const std::string &Id,
 											 const std::string &UserName, std::uint64_t TID) {
 
-		std::lock_guard G(LocalMutex_);
-		auto Client = std::make_unique<UI_WebSocketClientInfo>(WS, Id, UserName);
+		std::unique_lock G(LocalMutex_);
+		auto Client = std::make_shared<UI_WebSocketClientInfo>(WS, Id, UserName);
 		auto ClientSocket = Client->WS_->impl()->sockfd();
 		TID_ = TID;
 		Client->WS_->setNoDelay(true);
@@ -61,39 +62,76 @@ namespace OpenWifi {
 			if(!Poco::Thread::trySleep(2000)) {
                 break;
             }
-			std::lock_guard G(LocalMutex_);
+			std::unique_lock G(LocalMutex_);
 			for (const auto i : ToBeRemoved_) {
 				// std::cout << "Erasing old WS UI connection..." << std::endl;
-				Clients_.erase(i);
+				auto Client = Clients_.find(i);
+				if (Client != Clients_.end() && Client->second->Closed_)
+					Clients_.erase(Client);
 			}
 			ToBeRemoved_.clear();
 			UsersConnected_ = Clients_.size();
 		}
 	}
 
-	void UI_WebSocketClientServer::EndConnection(ClientList::iterator Client) {
-		if (Client->second->SocketRegistered_) {
-			Client->second->SocketRegistered_ = false;
+	void UI_WebSocketClientServer::EndConnection(int ClientSocket, const ClientPtr &Client) {
+		std::unique_lock G(LocalMutex_);
+		if (Client->Closed_.exchange(true))
+			return;
+		if (Client->SocketRegistered_) {
+			Client->SocketRegistered_ = false;
 			Reactor_.removeEventHandler(
-				*Client->second->WS_,
+				*Client->WS_,
 				Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ReadableNotification>(
 					*this, &UI_WebSocketClientServer::OnSocketReadable));
 			Reactor_.removeEventHandler(
-				*Client->second->WS_,
+				*Client->WS_,
 				Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ShutdownNotification>(
 					*this, &UI_WebSocketClientServer::OnSocketShutdown));
 			Reactor_.removeEventHandler(
-				*Client->second->WS_,
+				*Client->WS_,
 				Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ErrorNotification>(
 					*this, &UI_WebSocketClientServer::OnSocketError));
 		}
-		ToBeRemoved_.push_back(Client);
+		UnIndexUser(Client);
+		ToBeRemoved_.push_back(ClientSocket);
+	}
+
+	UI_WebSocketClientServer::ClientPtr UI_WebSocketClientServer::FindWSClient(int ClientSocket) {
+		std::shared_lock G(LocalMutex_);
+		auto Client = Clients_.find(ClientSocket);
+		if (Client == end(Clients_) || Client->second->Closed_)
+			return nullptr;
+		return Client->second;
+	}
+
+	//	Users_ only holds authenticated sessions; callers hold LocalMutex_ exclusively.
+	void UI_WebSocketClientServer::IndexUser(const ClientPtr &Client) {
+		Users_[Client->UserName_].push_back(Client);
+	}
+
+	void UI_WebSocketClientServer::UnIndexUser(const ClientPtr &Client) {
+		auto User = Users_.find(Client->UserName_);
+		if (User == Users_.end())
+			return;
+		auto &Sessions = User->second;
+		Sessions.erase(std::remove(Sessions.begin(), Sessions.end(), Client), Sessions.end());
+		if (Sessions.empty())
+			Users_.erase(User);
 	}
 
 	int UI_WebSocketClientServer::Start() {
 		poco_information(Logger(), "Starting...");
 		GoogleApiKey_ = MicroServiceConfigGetString("google.apikey", "");
 		GeoCodeEnabled_ = !GoogleApiKey_.empty();
+		MaxQueue_ = MicroServiceConfigGetInt("websocketclients.maxqueue", 256);
+		SendTimeout_ =
+			Poco::Timespan(MicroServiceConfigGetInt("websocketclients.sendtimeout", 5), 0);
+		Sending_ = true;
+		auto Senders =
+			std::max<std::uint64_t>(1, MicroServiceConfigGetInt("websocketclients.senders", 4));
+		for (std::uint64_t i = 0; i < Senders; ++i)
+			SenderThreads_.emplace_back([this] { Sender(); });
 		ReactorThread_.start(Reactor_);
 		ReactorThread_.setName("ws:ui-reactor");
 		CleanerThread_.start(*this);
@@ -104,9 +142,22 @@ namespace OpenWifi {
 	void UI_WebSocketClientServer::Stop() {
 		if (Running_) {
 			poco_information(Logger(), "Stopping...");
-			Clients_.clear();
 			Reactor_.stop();
 			ReactorThread_.join();
+			{
+				std::lock_guard G(ReadyMutex_);
+				Sending_ = false;
+			}
+			ReadyCV_.notify_all();
+			for (auto &Sender : SenderThreads_)
+				if (Sender.joinable())
+					Sender.join();
+			SenderThreads_.clear();
+			{
+				std::unique_lock G(LocalMutex_);
+				Users_.clear();
+				Clients_.clear();
+			}
 			Running_ = false;
 			CleanerThread_.wakeUp();
 			CleanerThread_.join();
@@ -121,40 +172,136 @@ namespace OpenWifi {
 
 	bool UI_WebSocketClientServer::SendToUser(const std::string &UserName, std::uint64_t id,
 											  const std::string &Payload) {
-		std::lock_guard G(LocalMutex_);
-
-		for (const auto &Client : Clients_) {
-			if (Client.second->UserName_ == UserName) {
-				try {
-					if (!IsFiltered(id, *Client.second) && Client.second->Authenticated_) {
-						return Client.second->WS_->sendFrame(
-								   Payload.c_str(), (int)Payload.size()) == (int)Payload.size();
-					} else {
-						return false;
-					}
-				} catch (...) {
-					return false;
+		return SendToUser(UserName, id, std::make_shared<const std::string>(Payload));
+	}
+
+	void UI_WebSocketClientServer::SendToAll(std::uint64_t id, const std::string &Payload) {
+		SendToAll(id, std::make_shared<const std::string>(Payload));
+	}
+
+	bool UI_WebSocketClientServer::SendToUser(const std::string &UserName, std::uint64_t id,
+											  const std::shared_ptr<const std::string> &Payload) {
+		std::vector<ClientPtr> Recipients;
+		{
+			std::shared_lock G(LocalMutex_);
+			auto User = Users_.find(UserName);
+			if (User == Users_.end())
+				return false;
+			for (const auto &Client : User->second) {
+				if (!IsFiltered(id, *Client))
+					Recipients.push_back(Client);
+			}
+		}
+		for (const auto &Client : Recipients)
+			Enqueue(Client, Payload);
+		return !Recipients.empty();
+	}
+
+	void UI_WebSocketClientServer::SendToAll(std::uint64_t id,
+											 const std::shared_ptr<const std::string> &Payload) {
+		std::vector<ClientPtr> Recipients;
+		{
+			std::shared_lock G(LocalMutex_);
+			Recipients.reserve(Clients_.size());
+			for (const auto &[_, Sessions] : Users_) {
+				for (const auto &Client : Sessions) {
+					if (!IsFiltered(id, *Client))
+						Recipients.push_back(Client);
 				}
 			}
 		}
-		return false;
+		for (const auto &Client : Recipients)
+			Enqueue(Client, Payload);
 	}
 
-	void UI_WebSocketClientServer::SendToAll(std::uint64_t id, const std::string &Payload) {
-		std::lock_guard G(LocalMutex_);
+	void UI_WebSocketClientServer::Enqueue(const ClientPtr &Client,
+										   const std::shared_ptr<const std::string> &Payload) {
+		{
+			std::lock_guard G(Client->QueueMutex_);
+			if (Client->Closed_)
+				return;
+			if (Client->SendQueue_.size() >= MaxQueue_) {
+				Client->SendQueue_.pop_front();
+				if ((Client->Dropped_++ % 100) == 0)
+					poco_warning(Logger(),
+								 fmt::format("SLOW-CLIENT({}): {} dropping notifications.",
+											 Client->Id_, Client->UserName_));
+			}
+			Client->SendQueue_.push_back(Payload);
+			if (Client->Scheduled_)
+				return;
+			Client->Scheduled_ = true;
+		}
+		{
+			std::lock_guard G(ReadyMutex_);
+			Ready_.push_back(Client);
+		}
+		ReadyCV_.notify_one();
+	}
+
+	//	Each turn writes one frame of one client, then puts the client back at the end of the
+	//	line if it has more, so the senders go round the busy clients.
+	void UI_WebSocketClientServer::Sender() {
+		Utils::SetThreadName("ws:ui-sender");
+		while (true) {
+			ClientPtr Client;
+			{
+				std::unique_lock G(ReadyMutex_);
+				ReadyCV_.wait(G, [this] { return !Sending_ || !Ready_.empty(); });
+				if (!Sending_)
+					return;
+				Client = std::move(Ready_.front());
+				Ready_.pop_front();
+			}
 
-		for (const auto &Client : Clients_) {
-			try {
-				if (!IsFiltered(id, *Client.second) && Client.second->Authenticated_)
-					Client.second->WS_->sendFrame(Payload.c_str(), (int)Payload.size());
-			} catch (...) {
+			if (!SendOne(Client)) {
+				{
+					std::lock_guard G(Client->QueueMutex_);
+					Client->SendQueue_.clear();
+					Client->Scheduled_ = false;
+				}
+				EndConnection(Client->WS_->impl()->sockfd(), Client);
+				continue;
+			}
+
+			{
+				std::lock_guard G(Client->QueueMutex_);
+				if (Client->SendQueue_.empty() || Client->Closed_) {
+					Client->Scheduled_ = false;
+					continue;
+				}
+			}
+			{
+				std::lock_guard G(ReadyMutex_);
+				Ready_.push_back(Client);
 			}
+			ReadyCV_.notify_one();
 		}
 	}
 
-	UI_WebSocketClientServer::ClientList::iterator UI_WebSocketClientServer::FindWSClient(
-		[[maybe_unused]] std::lock_guard<std::recursive_mutex> &G, int ClientSocket) {
-		return Clients_.find(ClientSocket);
+	//	The socket is non-blocking: a client that cannot take a frame within the send timeout,
+	//	or takes only part of one, is stuck and gets disconnected.
+	bool UI_WebSocketClientServer::SendOne(const ClientPtr &Client) {
+		std::shared_ptr<const std::string> Frame;
+		{
+			std::lock_guard G(Client->QueueMutex_);
+			if (Client->SendQueue_.empty() || Client->Closed_)
+				return true;
+			Frame = std::move(Client->SendQueue_.front());
+			Client->SendQueue_.pop_front();
+		}
+		try {
+			std::lock_guard G(Client->SendMutex_);
+			if (!Client->WS_->poll(SendTimeout_, Poco::Net::Socket::SELECT_WRITE)) {
+				poco_warning(Logger(), fmt::format("SLOW-CLIENT({}): {} send timed out.",
+												   Client->Id_, Client->UserName_));
+				return false;
+			}
+			return Client->WS_->sendFrame(Frame->c_str(), (int)Frame->size()) ==
+				   (int)Frame->size();
+		} catch (...) {
+			return false;
+		}
 	}
 
 	void UI_WebSocketClientServer::SortNotifications() {
@@ -185,56 +332,55 @@ namespace OpenWifi {
 
 	void UI_WebSocketClientServer::OnSocketError(
 		[[maybe_unused]] const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf) {
-		std::lock_guard G(LocalMutex_);
-		auto Client = Clients_.find(pNf->socket().impl()->sockfd());
-		if (Client == end(Clients_))
+		auto ClientSocket = pNf->socket().impl()->sockfd();
+		auto Client = FindWSClient(ClientSocket);
+		if (Client == nullptr)
 			return;
-		EndConnection(Client);
+		EndConnection(ClientSocket, Client);
 	}
 
 	void UI_WebSocketClientServer::OnSocketReadable(
 		[[maybe_unused]] const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf) {
 
-		UI_WebSocketClientServer::ClientList::iterator Client;
-		std::lock_guard G(LocalMutex_);
+		auto ClientSocket = pNf->socket().impl()->sockfd();
+		auto Client = FindWSClient(ClientSocket);
+		if (Client == nullptr)
+			return;
 
 		try {
 
-			Client = Clients_.find(pNf->socket().impl()->sockfd());
-			if (Client == end(Clients_))
-				return;
-
 			Poco::Buffer<char> IncomingFrame(0);
 			int flags;
 			int n;
-			n = Client->second->WS_->receiveFrame(IncomingFrame, flags);
+			n = Client->WS_->receiveFrame(IncomingFrame, flags);
 			auto Op = flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
 
 			if (n == 0) {
 				poco_debug(Logger(),
 						   fmt::format("CLOSE({}): {} UI Client is closing WS connection.",
-									   Client->second->Id_, Client->second->UserName_));
-				return EndConnection(Client);
+									   Client->Id_, Client->UserName_));
+				return EndConnection(ClientSocket, Client);
 			}
 
 			switch (Op) {
 			case Poco::Net::WebSocket::FRAME_OP_PING: {
-				Client->second->WS_->sendFrame("", 0,
-											   (int)Poco::Net::WebSocket::FRAME_OP_PONG |
-												   (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+				std::lock_guard G(Client->SendMutex_);
+				Client->WS_->sendFrame("", 0,
+									   (int)Poco::Net::WebSocket::FRAME_OP_PONG |
+										   (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
 			} break;
 			case Poco::Net::WebSocket::FRAME_OP_PONG: {
 			} break;
 			case Poco::Net::WebSocket::FRAME_OP_CLOSE: {
 				poco_debug(Logger(),
 						   fmt::format("CLOSE({}): {} UI Client is closing WS connection.",
-									   Client->second->Id_, Client->second->UserName_));
-				return EndConnection(Client);
+									   Client->Id_, Client->UserName_));
+				return EndConnection(ClientSocket, Client);
 			} break;
 			case Poco::Net::WebSocket::FRAME_OP_TEXT: {
 				constexpr const char *DropMessagesCommand = "drop-notifications";
 				IncomingFrame.append(0);
-				if (!Client->second->Authenticated_) {
+				if (!Client->Authenticated_) {
 					std::string Frame{IncomingFrame.begin()};
 					auto Tokens = Utils::Split(Frame, ':');
 					bool Expired = false;
@@ -243,30 +389,33 @@ namespace OpenWifi {
 #endif
 					if (Tokens.size() == 2 &&
 #if defined(TIP_SECURITY_SERVICE)
-						AuthService()->IsAuthorized(Tokens[1], Client->second->UserInfo_, TID_,
+						AuthService()->IsAuthorized(Tokens[1], Client->UserInfo_, TID_,
 													Expired)) {
 #else
-						AuthClient()->IsAuthorized(Tokens[1], Client->second->UserInfo_, TID_,
+						AuthClient()->IsAuthorized(Tokens[1], Client->UserInfo_, TID_,
 												   Expired, Contacted)) {
 #endif
-						Client->second->Authenticated_ = true;
-						Client->second->UserName_ = Client->second->UserInfo_.userinfo.email;
-						poco_debug(Logger(),
-								   fmt::format("START({}): {} UI Client is starting WS connection.",
-											   Client->second->Id_, Client->second->UserName_));
 						auto WelcomeMessage = NotificationTypesJSON_;
 						WelcomeMessage.set("success", "Welcome! Bienvenue! Bienvenidos!");
 						std::ostringstream OS;
 						WelcomeMessage.stringify(OS);
-						Client->second->WS_->sendFrame(OS.str().c_str(), (int)OS.str().size());
-						Client->second->UserName_ = Client->second->UserInfo_.userinfo.email;
+						Client->Send(OS.str().c_str(), (int)OS.str().size());
+						{
+							std::unique_lock G(LocalMutex_);
+							Client->Authenticated_ = true;
+							Client->UserName_ = Client->UserInfo_.userinfo.email;
+							IndexUser(Client);
+						}
+						poco_debug(Logger(),
+								   fmt::format("START({}): {} UI Client is starting WS connection.",
+											   Client->Id_, Client->UserName_));
 					} else {
 						Poco::JSON::Object WelcomeMessage;
 						WelcomeMessage.set("error", "Invalid token. Closing connection.");
 						std::ostringstream OS;
 						WelcomeMessage.stringify(OS);
-						Client->second->WS_->sendFrame(OS.str().c_str(), (int)OS.str().size());
-						return EndConnection(Client);
+						Client->Send(OS.str().c_str(), (int)OS.str().size());
+						return EndConnection(ClientSocket, Client);
 					}
 				} else {
 					Poco::JSON::Parser P;
@@ -274,11 +423,13 @@ namespace OpenWifi {
 
 					if (Obj->has(DropMessagesCommand) && Obj->isArray(DropMessagesCommand)) {
 						auto Filters = Obj->getArray(DropMessagesCommand);
-						Client->second->Filter_.clear();
-						for (const auto &Filter : *Filters) {
-							Client->second->Filter_.emplace_back((std::uint64_t)Filter);
+						std::vector<std::uint64_t> Filter;
+						for (const auto &Entry : *Filters) {
+							Filter.emplace_back((std::uint64_t)Entry);
 						}
-						std::sort(begin(Client->second->Filter_), end(Client->second->Filter_));
+						std::sort(begin(Filter), end(Filter));
+						std::unique_lock G(LocalMutex_);
+						Client->Filter_ = std::move(Filter);
 						return;
 					}
 
@@ -286,16 +437,16 @@ namespace OpenWifi {
 					bool CloseConnection = false;
 					if (Processor_ != nullptr) {
 						Processor_->Processor(Obj, Answer, CloseConnection,
-											  Client->second->UserInfo_.userinfo);
+											  Client->UserInfo_.userinfo);
 					}
 					if (!Answer.empty())
-						Client->second->WS_->sendFrame(Answer.c_str(), (int)Answer.size());
+						Client->Send(Answer.c_str(), (int)Answer.size());
 					else {
-						Client->second->WS_->sendFrame("{}", 2);
+						Client->Send("{}", 2);
 					}
 
 					if (CloseConnection) {
-						return EndConnection(Client);
+						return EndConnection(ClientSocket, Client);
 					}
 				}
 			} break;
@@ -303,18 +454,18 @@ namespace OpenWifi {
 			}
 			}
 		} catch (...) {
-			return EndConnection(Client);
+			return EndConnection(ClientSocket, Client);
 		}
 	}
 
 	void UI_WebSocketClientServer::OnSocketShutdown(
 		[[maybe_unused]] const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf) {
 		try {
-			std::lock_guard G(LocalMutex_);
-			auto Client = Clients_.find(pNf->socket().impl()->sockfd());
-			if (Client == end(Clients_))
+			auto ClientSocket = pNf->socket().impl()->sockfd();
+			auto Client = FindWSClient(ClientSocket);
+			if (Client == nullptr)
 				return;
-			EndConnection(Client);
+			EndConnection(ClientSocket, Client);
 		} catch (...) {
 		}
 	}
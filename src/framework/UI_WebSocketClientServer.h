@@ -4,14 +4,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Poco/JSON/Object.h"
 #include "Poco/Net/SocketNotification.h"
 #include "Poco/Net/SocketReactor.h"
 #include "Poco/Net/WebSocket.h"
 #include "Poco/Runnable.h"
+#include "Poco/Timespan.h"
 
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "framework/SubSystemServer.h"
@@ -36,12 +44,27 @@ namespace OpenWifi {
 		std::vector<std::uint64_t> Filter_;
 		SecurityObjects::UserInfoAndPolicy UserInfo_;
 
+		//	Outgoing frames. Notifications are queued here under QueueMutex_ and written one at a
+		//	time by the sender threads, so queuing never waits on the socket. SendMutex_ only
+		//	keeps frames written to the socket from interleaving.
+		std::mutex QueueMutex_;
+		std::mutex SendMutex_;
+		std::deque<std::shared_ptr<const std::string>> SendQueue_;
+		bool Scheduled_ = false;
+		std::atomic_bool Closed_ = false;
+		std::uint64_t Dropped_ = 0;
+
 		UI_WebSocketClientInfo(Poco::Net::WebSocket &WS, const std::string &Id,
 							   const std::string &username) {
 			WS_ = std::make_unique<Poco::Net::WebSocket>(WS);
 			Id_ = Id;
 			UserName_ = username;
 		}
+
+		inline bool Send(const char *Frame, int Size) {
+			std::lock_guard G(SendMutex_);
+			return WS_->sendFrame(Frame, Size) == Size;
+		}
 	};
 
 	class UI_WebSocketClientServer : public SubSystemServer, Poco::Runnable {
@@ -67,37 +90,32 @@ namespace OpenWifi {
 		template <typename T>
 		bool SendUserNotification(const std::string &userName,
 								  const WebSocketNotification<T> &Notification) {
-
-			Poco::JSON::Object Payload;
-			Notification.to_json(Payload);
-			Poco::JSON::Object Msg;
-			Msg.set("notification", Payload);
-			std::ostringstream OO;
-			Msg.stringify(OO);
-
-			return SendToUser(userName, Notification.type_id, OO.str());
+			if (!UsersConnected_)
+				return false;
+			return SendToUser(userName, Notification.type_id, Serialize(Notification));
 		}
 
 		template <typename T> void SendNotification(const WebSocketNotification<T> &Notification) {
-			Poco::JSON::Object Payload;
-			Notification.to_json(Payload);
-			Poco::JSON::Object Msg;
-			Msg.set("notification", Payload);
-			std::ostringstream OO;
-			Msg.stringify(OO);
-			SendToAll(Notification.type_id, OO.str());
+			if (!UsersConnected_)
+				return;
+			SendToAll(Notification.type_id, Serialize(Notification));
 		}
 
 		[[nodiscard]] bool SendToUser(const std::string &userName, std::uint64_t id,
 									  const std::string &Payload);
 		void SendToAll(std::uint64_t id, const std::string &Payload);
+		//	The payload is shared by every recipient's queue rather than copied.
+		bool SendToUser(const std::string &userName, std::uint64_t id,
+						const std::shared_ptr<const std::string> &Payload);
+		void SendToAll(std::uint64_t id, const std::shared_ptr<const std::string> &Payload);
 
 		struct NotificationEntry {
 			std::uint64_t id = 0;
 			std::string helper;
 		};
 
-		using ClientList = std::map<int, std::unique_ptr<UI_WebSocketClientInfo>>;
+		using ClientPtr = std::shared_ptr<UI_WebSocketClientInfo>;
+		using ClientList = std::map<int, ClientPtr>;
 		using NotificationTypeIdVec = std::vector<NotificationEntry>;
 
 		void RegisterNotifications(const NotificationTypeIdVec &Notifications);
@@ -109,26 +127,50 @@ namespace OpenWifi {
 		Poco::Net::SocketReactor Reactor_;
 		Poco::Thread ReactorThread_;
 		Poco::Thread CleanerThread_;
-		std::recursive_mutex LocalMutex_;
+		std::shared_mutex LocalMutex_;
 		bool GeoCodeEnabled_ = false;
 		std::string GoogleApiKey_;
 		ClientList Clients_;
+		std::map<std::string, std::vector<ClientPtr>> Users_;
 		UI_WebSocketClientProcessor *Processor_ = nullptr;
 		NotificationTypeIdVec NotificationTypes_;
 		Poco::JSON::Object NotificationTypesJSON_;
-		std::vector<ClientList::iterator> ToBeRemoved_;
+		std::vector<int> ToBeRemoved_;
 		std::uint64_t TID_ = 0;
 
+		std::vector<std::thread> SenderThreads_;
+		std::mutex ReadyMutex_;
+		std::condition_variable ReadyCV_;
+		std::deque<ClientPtr> Ready_;
+		std::atomic_bool Sending_ = false;
+		std::size_t MaxQueue_ = 256;
+		Poco::Timespan SendTimeout_{5, 0};
+
 		UI_WebSocketClientServer() noexcept;
-		void EndConnection(ClientList::iterator Client);
+		void EndConnection(int ClientSocket, const ClientPtr &Client);
+		ClientPtr FindWSClient(int ClientSocket);
+		void IndexUser(const ClientPtr &Client);
+		void UnIndexUser(const ClientPtr &Client);
+		void Enqueue(const ClientPtr &Client, const std::shared_ptr<const std::string> &Payload);
+		void Sender();
+		bool SendOne(const ClientPtr &Client);
+
+		template <typename T>
+		static std::shared_ptr<const std::string>
+		Serialize(const WebSocketNotification<T> &Notification) {
+			Poco::JSON::Object Payload;
+			Notification.to_json(Payload);
+			Poco::JSON::Object Msg;
+			Msg.set("notification", Payload);
+			std::ostringstream OO;
+			Msg.stringify(OO);
+			return std::make_shared<const std::string>(OO.str());
+		}
 
 		void OnSocketReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf);
 		void OnSocketShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf);
 		void OnSocketError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf);
 
-		ClientList::iterator FindWSClient(std::lock_guard<std::recursive_mutex> &G,
-										  int ClientSocket);
-
 		void SortNotifications();
 	};
 
@@ -9,13 +9,19 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "Poco/Base64Decoder.h"
+#include "Poco/Base64Encoder.h"
 #include "Poco/Data/RecordSet.h"
 #include "Poco/Data/SQLite/Connector.h"
 #include "Poco/Data/SessionPool.h"
@@ -24,6 +30,10 @@
 #include "Poco/StringTokenizer.h"
 #include "Poco/Tuple.h"
 #include "StorageClass.h"
+#include "framework/MetricsRegistry.h"
+#include "framework/ReadRouting.h"
+#include "framework/SQLiteWriter.h"
+#include "framework/utils.h"
 
 #include "fmt/format.h"
 
@@ -189,6 +199,15 @@ namespace ORM {
 
 	inline std::string to_string(const char *S) { return S; }
 
+	//	Counts the writes to the table of each record type in this process. It starts at the
+	//	start time so that counts from an earlier run are not reused.
+	template <typename RecordType> struct TableVersion {
+		static inline std::atomic_uint64_t Value{static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::system_clock::now().time_since_epoch())
+				.count())};
+	};
+
 	template <typename RecordType> class DBCache {
 	  public:
 		DBCache(unsigned Size, unsigned Timeout) : Size_(Size), Timeout_(Timeout) {}
@@ -196,6 +215,8 @@ namespace ORM {
 		virtual bool GetFromCache(const std::string &FieldName, const std::string &Value,
 								  RecordType &R) = 0;
 		virtual void UpdateCache(const RecordType &R) = 0;
+		//	A record was written by UpdateRecord, as opposed to read.
+		virtual void Updated(const RecordType &R) { UpdateCache(R); }
 		virtual void Delete(const std::string &FieldName, const std::string &Value) = 0;
 
 	  private:
@@ -211,9 +232,20 @@ namespace ORM {
 		   const IndexVec &Indexes, Poco::Data::SessionPool &Pool, Poco::Logger &L,
 		   const char *Prefix, DBCache<RecordType> *Cache = nullptr)
 			: TableName_(TableName), Type_(dbtype), Pool_(Pool), Logger_(L), Prefix_(Prefix),
-			  Cache_(Cache) {
+			  Cache_(Cache), ReadReplica_(OpenWifi::ReadRouting::ReplicaOf(&Pool)),
+			  Writer_(OpenWifi::SQLiteWriter::For(&Pool)) {
 			assert(RecordTuple::length == Fields.size());
 
+			auto QueryTime = [&](const char *Op) {
+				return &OpenWifi::MetricsRegistry()->Histogram(
+					"owprov_db_query_duration_seconds", "Time spent in database statements.",
+					{{"table", TableName_}, {"op", Op}});
+			};
+			SelectTime_ = QueryTime("select");
+			InsertTime_ = QueryTime("insert");
+			UpdateTime_ = QueryTime("update");
+			DeleteTime_ = QueryTime("delete");
+
 			bool first = true;
 			int Place = 0;
 
@@ -362,13 +394,14 @@ namespace ORM {
 
 			case OpenWifi::DBType::sqlite: {
 				try {
-					Poco::Data::Session Session = Pool_.get();
-					std::string Statement =
-						"create table if not exists " + TableName_ + " ( " + CreateFields_ + " )";
-					Session << Statement, Poco::Data::Keywords::now;
-					for (const auto &i : IndexCreation_) {
-						Session << i, Poco::Data::Keywords::now;
-					}
+					Write([this](Poco::Data::Session &Session) {
+						std::string Statement = "create table if not exists " + TableName_ +
+												" ( " + CreateFields_ + " )";
+						Session << Statement, Poco::Data::Keywords::now;
+						for (const auto &i : IndexCreation_) {
+							Session << i, Poco::Data::Keywords::now;
+						}
+					});
 				} catch (const Poco::Exception &E) {
 					Logger_.error("Failure to create SQLITE DB resources.");
 					Logger_.log(E);
@@ -418,16 +451,17 @@ namespace ORM {
 		inline const std::string &Prefix() { return Prefix_; };
 
 		bool CreateRecord(const RecordType &R) {
+			OpenWifi::MetricsTimer Timer(*InsertTime_);
 			try {
-				Poco::Data::Session Session = Pool_.get();
-				Poco::Data::Statement Insert(Session);
-
 				RecordTuple RT;
 				Convert(R, RT);
 				std::string St = "insert into  " + TableName_ + " ( " + SelectFields_ +
 								 " ) values " + SelectList_;
-				Insert << ConvertParams(St), Poco::Data::Keywords::use(RT);
-				Insert.execute();
+				Write([&](Poco::Data::Session &Session) {
+					Poco::Data::Statement Insert(Session);
+					Insert << ConvertParams(St), Poco::Data::Keywords::use(RT);
+					Insert.execute();
+				});
 
 				if (Cache_)
 					Cache_->Create(R);
@@ -449,7 +483,8 @@ namespace ORM {
 						return true;
 				}
 
-				Poco::Data::Session Session = Pool_.get();
+				OpenWifi::MetricsTimer Timer(*SelectTime_);
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -475,8 +510,9 @@ namespace ORM {
 		}
 
 		bool GetRecord(RecordType &T, const std::string &WhereClause) {
+			OpenWifi::MetricsTimer Timer(*SelectTime_);
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -506,7 +542,7 @@ namespace ORM {
 
 				assert(ValidFieldName(FieldName));
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -528,7 +564,7 @@ namespace ORM {
 
 		template <typename T> bool Join(const std::string &statement, std::vector<T> &records) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 
 				Select << statement, Poco::Data::Keywords::into(records);
@@ -546,8 +582,9 @@ namespace ORM {
 
 		bool GetRecords(uint64_t Offset, uint64_t HowMany, RecordVec &Records,
 						const std::string &Where = "", const std::string &OrderBy = "") {
+			OpenWifi::MetricsTimer Timer(*SelectTime_);
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 				RecordList RL;
 				std::string St = "select " + SelectFields_ + " from " + TableName_ +
@@ -572,14 +609,123 @@ namespace ORM {
 			return false;
 		}
 
+		//	Inserts Records in one transaction: all of them or none.
+		bool CreateRecords(const RecordVec &Records) {
+			if (Records.empty())
+				return true;
+			OpenWifi::MetricsTimer Timer(*InsertTime_);
+			try {
+				RecordList RL(Records.size());
+				for (std::size_t i = 0; i < Records.size(); ++i)
+					Convert(Records[i], RL[i]);
+				std::string St = "insert into  " + TableName_ + " ( " + SelectFields_ +
+								 " ) values " + SelectList_;
+				Write(
+					[&](Poco::Data::Session &Session) {
+						Poco::Data::Statement Insert(Session);
+						Insert << ConvertParams(St), Poco::Data::Keywords::use(RL);
+						Insert.execute();
+					},
+					true);
+
+				if (Cache_) {
+					for (const auto &R : Records)
+						Cache_->Create(R);
+				}
+				return true;
+			} catch (const Poco::Exception &E) {
+				Logger_.log(E);
+			}
+			return false;
+		}
+
+		//	Keyset paging: up to HowMany records with KeyField greater than After, in KeyField
+		//	order. Unlike an OFFSET, the cost does not grow with the position in the table.
+		bool GetRecordsAfter(field_name_t KeyField, const std::string &After, uint64_t HowMany,
+							 RecordVec &Records, const std::string &Where = "") {
+			OpenWifi::MetricsTimer Timer(*SelectTime_);
+			try {
+				assert(ValidFieldName(KeyField));
+				Poco::Data::Session Session = ReadPool().get();
+				Poco::Data::Statement Select(Session);
+				RecordList RL;
+				std::string St = "select " + SelectFields_ + " from " + TableName_ + " where " +
+								 (Where.empty() ? "" : "(" + Where + ") and ") + KeyField +
+								 ">? order by " + KeyField + " ASC" + ComputeRange(0, HowMany);
+				auto tAfter{After};
+
+				Select << ConvertParams(St), Poco::Data::Keywords::into(RL),
+					Poco::Data::Keywords::use(tAfter);
+				Select.execute();
+
+				for (auto &i : RL) {
+					RecordType R;
+					Convert(i, R);
+					Records.emplace_back(std::move(R));
+				}
+				return !RL.empty();
+			} catch (const Poco::Exception &E) {
+				Logger_.log(E);
+			}
+			return false;
+		}
+
+		//	Cursor paging for the list endpoints, in id order. The cursor is opaque to clients: it
+		//	holds the id of the last record sent. An empty Cursor asks for the first page, and
+		//	NextCursor comes back empty after the last one. Returns false for a cursor that this
+		//	table did not issue.
+		bool GetRecordsPage(const std::string &Cursor, uint64_t HowMany, RecordVec &Records,
+							std::string &NextCursor, const std::string &Where = "") {
+			std::string After;
+			if (!Cursor.empty() && !DecodeCursor(Cursor, After))
+				return false;
+			NextCursor.clear();
+			if (GetRecordsAfter("id", After, HowMany, Records, Where) && Records.size() == HowMany)
+				NextCursor = EncodeCursor(Records.back().info.id);
+			return true;
+		}
+
+		//	Fetches every record whose FieldName is one of Values, BatchSize values per query. All
+		//	the matches are returned, however many there are per value, in the order of the
+		//	queries' results.
+		template <typename Container>
+		bool GetRecordsIn(field_name_t FieldName, const Container &Values, RecordVec &Records,
+						  std::size_t BatchSize = 500) {
+			assert(ValidFieldName(FieldName));
+			OpenWifi::MetricsTimer Timer(*SelectTime_);
+			auto it = Values.begin();
+			while (it != Values.end()) {
+				std::string InList;
+				for (std::size_t n = 0; n < BatchSize && it != Values.end(); ++n, ++it) {
+					if (!InList.empty())
+						InList += ",";
+					InList += "'" + Escape(*it) + "'";
+				}
+				try {
+					Poco::Data::Session Session = ReadPool().get();
+					Poco::Data::Statement Select(Session);
+					RecordList RL;
+					std::string St = "select " + SelectFields_ + " from " + TableName_ + " where " +
+									 FieldName + " in (" + InList + ")";
+					Select << St, Poco::Data::Keywords::into(RL);
+					Select.execute();
+					for (auto &i : RL) {
+						RecordType R;
+						Convert(i, R);
+						Records.emplace_back(std::move(R));
+					}
+				} catch (const Poco::Exception &E) {
+					Logger_.log(E);
+				}
+			}
+			return !Records.empty();
+		}
+
 		template <typename T>
 		bool UpdateRecord(field_name_t FieldName, const T &Value, const RecordType &R) {
+			OpenWifi::MetricsTimer Timer(*UpdateTime_);
 			try {
 				assert(ValidFieldName(FieldName));
-				Poco::Data::Session Session = Pool_.get();
-                Session.begin();
-				Poco::Data::Statement Update(Session);
-
 				RecordTuple RT;
 
 				Convert(R, RT);
@@ -588,12 +734,16 @@ namespace ORM {
 
 				std::string St =
 					"update " + TableName_ + " set " + UpdateFields_ + " where " + FieldName + "=?";
-				Update << ConvertParams(St), Poco::Data::Keywords::use(RT),
-					Poco::Data::Keywords::use(tValue);
-				Update.execute();
+				Write(
+					[&](Poco::Data::Session &Session) {
+						Poco::Data::Statement Update(Session);
+						Update << ConvertParams(St), Poco::Data::Keywords::use(RT),
+							Poco::Data::Keywords::use(tValue);
+						Update.execute();
+					},
+					true);
 				if (Cache_)
-					Cache_->UpdateCache(R);
-                Session.commit();
+					Cache_->Updated(R);
 				return true;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
@@ -603,12 +753,12 @@ namespace ORM {
 
 		bool RunStatement(const std::string &St) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
-				Poco::Data::Statement Command(Session);
-
-				Command << St;
-				Command.execute();
+				Write([&St](Poco::Data::Session &Session) {
+					Poco::Data::Statement Command(Session);
 
+					Command << St;
+					Command.execute();
+				});
 				return true;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
@@ -618,6 +768,7 @@ namespace ORM {
 
 		template <typename T>
 		bool ReplaceRecord(field_name_t FieldName, const T &Value, RecordType &R) {
+			OpenWifi::ReadRouting::Primary Reads;
 			try {
 				if (Exists(FieldName, Value)) {
 					return UpdateRecord(FieldName, Value, R);
@@ -634,7 +785,7 @@ namespace ORM {
 								   std::string &Description) {
 			try {
 				assert(ValidFieldName(FieldName));
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -659,21 +810,22 @@ namespace ORM {
 		}
 
 		template <typename T> bool DeleteRecord(field_name_t FieldName, const T &Value) {
+			OpenWifi::MetricsTimer Timer(*DeleteTime_);
 			try {
 				assert(ValidFieldName(FieldName));
 
-				Poco::Data::Session Session = Pool_.get();
-                Session.begin();
-				Poco::Data::Statement Delete(Session);
-
 				std::string St = "delete from " + TableName_ + " where " + FieldName + "=?";
 				auto tValue{Value};
 
-				Delete << ConvertParams(St), Poco::Data::Keywords::use(tValue);
-				Delete.execute();
+				Write(
+					[&](Poco::Data::Session &Session) {
+						Poco::Data::Statement Delete(Session);
+						Delete << ConvertParams(St), Poco::Data::Keywords::use(tValue);
+						Delete.execute();
+					},
+					true);
 				if (Cache_)
 					Cache_->Delete(FieldName, Value);
-                Session.commit();
 				return true;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
@@ -684,14 +836,14 @@ namespace ORM {
 		bool DeleteRecords(const std::string &WhereClause) {
 			try {
 				assert(!WhereClause.empty());
-				Poco::Data::Session Session = Pool_.get();
-                Session.begin();
-				Poco::Data::Statement Delete(Session);
-
 				std::string St = "delete from " + TableName_ + " where " + WhereClause;
-				Delete << St;
-				Delete.execute();
-                Session.commit();
+				Write(
+					[&](Poco::Data::Session &Session) {
+						Poco::Data::Statement Delete(Session);
+						Delete << St;
+						Delete.execute();
+					},
+					true);
 				return true;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
@@ -772,7 +924,7 @@ namespace ORM {
 			try {
 				uint64_t Cnt = 0;
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = ReadPool().get();
 				Poco::Data::Statement Select(Session);
 
 				std::string st{"SELECT COUNT(*) FROM " + TableName_ + " " +
@@ -792,6 +944,7 @@ namespace ORM {
 		template <typename X>
 		bool ManipulateVectorMember(X T, field_name_t FieldName, const std::string &ParentUUID,
 									const std::string &ChildUUID, bool Add) {
+			OpenWifi::ReadRouting::Primary Reads;
 			try {
 				assert(ValidFieldName(FieldName));
 
@@ -818,26 +971,51 @@ namespace ORM {
 			return false;
 		}
 
+		//	Adds many children with a single read and update of the parent.
+		template <typename X>
+		bool AddVectorMembers(X T, field_name_t FieldName, const std::string &ParentUUID,
+							  const std::vector<std::string> &ChildUUIDs) {
+			OpenWifi::ReadRouting::Primary Reads;
+			try {
+				assert(ValidFieldName(FieldName));
+
+				RecordType R;
+				if (GetRecord(FieldName, ParentUUID, R)) {
+					auto &Members = R.*T;
+					Members.insert(Members.end(), ChildUUIDs.begin(), ChildUUIDs.end());
+					std::sort(Members.begin(), Members.end());
+					Members.erase(std::unique(Members.begin(), Members.end()), Members.end());
+					return UpdateRecord(FieldName, ParentUUID, R);
+				}
+			} catch (const Poco::Exception &E) {
+				Logger_.log(E);
+			}
+			return false;
+		}
+
 		bool RunScript(const std::vector<std::string> &Statements, bool IgnoreExceptions = true) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
-				Poco::Data::Statement Command(Session);
-
-				for (const auto &i : Statements) {
-					try {
-						Command << i, Poco::Data::Keywords::now;
-					} catch (const Poco::Exception &E) {
-						// Logger_.log(E);
-						// Logger_.error(Poco::format("The following statement '%s' generated an
-						// exception during a table upgrade. This may or may not be a problem.",
-						// i));
-						if (!IgnoreExceptions) {
-							return false;
+				bool Completed = true;
+				Write([&](Poco::Data::Session &Session) {
+					Poco::Data::Statement Command(Session);
+
+					for (const auto &i : Statements) {
+						try {
+							Command << i, Poco::Data::Keywords::now;
+						} catch (const Poco::Exception &E) {
+							// Logger_.log(E);
+							// Logger_.error(Poco::format("The following statement '%s' generated an
+							// exception during a table upgrade. This may or may not be a problem.",
+							// i));
+							if (!IgnoreExceptions) {
+								Completed = false;
+								return;
+							}
 						}
+						Command.reset(Session);
 					}
-					Command.reset(Session);
-				}
-				return true;
+				});
+				return Completed;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
 			}
@@ -966,6 +1144,15 @@ namespace ORM {
 										  true);
 		}
 
+		inline bool AddInUse(field_name_t FieldName, const std::string &ParentUUID,
+							 const std::string &Prefix, const std::vector<std::string> &ChildUUIDs) {
+			std::vector<std::string> FakeUUIDs;
+			FakeUUIDs.reserve(ChildUUIDs.size());
+			for (const auto &i : ChildUUIDs)
+				FakeUUIDs.emplace_back(Prefix + ":" + i);
+			return AddVectorMembers(&RecordType::inUse, FieldName, ParentUUID, FakeUUIDs);
+		}
+
 		inline bool DeleteInUse(field_name_t FieldName, const std::string &ParentUUID,
 								const std::string &Prefix, const std::string &ChildUUID) {
 			std::string FakeUUID{Prefix + ":" + ChildUUID};
@@ -1012,6 +1199,52 @@ namespace ORM {
 
 		Poco::Logger &Logger() { return Logger_; }
 
+		[[nodiscard]] std::string EncodeCursor(const std::string &Key) const {
+			std::ostringstream OS;
+			Poco::Base64Encoder Encoder(OS, Poco::BASE64_URL_ENCODING | Poco::BASE64_NO_PADDING);
+			Encoder << TableName_ << ':' << Key;
+			Encoder.close();
+			return OS.str();
+		}
+
+		bool DecodeCursor(const std::string &Cursor, std::string &Key) const {
+			try {
+				std::istringstream IS(Cursor);
+				Poco::Base64Decoder Decoder(IS,
+											Poco::BASE64_URL_ENCODING | Poco::BASE64_NO_PADDING);
+				std::string Plain{std::istreambuf_iterator<char>(Decoder),
+								  std::istreambuf_iterator<char>()};
+				auto Prefix = TableName_ + ":";
+				if (Plain.rfind(Prefix, 0) != 0)
+					return false;
+				Key = Plain.substr(Prefix.size());
+				return true;
+			} catch (const Poco::Exception &) {
+			}
+			return false;
+		}
+
+		//	Where reads go: the replica, unless there is none or this thread reads from the primary.
+		Poco::Data::SessionPool &ReadPool() {
+			return ReadReplica_ && !OpenWifi::ReadRouting::PrimaryReads() ? *ReadReplica_ : Pool_;
+		}
+
+		//	Runs write statements on the SQLite writer when there is one (it commits them with
+		//	other writes), otherwise on a pooled session, in a transaction if asked.
+		template <typename Statements> void Write(Statements &&Run, bool Transaction = false) {
+			if (Writer_) {
+				Writer_->Write(std::forward<Statements>(Run));
+			} else {
+				Poco::Data::Session Session = Pool_.get();
+				if (Transaction)
+					Session.begin();
+				Run(Session);
+				if (Transaction)
+					Session.commit();
+			}
+			++TableVersion<RecordType>::Value;
+		}
+
 		inline bool DeleteRecordsFromCache(const char *FieldName, const std::string &Value) {
 			if (Cache_)
 				Cache_->Delete(FieldName, Value);
@@ -1030,6 +1263,12 @@ namespace ORM {
 		Poco::Logger &Logger_;
 		std::string Prefix_;
 		DBCache<RecordType> *Cache_ = nullptr;
+		Poco::Data::SessionPool *ReadReplica_ = nullptr;
+		OpenWifi::SQLiteWriter *Writer_ = nullptr;
+		OpenWifi::MetricsHistogram *SelectTime_ = nullptr;
+		OpenWifi::MetricsHistogram *InsertTime_ = nullptr;
+		OpenWifi::MetricsHistogram *UpdateTime_ = nullptr;
+		OpenWifi::MetricsHistogram *DeleteTime_ = nullptr;
 
 	  private:
 		std::string CreateFields_;
@@ -446,6 +446,9 @@ namespace OpenWifi::RESTAPI::Errors {
 	static const struct msg InvalidCreateObjectsRequest {
 		1201, "Invalid inline createObjects request."
 	};
+	static const struct msg InvalidCursor {
+		1202, "Invalid or expired pagination cursor."
+	};
 	static const struct msg FirstSubscriberDeviceMustBeOLG {
 		1194, "First subscriber device must have deviceGroup 'olg'."
 	};
@@ -498,6 +501,7 @@ namespace OpenWifi::RESTAPI::Protocol {
 	static const char *STARTDATE = "startDate";
 	static const char *ENDDATE = "endDate";
 	static const char *OFFSET = "offset";
+	static const char *CURSOR = "cursor";
 	static const char *LIMIT = "limit";
 	static const char *LIFETIME = "lifetime";
 	static const char *UUID = "UUID";
@@ -27,4 +27,22 @@ namespace OpenWifi::SDK::Analytics {
 		return Status == Poco::Net::HTTPResponse::HTTP_OK;
 	}
 
+	namespace Async {
+		std::future<OpenAPICallResult> StartMonitoring(const Poco::JSON::Object &Body) {
+			return OpenAPIAsync()->Submit([Body]() {
+				OpenAPICallResult R;
+				Analytics::StartMonitoring(Body, R.Response, R.Status);
+				return R;
+			});
+		}
+
+		std::future<OpenAPICallResult> StopMonitoring(const std::string &BoardId) {
+			return OpenAPIAsync()->Submit([BoardId]() {
+				OpenAPICallResult R;
+				Analytics::StopMonitoring(BoardId, R.Status);
+				return R;
+			});
+		}
+	} // namespace Async
+
 } // namespace OpenWifi::SDK::Analytics
@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <future>
+
 #include "Poco/JSON/Object.h"
 #include "Poco/Net/HTTPServerResponse.h"
+#include "framework/OpenAPIAsync.h"
 #include "framework/RESTAPI_Handler.h"
 
 namespace OpenWifi::SDK::Analytics {
@@ -16,4 +19,9 @@ namespace OpenWifi::SDK::Analytics {
 					 Poco::Net::HTTPServerResponse::HTTPStatus &Status);
 	bool StopMonitoring(const std::string &BoardId,
 						Poco::Net::HTTPServerResponse::HTTPStatus &Status);
+
+	namespace Async {
+		std::future<OpenAPICallResult> StartMonitoring(const Poco::JSON::Object &Body);
+		std::future<OpenAPICallResult> StopMonitoring(const std::string &BoardId);
+	} // namespace Async
 } // namespace OpenWifi::SDK::Analytics
@@ -7,6 +7,7 @@
 #include "RESTObjects/RESTAPI_FMSObjects.h"
 
 #include "framework/MicroServiceNames.h"
+#include "framework/OpenAPIAsync.h"
 #include "framework/OpenAPIRequests.h"
 
 namespace OpenWifi::SDK::FMS {
@@ -69,6 +70,101 @@ namespace OpenWifi::SDK::FMS {
 			return false;
 		}
 
+		template <typename Key, typename Fetch>
+		Resolver::Entry *Resolver::Lookup(std::map<Key, Entry> &Entries, const Key &K,
+										  std::unique_lock<std::mutex> &G, Fetch &&F) {
+			Entry *E;
+			{
+				std::lock_guard L(Mutex_);
+				E = &Entries[K];
+			}
+
+			G = std::unique_lock(E->Mutex);
+			auto Now = std::chrono::steady_clock::now();
+			if (E->Fetched && Now - E->FetchedAt < TTL_) {
+				Stats_.Hit();
+				return E;
+			}
+			Stats_.Miss();
+			std::vector<FMSObjects::Firmware> Firmwares;
+			if (!F(Firmwares))
+				return nullptr;
+			E->Firmwares = std::move(Firmwares);
+			E->ByRevision.clear();
+			for (std::size_t i = 0; i < E->Firmwares.size(); ++i)
+				E->ByRevision.emplace(E->Firmwares[i].revision, i);
+			E->Fetched = true;
+			E->FetchedAt = Now;
+			return E;
+		}
+
+		bool Resolver::GetFirmware(const std::string &device_type, const std::string &revision,
+								   FMSObjects::Firmware &Firmware) {
+			std::unique_lock<std::mutex> G;
+			auto E = Lookup(DeviceTypes_, device_type, G, [&](auto &Firmwares) {
+				return Firmware::GetDeviceTypeFirmwares(device_type, Firmwares);
+			});
+			if (E == nullptr)
+				return false;
+			auto hint = E->ByRevision.find(revision);
+			if (hint == E->ByRevision.end())
+				return false;
+			Firmware = E->Firmwares[hint->second];
+			return true;
+		}
+
+		bool Resolver::GetLatest(const std::string &device_type, bool RCOnly,
+								 FMSObjects::Firmware &Firmware) {
+			std::unique_lock<std::mutex> G;
+			auto E = Lookup(Latest_, std::make_pair(device_type, RCOnly), G, [&](auto &Firmwares) {
+				FMSObjects::Firmware F;
+				if (!Firmware::GetLatest(device_type, RCOnly, F))
+					return false;
+				Firmwares.emplace_back(std::move(F));
+				return true;
+			});
+			if (E == nullptr || E->Firmwares.empty())
+				return false;
+			Firmware = E->Firmwares.front();
+			return true;
+		}
+
+		bool Resolver::GetDeviceTypeFirmwares(const std::string &device_type,
+											  std::vector<FMSObjects::Firmware> &Firmwares) {
+			std::unique_lock<std::mutex> G;
+			auto E = Lookup(DeviceTypes_, device_type, G, [&](auto &Fetched) {
+				return Firmware::GetDeviceTypeFirmwares(device_type, Fetched);
+			});
+			if (E == nullptr)
+				return false;
+			Firmwares.insert(Firmwares.end(), E->Firmwares.begin(), E->Firmwares.end());
+			return true;
+		}
+
+		namespace Async {
+			std::future<std::optional<FMSObjects::Firmware>> GetLatest(const std::string &device_type,
+																	   bool RCOnly) {
+				return OpenAPIAsync()->Submit(
+					[device_type, RCOnly]() -> std::optional<FMSObjects::Firmware> {
+						FMSObjects::Firmware F;
+						if (Firmware::GetLatest(device_type, RCOnly, F))
+							return F;
+						return std::nullopt;
+					});
+			}
+
+			std::future<std::optional<FMSObjects::Firmware>>
+			GetFirmware(const std::string &device_type, const std::string &revision) {
+				return OpenAPIAsync()->Submit(
+					[device_type, revision]() -> std::optional<FMSObjects::Firmware> {
+						FMSObjects::Firmware F;
+						if (Firmware::GetFirmware(device_type, revision, F))
+							return F;
+						return std::nullopt;
+					});
+			}
+		} // namespace Async
+
 	} // namespace Firmware
 
 }; // namespace OpenWifi::SDK::FMS
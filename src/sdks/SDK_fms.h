@@ -4,7 +4,15 @@
 
 #pragma once
 
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 #include "RESTObjects/RESTAPI_FMSObjects.h"
+#include "framework/MetricsRegistry.h"
 
 namespace OpenWifi::SDK::FMS {
 
@@ -14,6 +22,49 @@ namespace OpenWifi::SDK::FMS {
 									std::vector<FMSObjects::Firmware> &FirmWares);
 		bool GetFirmware(const std::string &device_type, const std::string &revision,
 						 FMSObjects::Firmware &FirmWare);
+
+		//	Firmware lookups for the duration of one job. The firmware list of each device type,
+		//	and its latest firmware, are fetched once by the first device that needs them and
+		//	shared by the others, until they are older than the TTL. A failed fetch is not
+		//	kept: the next device of that type tries again.
+		class Resolver {
+		  public:
+			explicit Resolver(std::chrono::seconds TTL = std::chrono::seconds(300)) : TTL_(TTL) {}
+
+			bool GetFirmware(const std::string &device_type, const std::string &revision,
+							 FMSObjects::Firmware &Firmware);
+			bool GetLatest(const std::string &device_type, bool RCOnly,
+						   FMSObjects::Firmware &Firmware);
+			bool GetDeviceTypeFirmwares(const std::string &device_type,
+										std::vector<FMSObjects::Firmware> &Firmwares);
+
+		  private:
+			struct Entry {
+				std::mutex Mutex;
+				bool Fetched = false;
+				std::chrono::steady_clock::time_point FetchedAt{};
+				std::vector<FMSObjects::Firmware> Firmwares;
+				std::map<std::string, std::size_t> ByRevision;
+			};
+
+			std::chrono::seconds TTL_;
+			std::mutex Mutex_;
+			std::map<std::string, Entry> DeviceTypes_;
+			std::map<std::pair<std::string, bool>, Entry> Latest_;
+			MetricsCacheStats Stats_{"firmware"};
+
+			//	Returns the entry locked by G, filled by Fetch when it is missing or stale.
+			template <typename Key, typename Fetch>
+			Entry *Lookup(std::map<Key, Entry> &Entries, const Key &K,
+						  std::unique_lock<std::mutex> &G, Fetch &&F);
+		};
+
+		namespace Async {
+			std::future<std::optional<FMSObjects::Firmware>> GetLatest(const std::string &device_type,
+																	   bool RCOnly);
+			std::future<std::optional<FMSObjects::Firmware>>
+			GetFirmware(const std::string &device_type, const std::string &revision);
+		} // namespace Async
 	} // namespace Firmware
 
 }; // namespace OpenWifi::SDK::FMS
@@ -249,6 +249,66 @@ namespace OpenWifi::SDK::GW {
 			}
 			return false;
 		}
+
+		namespace Async {
+			std::future<bool> Reboot(const std::string &Mac, uint64_t When) {
+				return OpenAPIAsync()->Submit([Mac, When]() { return Device::Reboot(Mac, When); });
+			}
+
+			std::future<CommandResult> Upgrade(const std::string &Mac, uint64_t When,
+											   const std::string &ImageName) {
+				return OpenAPIAsync()->Submit([Mac, When, ImageName]() {
+					CommandResult R;
+					R.Success = Device::Upgrade(nullptr, Mac, When, ImageName, R.Status);
+					return R;
+				});
+			}
+
+			std::future<CommandResult> Configure(const std::string &Mac,
+												 Poco::JSON::Object::Ptr Configuration) {
+				return OpenAPIAsync()->Submit([Mac, Configuration]() mutable {
+					CommandResult R;
+					R.Response = Poco::makeShared<Poco::JSON::Object>();
+					R.Success = Device::Configure(nullptr, Mac, Configuration, R.Response);
+					return R;
+				});
+			}
+
+			void Configure(const std::string &Mac, Poco::JSON::Object::Ptr Configuration,
+						   std::function<void(CommandResult)> OnComplete) {
+				OpenAPIAsync()->Submit(
+					[Mac, Configuration]() mutable {
+						CommandResult R;
+						R.Response = Poco::makeShared<Poco::JSON::Object>();
+						R.Success = Device::Configure(nullptr, Mac, Configuration, R.Response);
+						return R;
+					},
+					[OnComplete = std::move(OnComplete)](std::future<CommandResult> Result) {
+						CommandResult R;
+						try {
+							R = Result.get();
+						} catch (const Poco::Exception &E) {
+							R.Status = E.displayText();
+						} catch (const std::exception &E) {
+							R.Status = E.what();
+						}
+						OnComplete(R);
+					});
+			}
+
+			std::future<bool> Delete(const std::string &SerialNumber) {
+				return OpenAPIAsync()->Submit(
+					[SerialNumber]() { return Device::Delete(nullptr, SerialNumber); });
+			}
+
+			std::future<bool> SetOwnerShip(const std::string &SerialNumber,
+										   const std::string &entity, const std::string &venue,
+										   const std::string &subscriber) {
+				return OpenAPIAsync()->Submit([SerialNumber, entity, venue, subscriber]() {
+					return Device::SetOwnerShip(nullptr, SerialNumber, entity, venue, subscriber);
+				});
+			}
+		} // namespace Async
 	} // namespace Device
 
     namespace RADIUS {
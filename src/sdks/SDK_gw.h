@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <future>
+
 #include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/OpenAPIAsync.h"
 #include "framework/RESTAPI_Handler.h"
 
 namespace OpenWifi::SDK::GW {
@@ -38,6 +41,29 @@ namespace OpenWifi::SDK::GW {
 		bool SetOwnerShip(RESTAPIHandler *client, const std::string &SerialNumber,
 						  const std::string &entity, const std::string &venue,
 						  const std::string &subscriber);
+
+		//	Same calls, run on the OpenAPIAsync engine. They use the internal API key.
+		namespace Async {
+			struct CommandResult {
+				bool Success = false;
+				std::string Status;
+				Poco::JSON::Object::Ptr Response;
+			};
+
+			std::future<bool> Reboot(const std::string &Mac, uint64_t When);
+			std::future<CommandResult> Upgrade(const std::string &Mac, uint64_t When,
+											   const std::string &ImageName);
+			std::future<CommandResult> Configure(const std::string &Mac,
+												 Poco::JSON::Object::Ptr Configuration);
+			//	OnComplete is always called. When the call throws, Success is false and Status
+			//	holds the error.
+			void Configure(const std::string &Mac, Poco::JSON::Object::Ptr Configuration,
+						   std::function<void(CommandResult)> OnComplete);
+			std::future<bool> Delete(const std::string &SerialNumber);
+			std::future<bool> SetOwnerShip(const std::string &SerialNumber,
+										   const std::string &entity, const std::string &venue,
+										   const std::string &subscriber);
+		} // namespace Async
 	} // namespace Device
     namespace RADIUS {
         bool GetConfiguration(RESTAPIHandler *client, GWObjects::RadiusProxyPoolList &Pools);
@@ -4,6 +4,7 @@
 
 #include "SDK_sec.h"
 #include "framework/MicroServiceNames.h"
+#include "framework/OpenAPIAsync.h"
 #include "framework/OpenAPIRequests.h"
 
 namespace OpenWifi::SDK::Sec {
@@ -44,6 +45,21 @@ namespace OpenWifi::SDK::Sec {
 			}
 			return false;
 		}
+
+		namespace Async {
+			std::future<bool> Exists(const Types::UUID_t &Id) {
+				return OpenAPIAsync()->Submit([Id]() { return User::Exists(nullptr, Id); });
+			}
+
+			std::future<std::optional<SecurityObjects::UserInfo>> Get(const Types::UUID_t &Id) {
+				return OpenAPIAsync()->Submit([Id]() -> std::optional<SecurityObjects::UserInfo> {
+					SecurityObjects::UserInfo UI;
+					if (User::Get(nullptr, Id, UI))
+						return UI;
+					return std::nullopt;
+				});
+			}
+		} // namespace Async
 	} // namespace User
 
 	namespace Subscriber {
@@ -99,6 +115,24 @@ namespace OpenWifi::SDK::Sec {
 			return false;
 		}
 
+		namespace Async {
+			std::future<bool> Exists(const Types::UUID_t &Id) {
+				return OpenAPIAsync()->Submit([Id]() { return Subscriber::Exists(nullptr, Id); });
+			}
+
+			std::future<std::optional<SecurityObjects::UserInfo>> Get(const Types::UUID_t &Id) {
+				return OpenAPIAsync()->Submit([Id]() -> std::optional<SecurityObjects::UserInfo> {
+					SecurityObjects::UserInfo UI;
+					if (Subscriber::Get(nullptr, Id, UI))
+						return UI;
+					return std::nullopt;
+				});
+			}
+
+			std::future<bool> Delete(const Types::UUID_t &Id) {
+				return OpenAPIAsync()->Submit([Id]() { return Subscriber::Delete(nullptr, Id); });
+			}
+		} // namespace Async
 	} // namespace Subscriber
 
 } // namespace OpenWifi::SDK::Sec
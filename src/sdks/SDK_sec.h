@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <future>
+#include <optional>
+
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "framework/RESTAPI_Handler.h"
 
@@ -13,6 +16,11 @@ namespace OpenWifi::SDK::Sec {
 		bool Exists(RESTAPIHandler *client, const Types::UUID_t &User);
 		bool Get(RESTAPIHandler *client, const Types::UUID_t &User,
 				 SecurityObjects::UserInfo &UserInfo);
+
+		namespace Async {
+			std::future<bool> Exists(const Types::UUID_t &User);
+			std::future<std::optional<SecurityObjects::UserInfo>> Get(const Types::UUID_t &User);
+		} // namespace Async
 	} // namespace User
 
 	namespace Subscriber {
@@ -22,6 +30,12 @@ namespace OpenWifi::SDK::Sec {
 		bool Delete(RESTAPIHandler *client, const Types::UUID_t &User);
 		bool Search(RESTAPIHandler *client, const std::string &OperatorId, const std::string &Name,
 					const std::string &EMail, SecurityObjects::UserInfoList &Users);
+
+		namespace Async {
+			std::future<bool> Exists(const Types::UUID_t &User);
+			std::future<std::optional<SecurityObjects::UserInfo>> Get(const Types::UUID_t &User);
+			std::future<bool> Delete(const Types::UUID_t &User);
+		} // namespace Async
 	} // namespace Subscriber
 
 } // namespace OpenWifi::SDK::Sec
@@ -7,6 +7,7 @@
 //
 
 #include "storage_inventory.h"
+#include "InventorySearchIndex.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "SerialNumberCache.h"
 #include "StorageService.h"
@@ -70,8 +71,9 @@ namespace OpenWifi {
 
 		for (const auto &i : Script) {
 			try {
-				auto Session = Pool_.get();
-				Session << i, Poco::Data::Keywords::now;
+				Write([&i](Poco::Data::Session &Session) {
+					Session << i, Poco::Data::Keywords::now;
+				});
 			} catch (...) {
 			}
 		}
@@ -80,8 +82,23 @@ namespace OpenWifi {
 
 #define __DBG__ std::cout << __FILE__ << ": " << __LINE__ << std::endl;
 
+	void InventorySearchFeed::Create(const ProvObjects::InventoryTag &R) {
+		InventorySearchIndex()->Add(R);
+	}
+
+	//	Reads may come from a lagging replica: only writes reach the index.
+	void InventorySearchFeed::UpdateCache([[maybe_unused]] const ProvObjects::InventoryTag &R) {}
+
+	void InventorySearchFeed::Updated(const ProvObjects::InventoryTag &R) {
+		InventorySearchIndex()->Add(R);
+	}
+
+	void InventorySearchFeed::Delete(const std::string &FieldName, const std::string &Value) {
+		InventorySearchIndex()->Remove(FieldName, Value);
+	}
+
 	InventoryDB::InventoryDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
-		: DB(T, "inventory", InventoryDB_Fields, InventoryDB_Indexes, P, L, "inv") {}
+		: DB(T, "inventory", InventoryDB_Fields, InventoryDB_Indexes, P, L, "inv", &SearchFeed_) {}
 
 	bool InventoryDB::CreateFromConnection(const std::string &SerialNumberRaw,
 										   const std::string &ConnectionInfo,
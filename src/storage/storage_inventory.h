@@ -19,6 +19,21 @@ namespace OpenWifi {
 						std::string, std::string, bool, uint64_t, uint64_t, std::string>
 		InventoryDBRecordType;
 
+	//	Not a cache: it passes every device written on to the inventory search index.
+	class InventorySearchFeed : public ORM::DBCache<ProvObjects::InventoryTag> {
+	  public:
+		InventorySearchFeed() : ORM::DBCache<ProvObjects::InventoryTag>(0, 0) {}
+		void Create(const ProvObjects::InventoryTag &R) override;
+		bool GetFromCache([[maybe_unused]] const std::string &FieldName,
+						  [[maybe_unused]] const std::string &Value,
+						  [[maybe_unused]] ProvObjects::InventoryTag &R) override {
+			return false;
+		}
+		void UpdateCache(const ProvObjects::InventoryTag &R) override;
+		void Updated(const ProvObjects::InventoryTag &R) override;
+		void Delete(const std::string &FieldName, const std::string &Value) override;
+	};
+
 	class InventoryDB : public ORM::DB<InventoryDBRecordType, ProvObjects::InventoryTag> {
 	  public:
 		InventoryDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
@@ -44,6 +59,8 @@ namespace OpenWifi {
         bool GetDevicesForVenue(const std::string &uuid, std::vector<ProvObjects::InventoryTag> &devices);
 
 	  private:
+		InventorySearchFeed SearchFeed_;
+
 		bool EvaluateDeviceRules(const ProvObjects::InventoryTag &T,
 								 ProvObjects::DeviceRules &Rules);
 	};
@@ -78,9 +78,10 @@ namespace OpenWifi {
 		}
 
 		try {
-			auto Session = Pool_.get();
 			std::string Query = "alter table " + TableName_ + " add column timezone text";
-			Session << Query, Poco::Data::Keywords::now;
+			Write([&Query](Poco::Data::Session &Session) {
+				Session << Query, Poco::Data::Keywords::now;
+			});
 			Logger().information(fmt::format("LocationDB::Upgrade: Successfully added column 'timezone' to table {}", TableName_));
 			return true;
 		} catch (const Poco::Exception &E) {
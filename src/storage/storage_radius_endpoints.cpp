@@ -4,6 +4,7 @@
 
 #include "storage_radius_endpoints.h"
 #include <framework/RESTAPI_utils.h>
+#include <framework/MicroServiceFuncs.h>
 namespace OpenWifi {
 
     static ORM::FieldVec RadiusEndpointDB_Fields{// object info
@@ -29,7 +30,10 @@ namespace OpenWifi {
              ORM::IndexEntryVec{{std::string("name"), ORM::Indextype::ASC}}}};
 
     RadiusEndpointDB::RadiusEndpointDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
-            : DB(T, "radius_endpoints", RadiusEndpointDB_Fields, RadiusEndpointDB_Indexes, P, L, "rep") {}
+            : DB(T, "radius_endpoints", RadiusEndpointDB_Fields, RadiusEndpointDB_Indexes, P, L, "rep") {
+        RenderCache_ = std::make_unique<RadiusEndpointCache>(0, MicroServiceConfigGetInt("radiusendpoints.cache.ttl", 60));
+        Cache_ = RenderCache_.get();
+    }
 
     bool RadiusEndpointDB::Upgrade([[maybe_unused]] uint32_t from, uint32_t &to) {
         to = Version();
@@ -40,8 +44,9 @@ namespace OpenWifi {
 
         for (const auto &i : Script) {
             try {
-                auto Session = Pool_.get();
-                Session << i, Poco::Data::Keywords::now;
+                Write([&i](Poco::Data::Session &Session) {
+                    Session << i, Poco::Data::Keywords::now;
+                });
             } catch (...) {
             }
         }
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <map>
+#include <shared_mutex>
+
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "framework/orm.h"
+#include "framework/utils.h"
 
 namespace OpenWifi {
 
@@ -27,12 +31,96 @@ namespace OpenWifi {
             std::uint64_t
     >   RadiusEndpointDbRecordType;
 
+    //  Endpoints are read once per __radiusEndpoint reference while rendering device configurations,
+    //  so the records and the fragments rendered from them are kept here. Every write through
+    //  RadiusEndpointDB drops the entry; the TTL bounds how long writes made by another
+    //  provisioning instance go unseen.
+    class RadiusEndpointCache : public ORM::DBCache<ProvObjects::RADIUSEndPoint> {
+    public:
+        struct Rendered {
+            std::uint64_t       Modified = 0;
+            Poco::JSON::Object  Fragment;
+            bool                DeviceNasIdentifier = false;   //  nas-identifier is the device serial number
+            bool                Result = false;
+        };
+
+        RadiusEndpointCache(unsigned Size, unsigned Timeout)
+            : ORM::DBCache<ProvObjects::RADIUSEndPoint>(Size, Timeout), Timeout_(Timeout) {}
+
+        void Create([[maybe_unused]] const ProvObjects::RADIUSEndPoint &R) override {}
+
+        bool GetFromCache(const std::string &FieldName, const std::string &Value,
+                          ProvObjects::RADIUSEndPoint &R) override {
+            if(FieldName!="id")
+                return false;
+            std::shared_lock    G(Mutex_);
+            auto Hint = Entries_.find(Value);
+            if(Hint==Entries_.end() || (Utils::Now() - Hint->second.Loaded) > Timeout_) {
+                RecordStats_.Miss();
+                return false;
+            }
+            RecordStats_.Hit();
+            R = Hint->second.Record;
+            return true;
+        }
+
+        void UpdateCache(const ProvObjects::RADIUSEndPoint &R) override {
+            std::unique_lock    G(Mutex_);
+            auto &E = Entries_[R.info.id];
+            E.Render.reset();
+            E.Record = R;
+            E.Loaded = Utils::Now();
+        }
+
+        void Delete(const std::string &FieldName, const std::string &Value) override {
+            std::unique_lock    G(Mutex_);
+            if(FieldName=="id")
+                Entries_.erase(Value);
+            else
+                Entries_.clear();
+        }
+
+        //  A fragment is only handed out for the modification time it was rendered from.
+        std::shared_ptr<const Rendered> GetRender(const ProvObjects::RADIUSEndPoint &R) {
+            std::shared_lock    G(Mutex_);
+            auto Hint = Entries_.find(R.info.id);
+            if(Hint==Entries_.end() || Hint->second.Render==nullptr || Hint->second.Render->Modified!=R.info.modified) {
+                RenderStats_.Miss();
+                return nullptr;
+            }
+            RenderStats_.Hit();
+            return Hint->second.Render;
+        }
+
+        void SetRender(const ProvObjects::RADIUSEndPoint &R, std::shared_ptr<const Rendered> Render) {
+            std::unique_lock    G(Mutex_);
+            auto Hint = Entries_.find(R.info.id);
+            if(Hint!=Entries_.end() && Hint->second.Record.info.modified==R.info.modified)
+                Hint->second.Render = std::move(Render);
+        }
+
+    private:
+        struct Entry {
+            ProvObjects::RADIUSEndPoint         Record;
+            std::uint64_t                       Loaded = 0;
+            std::shared_ptr<const Rendered>     Render;
+        };
+
+        std::uint64_t                   Timeout_;
+        std::shared_mutex               Mutex_;
+        std::map<std::string, Entry>    Entries_;
+        MetricsCacheStats               RecordStats_{"radius_endpoints"};
+        MetricsCacheStats               RenderStats_{"radius_endpoint_fragments"};
+    };
+
     class RadiusEndpointDB : public ORM::DB<RadiusEndpointDbRecordType, ProvObjects::RADIUSEndPoint> {
     public:
         RadiusEndpointDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
         virtual ~RadiusEndpointDB(){};
         bool Upgrade(uint32_t from, uint32_t &to) override;
 
+        inline RadiusEndpointCache &RenderCache() { return *RenderCache_; }
+
         static inline bool ValidIndex(const std::string &I) {
             static uint32_t Low = Utils::IPtoInt("0.0.1.1");
             static uint32_t High = Utils::IPtoInt("0.0.2.254");
@@ -41,6 +129,6 @@ namespace OpenWifi {
         }
 
     private:
-
+        std::unique_ptr<RadiusEndpointCache>    RenderCache_;
     };
 } // namespace OpenWifi
@@ -67,8 +67,9 @@ namespace OpenWifi {
 
 		for (const auto &i : Script) {
 			try {
-				auto Session = Pool_.get();
-				Session << i, Poco::Data::Keywords::now;
+				Write([&i](Poco::Data::Session &Session) {
+					Session << i, Poco::Data::Keywords::now;
+				});
 			} catch (...) {
 			}
 		}
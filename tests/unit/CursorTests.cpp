@@ -0,0 +1,63 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include <algorithm>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "BenchEnvironment.h"
+#include "StorageService.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	//	Follows NextCursor from the first page to the last, HowMany records at a time.
+	static std::vector<std::string> AllPages(uint64_t HowMany, const std::string &Where = "") {
+		std::vector<std::string> Ids;
+		std::string Cursor;
+		do {
+			std::vector<ProvObjects::InventoryTag> Page;
+			std::string Next;
+			EXPECT_TRUE(StorageService()->InventoryDB().GetRecordsPage(Cursor, HowMany, Page, Next,
+																	   Where));
+			EXPECT_LE(Page.size(), HowMany);
+			for (const auto &T : Page)
+				Ids.emplace_back(T.info.id);
+			if (!Next.empty())
+				EXPECT_EQ(Page.size(), HowMany);
+			Cursor = Next;
+		} while (!Cursor.empty());
+		return Ids;
+	}
+
+	TEST(Cursor, VisitsEveryRecordOnceInIdOrder) {
+		auto Ids = AllPages(7);
+		EXPECT_EQ(Ids.size(), StorageService()->InventoryDB().Count());
+		EXPECT_TRUE(std::is_sorted(Ids.begin(), Ids.end()));
+		EXPECT_EQ(std::set<std::string>(Ids.begin(), Ids.end()).size(), Ids.size());
+	}
+
+	TEST(Cursor, PagesFilteredRecords) {
+		auto Where = fmt::format("venue='{}'", Bench::Data().Venues.front());
+		auto Ids = AllPages(3, Where);
+		EXPECT_EQ(Ids.size(), StorageService()->InventoryDB().Count(Where));
+		EXPECT_FALSE(Ids.empty());
+	}
+
+	TEST(Cursor, RejectsCursorsItDidNotIssue) {
+		std::vector<ProvObjects::Venue> Venues;
+		std::string VenueCursor;
+		ASSERT_TRUE(StorageService()->VenueDB().GetRecordsPage("", 1, Venues, VenueCursor));
+		ASSERT_FALSE(VenueCursor.empty());
+
+		std::vector<ProvObjects::InventoryTag> Page;
+		std::string Next;
+		EXPECT_FALSE(StorageService()->InventoryDB().GetRecordsPage(VenueCursor, 10, Page, Next));
+		EXPECT_FALSE(StorageService()->InventoryDB().GetRecordsPage("not a cursor!", 10, Page, Next));
+		EXPECT_TRUE(Page.empty());
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,79 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+#include "Poco/TemporaryFile.h"
+
+#include "Daemon.h"
+#include "FindCountry.h"
+
+namespace OpenWifi {
+
+	class IPRangeTableTest : public ::testing::Test {
+	  protected:
+		Poco::TemporaryFile File_;
+		IPRangeTable Table_;
+
+		void SetUp() override {
+			Daemon()->config().setString("iptocountry.local.file", File_.path());
+		}
+
+		void Write(const std::string &Content) {
+			std::ofstream Out(File_.path());
+			Out << Content;
+		}
+	};
+
+	TEST_F(IPRangeTableTest, FindsAddressDecimalAndPrefixRanges) {
+		Write("# first,last,country\n"
+			  "\"1.0.0.0\",\"1.0.0.255\",\"AU\"\n"
+			  "16777472,16778239,CN\n"
+			  "10.20.0.0/16,CA\n"
+			  "2001:db8::/32,DE\n"
+			  "42540766490509546445348707916023070720,42540766490510755371168322545197776895,FR\n");
+		ASSERT_TRUE(Table_.Init());
+		EXPECT_EQ(Table_.Lookup("1.0.0.0"), "AU");
+		EXPECT_EQ(Table_.Lookup("1.0.0.255"), "AU");
+		EXPECT_EQ(Table_.Lookup("1.0.1.0"), "CN");
+		EXPECT_EQ(Table_.Lookup("1.0.3.255"), "CN");
+		EXPECT_EQ(Table_.Lookup("1.0.4.0"), "");
+		EXPECT_EQ(Table_.Lookup("10.20.255.1"), "CA");
+		EXPECT_EQ(Table_.Lookup("10.21.0.0"), "");
+		EXPECT_EQ(Table_.Lookup("2001:db8:1::1"), "DE");
+		EXPECT_EQ(Table_.Lookup("2001:db8:ffff::1"), "FR");
+		EXPECT_EQ(Table_.Lookup("2001:db9::1"), "");
+		EXPECT_EQ(Table_.Lookup("0.0.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("not an address"), "");
+	}
+
+	TEST_F(IPRangeTableTest, SkipsMalformedLines) {
+		Write("10.0.0.0/abc,US\n"
+			  "10.1.0.0/,US\n"
+			  "10.2.0.0/200,US\n"
+			  "1000000000000000000000000000000000000000,1000000000000000000000000000000000000001,US\n"
+			  "10.3.0.0,10.2.0.0,US\n"
+			  "10.4.0.0/16,USA\n"
+			  "10.5.0.0/16,GB\n");
+		ASSERT_TRUE(Table_.Init());
+		EXPECT_EQ(Table_.Lookup("10.0.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("10.1.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("10.2.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("10.3.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("10.4.0.1"), "");
+		EXPECT_EQ(Table_.Lookup("10.5.0.1"), "GB");
+	}
+
+	TEST_F(IPRangeTableTest, PicksUpAFileCreatedLater) {
+		ASSERT_TRUE(Table_.Init());
+		EXPECT_EQ(Table_.Lookup("10.5.0.1"), "");
+		Write("10.5.0.0/16,GB\n");
+		EXPECT_TRUE(Table_.Refresh());
+		EXPECT_EQ(Table_.Lookup("10.5.0.1"), "GB");
+		EXPECT_FALSE(Table_.Refresh());
+	}
+
+} // namespace OpenWifi
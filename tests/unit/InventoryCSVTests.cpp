@@ -0,0 +1,64 @@
+//
+// Created by stephane bourque on 2023-11-30.
+//
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "InventoryCSV.h"
+
+namespace OpenWifi {
+
+	TEST(InventoryCSV, RoundTripsQuotesCommasAndLineBreaks) {
+		ProvObjects::InventoryTag T;
+		T.serialNumber = "aabbccddeeff";
+		T.info.name = "Lobby, \"north\" wing";
+		T.info.description = "first line\r\nsecond line\nthird, \"quoted\"";
+		T.deviceType = "edgecore_eap101";
+		T.venue = "5d3f2f96-0f0e-4f1b-8d5c-1b0d7a9e7c11";
+		T.doNotAllowOverrides = true;
+
+		std::stringstream S;
+		InventoryCSV::WriteHeader(S);
+		InventoryCSV::Write(S, T);
+		InventoryCSV::Write(S, T);
+
+		std::vector<std::string> Header, Values;
+		std::uint64_t Lines = 0;
+		ASSERT_TRUE(InventoryCSV::Read(S, Header, Lines));
+		EXPECT_EQ(Header, InventoryCSV::Columns);
+		EXPECT_EQ(Lines, 1u);
+
+		for (int i = 0; i < 2; ++i) {
+			ASSERT_TRUE(InventoryCSV::Read(S, Values, Lines));
+			EXPECT_EQ(Lines, 3u);
+			ProvObjects::InventoryTag R;
+			ASSERT_TRUE(R.from_json(InventoryCSV::Row(Header, Values)));
+			EXPECT_EQ(R.serialNumber, T.serialNumber);
+			EXPECT_EQ(R.info.name, T.info.name);
+			EXPECT_EQ(R.info.description, T.info.description);
+			EXPECT_EQ(R.deviceType, T.deviceType);
+			EXPECT_EQ(R.venue, T.venue);
+			EXPECT_TRUE(R.doNotAllowOverrides);
+		}
+		EXPECT_FALSE(InventoryCSV::Read(S, Values, Lines));
+	}
+
+	TEST(InventoryCSV, ReadsLastRecordWithoutLineBreakAndEmptyLines) {
+		std::istringstream S("a,b\n\n\"x\"\"y\",\r\nlast,");
+		std::vector<std::string> Fields;
+		std::uint64_t Lines = 0;
+		ASSERT_TRUE(InventoryCSV::Read(S, Fields, Lines));
+		EXPECT_EQ(Fields, (std::vector<std::string>{"a", "b"}));
+		ASSERT_TRUE(InventoryCSV::Read(S, Fields, Lines));
+		EXPECT_EQ(Fields, std::vector<std::string>{""});
+		ASSERT_TRUE(InventoryCSV::Read(S, Fields, Lines));
+		EXPECT_EQ(Fields, (std::vector<std::string>{"x\"y", ""}));
+		ASSERT_TRUE(InventoryCSV::Read(S, Fields, Lines));
+		EXPECT_EQ(Fields, (std::vector<std::string>{"last", ""}));
+		EXPECT_EQ(Lines, 1u);
+		EXPECT_FALSE(InventoryCSV::Read(S, Fields, Lines));
+	}
+
+} // namespace OpenWifi
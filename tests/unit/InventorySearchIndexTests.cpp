@@ -0,0 +1,123 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "BenchEnvironment.h"
+#include "Daemon.h"
+#include "InventorySearchIndex.h"
+#include "StorageService.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	class InventorySearchIndexTest : public ::testing::Test {
+	  protected:
+		static void SetUpTestSuite() {
+			InventorySearchIndex()->initialize(*Daemon());
+			InventorySearchIndex()->Start();
+		}
+		static void TearDownTestSuite() { InventorySearchIndex()->Stop(); }
+
+		static std::vector<std::string> Find(const std::string &Text, bool Prefix = false) {
+			InventorySearchIndex::Query Q;
+			Q.Text = Text;
+			Q.Prefix = Prefix;
+			Q.Limit = 1'000'000;
+			std::vector<InventorySearchIndex::Match> Matches;
+			std::uint64_t Total = 0;
+			EXPECT_TRUE(InventorySearchIndex()->Search(Q, Matches, Total));
+			EXPECT_EQ(Total, Matches.size());
+			std::vector<std::string> Serials;
+			for (const auto &M : Matches)
+				Serials.emplace_back(M.SerialNumber);
+			return Serials;
+		}
+
+		static ProvObjects::InventoryTag Device(const std::string &SerialNumber,
+												const std::string &Name) {
+			ProvObjects::InventoryTag T;
+			T.info.id = MicroServiceCreateUUID();
+			T.info.name = Name;
+			T.info.created = T.info.modified = Utils::Now();
+			T.serialNumber = SerialNumber;
+			T.deviceType = Bench::Data().DeviceType;
+			return T;
+		}
+	};
+
+	TEST_F(InventorySearchIndexTest, LoadsTheTable) {
+		const auto &Serial = Bench::Data().SerialNumbers.front();
+		EXPECT_EQ(Find(Serial), std::vector<std::string>{Serial});
+		EXPECT_EQ(Find(Serial.substr(0, 6), true).size(),
+				  StorageService()->InventoryDB().Count("serialNumber like '" +
+														Serial.substr(0, 6) + "%'"));
+	}
+
+	TEST_F(InventorySearchIndexTest, FollowsCreateUpdateAndDelete) {
+		auto &DB = StorageService()->InventoryDB();
+		auto T = Device("a1b2c3d4e5f6", "lobby unittest access point");
+		ASSERT_TRUE(DB.CreateRecord(T));
+		EXPECT_EQ(Find("a1b2c3d4e5f6"), std::vector<std::string>{T.serialNumber});
+		EXPECT_EQ(Find("lobb", true), std::vector<std::string>{T.serialNumber});
+
+		T.info.name = "kitchen unittest access point";
+		ASSERT_TRUE(DB.UpdateRecord("id", T.info.id, T));
+		EXPECT_TRUE(Find("lobby").empty());
+		EXPECT_EQ(Find("kitchen"), std::vector<std::string>{T.serialNumber});
+
+		ASSERT_TRUE(DB.DeleteRecord("id", T.info.id));
+		EXPECT_TRUE(Find("a1b2c3d4e5f6").empty());
+		EXPECT_TRUE(Find("kitchen").empty());
+	}
+
+	TEST_F(InventorySearchIndexTest, ReadsDoNotChangeTheIndex) {
+		auto &DB = StorageService()->InventoryDB();
+		auto T = Device("f6e5d4c3b2a1", "unittest fresh name");
+		ASSERT_TRUE(DB.CreateRecord(T));
+		//	What a lagging replica would return: the device as it was before.
+		auto Stale = T;
+		Stale.info.name = "unittest stale name";
+		ProvObjects::InventoryTag Read;
+		ASSERT_TRUE(DB.GetRecord("id", T.info.id, Read));
+		InventorySearchFeed Feed;
+		Feed.UpdateCache(Stale);
+		EXPECT_EQ(Find("fresh"), std::vector<std::string>{T.serialNumber});
+		EXPECT_TRUE(Find("stale").empty());
+		ASSERT_TRUE(DB.DeleteRecord("serialNumber", T.serialNumber));
+		EXPECT_TRUE(Find("f6e5d4c3b2a1").empty());
+	}
+
+	TEST_F(InventorySearchIndexTest, RebuildsAfterADeleteByAnotherField) {
+		auto &DB = StorageService()->InventoryDB();
+		auto Gone = Device("1a2b3c4d5e6f", "unittest rebuild gone");
+		Gone.location = MicroServiceCreateUUID();
+		ASSERT_TRUE(DB.CreateRecord(Gone));
+		ASSERT_TRUE(DB.DeleteRecord("location", Gone.location));
+		//	Written while the rebuild may be reading the table: kept all the same.
+		auto Kept = Device("6f5e4d3c2b1a", "unittest rebuild kept");
+		ASSERT_TRUE(DB.CreateRecord(Kept));
+
+		for (int i = 0; i < 5000 && !Find("1a2b3c4d5e6f").empty(); ++i)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		EXPECT_TRUE(Find("1a2b3c4d5e6f").empty());
+		EXPECT_EQ(Find("6f5e4d3c2b1a"), std::vector<std::string>{Kept.serialNumber});
+		ASSERT_TRUE(DB.DeleteRecord("id", Kept.info.id));
+	}
+
+	TEST_F(InventorySearchIndexTest, RemovesByVenue) {
+		auto &DB = StorageService()->InventoryDB();
+		auto T = Device("0a0b0c0d0e0f", "unittest venue removal");
+		T.venue = MicroServiceCreateUUID();
+		ASSERT_TRUE(DB.CreateRecord(T));
+		EXPECT_EQ(Find("0a0b0c0d0e0f"), std::vector<std::string>{T.serialNumber});
+		ASSERT_TRUE(DB.DeleteRecord("venue", T.venue));
+		EXPECT_TRUE(Find("0a0b0c0d0e0f").empty());
+	}
+
+} // namespace OpenWifi
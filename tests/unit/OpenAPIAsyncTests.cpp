@@ -0,0 +1,108 @@
+//
+// Created by stephane bourque on 2022-10-25.
+//
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "Daemon.h"
+#include "framework/OpenAPIAsync.h"
+
+namespace OpenWifi {
+
+	class OpenAPIAsyncTest : public ::testing::Test {
+	  protected:
+		static constexpr int Threads = 2, MaxInFlight = 4;
+
+		static void SetUpTestSuite() {
+			Daemon()->config().setInt("openwifi.openapi.async.threads", Threads);
+			Daemon()->config().setInt("openwifi.openapi.async.maxinflight", MaxInFlight);
+			OpenAPIAsync()->initialize(*Daemon());
+			OpenAPIAsync()->Start();
+		}
+		static void TearDownTestSuite() { OpenAPIAsync()->Stop(); }
+
+		//	A slot is released just after the future of its call is ready.
+		static void WaitIdle() {
+			while (OpenAPIAsync()->InFlight() > 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+
+	TEST_F(OpenAPIAsyncTest, FuturesCarryTheResultOrTheException) {
+		auto Good = OpenAPIAsync()->Submit([]() { return 42; });
+		auto Bad = OpenAPIAsync()->Submit([]() -> int { throw std::runtime_error("failed"); });
+		EXPECT_EQ(Good.get(), 42);
+		EXPECT_THROW(Bad.get(), std::runtime_error);
+	}
+
+	TEST_F(OpenAPIAsyncTest, OnCompleteIsCalledWhenTheCallThrows) {
+		std::promise<bool> Threw;
+		OpenAPIAsync()->Submit([]() -> int { throw std::runtime_error("failed"); },
+							   [&Threw](std::future<int> Result) {
+								   try {
+									   Result.get();
+									   Threw.set_value(false);
+								   } catch (const std::runtime_error &) {
+									   Threw.set_value(true);
+								   }
+							   });
+		EXPECT_TRUE(Threw.get_future().get());
+	}
+
+	TEST_F(OpenAPIAsyncTest, NestedCallsDoNotWaitForAThread) {
+		std::vector<std::future<int>> Outer;
+		for (int i = 0; i < Threads; ++i)
+			Outer.emplace_back(OpenAPIAsync()->Submit(
+				[i]() { return OpenAPIAsync()->Submit([i]() { return i; }).get(); }));
+		for (int i = 0; i < Threads; ++i) {
+			ASSERT_EQ(Outer[i].wait_for(std::chrono::seconds(10)), std::future_status::ready);
+			EXPECT_EQ(Outer[i].get(), i);
+		}
+	}
+
+	TEST_F(OpenAPIAsyncTest, CallsPastTheCapRunOnTheCaller) {
+		WaitIdle();
+		std::promise<void> Gate;
+		auto Open = Gate.get_future().share();
+		std::vector<std::future<void>> Blocked;
+		for (int i = 0; i < MaxInFlight; ++i)
+			Blocked.emplace_back(OpenAPIAsync()->Submit([Open]() { Open.wait(); }));
+		EXPECT_EQ(OpenAPIAsync()->InFlight(), static_cast<std::uint64_t>(MaxInFlight));
+
+		auto Caller = std::this_thread::get_id();
+		auto Extra = OpenAPIAsync()->Submit([]() { return std::this_thread::get_id(); });
+		ASSERT_EQ(Extra.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+		EXPECT_EQ(Extra.get(), Caller);
+		EXPECT_FALSE(OpenAPIAsync()->TryRun([]() {}));
+
+		Gate.set_value();
+		for (auto &F : Blocked)
+			F.get();
+	}
+
+	TEST_F(OpenAPIAsyncTest, StopRunsTheQueuedCalls) {
+		WaitIdle();
+		std::atomic_int Ran = 0;
+		for (int i = 0; i < MaxInFlight; ++i)
+			OpenAPIAsync()->Submit(
+				[]() {
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+					return 0;
+				},
+				[&Ran](std::future<int>) { ++Ran; });
+		OpenAPIAsync()->Stop();
+		EXPECT_EQ(Ran, MaxInFlight);
+
+		auto Caller = std::this_thread::get_id();
+		EXPECT_EQ(OpenAPIAsync()->Submit([]() { return std::this_thread::get_id(); }).get(), Caller);
+		OpenAPIAsync()->Start();
+	}
+
+} // namespace OpenWifi
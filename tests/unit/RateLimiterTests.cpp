@@ -0,0 +1,84 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "framework/RESTAPI_RateLimiter.h"
+
+namespace OpenWifi {
+
+	//	10 calls per second: one call every 100ms, in bursts of up to 10.
+	static constexpr int64_t Interval = 1000, MaxCalls = 10, Emission = 100'000;
+	static constexpr int64_t T0 = 1'000'000'000;
+
+	TEST(RateLimiter, AdmitsABurstThenOneCallPerEmissionInterval) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		for (int i = 0; i < MaxCalls; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls, T0));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls, T0));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls,
+										   T0 + Emission - 1));
+		EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls,
+											T0 + Emission));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls,
+										   T0 + Emission));
+	}
+
+	TEST(RateLimiter, RefillsCompletelyWhenIdle) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		for (int i = 0; i < MaxCalls; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls, T0));
+		auto Later = T0 + MaxCalls * Emission;
+		for (int i = 0; i < MaxCalls; ++i)
+			EXPECT_FALSE(
+				Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls, Later));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, MaxCalls, Later));
+	}
+
+	TEST(RateLimiter, KeepsClientsAndRoutesApart) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		for (int i = 0; i < MaxCalls; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest/1", Interval, MaxCalls, T0));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest/2?x=1", Interval, MaxCalls, T0));
+		EXPECT_FALSE(Limiter->IsRateLimited("other", "/api/v1/unittest/1", Interval, MaxCalls, T0));
+		EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittestother", Interval, MaxCalls, T0));
+	}
+
+	TEST(RateLimiter, KeepsEachHandlersDefaultRate) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, 1, T0));
+		EXPECT_TRUE(Limiter->IsRateLimited("client", "/api/v1/unittest", Interval, 1, T0 + 1));
+		for (int i = 0; i < MaxCalls; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("other", "/api/v1/unittest", Interval, MaxCalls, T0));
+	}
+
+	TEST(RateLimiter, KeepsAtMostMaxClientsBuckets) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		Limiter->Start();
+		//	Every client still has calls pending: none of the buckets is full again.
+		for (int i = 0; i < 20000; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("client" + std::to_string(i), "/api/v1/unittest",
+												Interval, MaxCalls, T0));
+		EXPECT_LE(Limiter->Clients(), 16384u);
+		for (int i = 0; i < MaxCalls; ++i)
+			Limiter->IsRateLimited("busy", "/api/v1/unittest", Interval, MaxCalls, T0);
+		EXPECT_TRUE(Limiter->IsRateLimited("busy", "/api/v1/unittest", Interval, MaxCalls, T0));
+		Limiter->Clear();
+	}
+
+	TEST(RateLimiter, NoLimitWithoutARate) {
+		auto Limiter = RESTAPI_RateLimiter();
+		Limiter->Clear();
+		for (int i = 0; i < 100; ++i)
+			EXPECT_FALSE(Limiter->IsRateLimited("client", "/api/v1/unittest", 0, 0, T0));
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,78 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include "gtest/gtest.h"
+
+#include "RESTAPI/RESTAPI_inventory_handler.h"
+#include "RESTAPI/RESTAPI_inventory_list_handler.h"
+#include "RESTAPI/RESTAPI_openroaming_gr_cert_handler.h"
+#include "RESTAPI/RESTAPI_openroaming_gr_list_certificates.h"
+#include "RESTAPI/RESTAPI_venue_handler.h"
+#include "RESTAPI/RESTAPI_venue_list_handler.h"
+#include "framework/RESTAPI_RouteTrie.h"
+
+namespace OpenWifi {
+
+	static const RESTAPI_RouteTrie &Trie() {
+		static const auto Trie =
+			RESTAPI_RouteTrie::Build<RESTAPI_inventory_handler, RESTAPI_inventory_list_handler,
+									 RESTAPI_venue_handler, RESTAPI_venue_list_handler,
+									 RESTAPI_openroaming_gr_cert_handler,
+									 RESTAPI_openroaming_gr_list_certificates>();
+		return Trie;
+	}
+
+	TEST(RouteTrie, MatchesLiteralEndPoints) {
+		RESTAPIHandler::BindingMap Bindings;
+		auto R = Trie().Find("/api/v1/inventory", Bindings);
+		ASSERT_NE(R, nullptr);
+		EXPECT_EQ(R->EndPoint, "/api/v1/inventory");
+		EXPECT_EQ(R->Resource, RESTAPIHandler::GetResourceName(R->EndPoint));
+		EXPECT_TRUE(Bindings.empty());
+	}
+
+	TEST(RouteTrie, BindsParametersInLowerCase) {
+		RESTAPIHandler::BindingMap Bindings;
+		auto R = Trie().Find("/api/v1/inventory/AABBCCDDEEFF", Bindings);
+		ASSERT_NE(R, nullptr);
+		EXPECT_EQ(R->EndPoint, "/api/v1/inventory/{serialNumber}");
+		ASSERT_EQ(Bindings.size(), 1u);
+		EXPECT_EQ(Bindings["serialnumber"], "AABBCCDDEEFF");
+	}
+
+	TEST(RouteTrie, BindsSeveralParameters) {
+		RESTAPIHandler::BindingMap Bindings;
+		auto R = Trie().Find("/api/v1/openroaming/globalreach/certificate/acct-1/cert-2", Bindings);
+		ASSERT_NE(R, nullptr);
+		EXPECT_EQ(R->EndPoint, "/api/v1/openroaming/globalreach/certificate/{account}/{id}");
+		EXPECT_EQ(Bindings["account"], "acct-1");
+		EXPECT_EQ(Bindings["id"], "cert-2");
+
+		R = Trie().Find("/api/v1/openroaming/globalreach/certificates/acct-1", Bindings);
+		ASSERT_NE(R, nullptr);
+		EXPECT_EQ(R->EndPoint, "/api/v1/openroaming/globalreach/certificates/{account}");
+		ASSERT_EQ(Bindings.size(), 1u);
+		EXPECT_EQ(Bindings["account"], "acct-1");
+	}
+
+	TEST(RouteTrie, RejectsUnknownPaths) {
+		RESTAPIHandler::BindingMap Bindings;
+		EXPECT_EQ(Trie().Find("/api/v1/inventory/AABBCCDDEEFF/extra", Bindings), nullptr);
+		EXPECT_EQ(Trie().Find("/api/v1/unknown", Bindings), nullptr);
+		EXPECT_EQ(Trie().Find("/api/v2/venue", Bindings), nullptr);
+		EXPECT_EQ(Trie().Find("", Bindings), nullptr);
+		EXPECT_TRUE(Bindings.empty());
+	}
+
+	TEST(RouteTrie, ClearsBindingsOfThePreviousMatch) {
+		RESTAPIHandler::BindingMap Bindings;
+		ASSERT_NE(Trie().Find("/api/v1/venue/v-1", Bindings), nullptr);
+		EXPECT_EQ(Bindings["uuid"], "v-1");
+		auto R = Trie().Find("/api/v1/venue", Bindings);
+		ASSERT_NE(R, nullptr);
+		EXPECT_EQ(R->EndPoint, "/api/v1/venue");
+		EXPECT_TRUE(Bindings.empty());
+	}
+
+} // namespace OpenWifi
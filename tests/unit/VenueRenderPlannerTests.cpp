@@ -0,0 +1,62 @@
+//
+// Created by stephane bourque on 2023-12-02.
+//
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "APConfig.h"
+#include "BenchEnvironment.h"
+#include "Daemon.h"
+#include "StorageService.h"
+#include "VenueRenderPlanner.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	static std::string Text(const Poco::JSON::Object::Ptr &O) {
+		std::ostringstream OS;
+		O->stringify(OS);
+		return OS.str();
+	}
+
+	TEST(VenueRenderPlanner, RendersWhatAPConfigGetReturns) {
+		const auto &Serials = Bench::Data().SerialNumbers;
+		ASSERT_GE(Serials.size(), 200u);
+
+		//	Overrides are applied per device, after the shared part.
+		ProvObjects::ConfigurationOverrideList Overrides;
+		Overrides.serialNumber = Serials[0];
+		ProvObjects::ConfigurationOverride TxPower;
+		TxPower.source = "unittest";
+		TxPower.parameterName = "radios.0.tx-power";
+		TxPower.parameterValue = "7";
+		TxPower.modified = Utils::Now();
+		Overrides.overrides.emplace_back(TxPower);
+		ASSERT_TRUE(StorageService()->OverridesDB().CreateRecord(Overrides));
+
+		VenueRenderPlanner Planner(Daemon()->logger());
+		for (std::size_t i = 0; i < 200; ++i) {
+			ProvObjects::InventoryTag Device;
+			ASSERT_TRUE(
+				StorageService()->InventoryDB().GetRecord("serialNumber", Serials[i], Device));
+
+			APConfig Config(Device.serialNumber, Device.deviceType, Daemon()->logger());
+			auto Expected = Poco::makeShared<Poco::JSON::Object>();
+			auto Rendered = Poco::makeShared<Poco::JSON::Object>();
+			ASSERT_TRUE(Config.Get(Expected));
+			ASSERT_TRUE(Planner.Render(Device, Rendered));
+			EXPECT_EQ(Text(Rendered), Text(Expected)) << Device.serialNumber;
+			if (i == 0)
+				EXPECT_EQ(Rendered->getArray("radios")->getObject(0)->getValue<std::uint64_t>(
+							  "tx-power"),
+						  7u);
+		}
+		//	Every venue holds several of these devices, all of the same type.
+		EXPECT_EQ(Planner.Groups(), Bench::Data().Venues.size());
+
+		StorageService()->OverridesDB().DeleteRecord("serialNumber", Serials[0]);
+	}
+
+} // namespace OpenWifi
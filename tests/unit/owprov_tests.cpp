@@ -0,0 +1,23 @@
+//
+// Created by stephane bourque on 2023-11-20.
+//
+
+#include "gtest/gtest.h"
+
+#include "BenchEnvironment.h"
+
+namespace {
+
+	//	The tests share the benchmark data set: one unit of scale, in an in-memory database.
+	class Environment : public ::testing::Environment {
+	  public:
+		void SetUp() override { OpenWifi::Bench::Setup(1); }
+	};
+
+} // namespace
+
+int main(int argc, char **argv) {
+	::testing::InitGoogleTest(&argc, argv);
+	::testing::AddGlobalTestEnvironment(new Environment);
+	return RUN_ALL_TESTS();
+}